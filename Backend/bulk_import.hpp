@@ -0,0 +1,340 @@
+#ifndef BULK_IMPORT_HPP
+#define BULK_IMPORT_HPP
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <charconv>
+#include <algorithm>
+#include <cstring>
+#include <cstdint>
+#include "customer_json.hpp"
+#include "task_pool.hpp"
+
+// Bulk customer import from CSV or NDJSON.
+//
+// The input is split into chunks of about 1 MB that end on line boundaries, and
+// the chunks are parsed on a TaskPool. Results are concatenated in input order,
+// so the output does not depend on the thread count. Every row and error carries
+// its 1-based line number.
+//
+// CSV: the first line is a header naming the columns (any order, case-insensitive,
+// extra columns ignored): id, name, averagePurchaseValue (or aov),
+// purchaseFrequency (or frequency), customerLifespan (or lifespan). Fields may be
+// quoted with "" as an escaped quote, but may not contain line breaks.
+// NDJSON: one customer object per line, with the same keys as customers.json.
+
+enum class ImportFormat { CSV, NDJSON };
+
+struct ImportRow {
+    CustomerRecord record;
+    size_t line;
+};
+
+struct ImportError {
+    size_t line;
+    std::string message;
+};
+
+struct ImportBatch {
+    std::vector<ImportRow> rows;
+    std::vector<ImportError> errors;
+};
+
+// "csv", "ndjson" or "jsonl"
+inline bool parseImportFormat(std::string_view name, ImportFormat& format) {
+    if (name == "csv") format = ImportFormat::CSV;
+    else if (name == "ndjson" || name == "jsonl") format = ImportFormat::NDJSON;
+    else return false;
+    return true;
+}
+
+// NDJSON if the first non-blank character opens an object, CSV otherwise
+inline ImportFormat detectImportFormat(const char* data, size_t size) {
+    for (size_t i = 0; i < size; i++) {
+        char c = data[i];
+        if (c == ' ' || c == '\t' || c == '\r' || c == '\n') continue;
+        return c == '{' ? ImportFormat::NDJSON : ImportFormat::CSV;
+    }
+    return ImportFormat::CSV;
+}
+
+namespace bulk_import_detail {
+
+struct CSVColumns {
+    int id = -1;
+    int name = -1;
+    int aov = -1;
+    int freq = -1;
+    int lifespan = -1;
+    int count = 0;
+};
+
+inline std::string_view trimmed(std::string_view text) {
+    while (!text.empty() && (text.front() == ' ' || text.front() == '\t')) text.remove_prefix(1);
+    while (!text.empty() && (text.back() == ' ' || text.back() == '\t' || text.back() == '\r')) text.remove_suffix(1);
+    return text;
+}
+
+// Split one CSV line into fields; quoted fields are unescaped into storage
+inline bool splitCSVLine(std::string_view line, std::vector<std::string_view>& fields,
+                         std::vector<std::string>& storage, std::string& error) {
+    fields.clear();
+    size_t used = 0;
+    size_t i = 0;
+    while (true) {
+        while (i < line.size() && (line[i] == ' ' || line[i] == '\t')) i++;
+        if (i < line.size() && line[i] == '"') {
+            if (used == storage.size()) storage.emplace_back();
+            std::string& value = storage[used++];
+            value.clear();
+            i++;
+            while (true) {
+                if (i >= line.size()) {
+                    error = "unterminated quoted field";
+                    return false;
+                }
+                if (line[i] == '"') {
+                    if (i + 1 < line.size() && line[i + 1] == '"') {
+                        value += '"';
+                        i += 2;
+                        continue;
+                    }
+                    i++;
+                    break;
+                }
+                value += line[i++];
+            }
+            while (i < line.size() && (line[i] == ' ' || line[i] == '\t' || line[i] == '\r')) i++;
+            fields.push_back(value);
+            if (i < line.size() && line[i] != ',') {
+                error = "unexpected text after a quoted field";
+                return false;
+            }
+        } else {
+            size_t end = line.find(',', i);
+            if (end == std::string_view::npos) end = line.size();
+            fields.push_back(trimmed(line.substr(i, end - i)));
+            i = end;
+        }
+        if (i >= line.size()) return true;
+        i++;  // Skip the comma
+    }
+}
+
+inline bool parseNumber(std::string_view text, double& value) {
+    text = trimmed(text);
+    if (!text.empty() && text.front() == '+') text.remove_prefix(1);
+    if (text.empty()) return false;
+    auto result = std::from_chars(text.data(), text.data() + text.size(), value);
+    return result.ec == std::errc() && result.ptr == text.data() + text.size();
+}
+
+inline bool equalsIgnoreCase(std::string_view a, std::string_view b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); i++) {
+        char x = a[i], y = b[i];
+        if (x >= 'A' && x <= 'Z') x += 'a' - 'A';
+        if (y >= 'A' && y <= 'Z') y += 'a' - 'A';
+        if (x != y) return false;
+    }
+    return true;
+}
+
+inline bool readCSVHeader(std::string_view line, CSVColumns& columns, std::string& error) {
+    std::vector<std::string_view> fields;
+    std::vector<std::string> storage;
+    if (!splitCSVLine(line, fields, storage, error)) return false;
+
+    for (size_t i = 0; i < fields.size(); i++) {
+        std::string_view field = fields[i];
+        int index = static_cast<int>(i);
+        if (equalsIgnoreCase(field, "id")) columns.id = index;
+        else if (equalsIgnoreCase(field, "name")) columns.name = index;
+        else if (equalsIgnoreCase(field, "averagePurchaseValue") || equalsIgnoreCase(field, "aov")) columns.aov = index;
+        else if (equalsIgnoreCase(field, "purchaseFrequency") || equalsIgnoreCase(field, "frequency")) columns.freq = index;
+        else if (equalsIgnoreCase(field, "customerLifespan") || equalsIgnoreCase(field, "lifespan")) columns.lifespan = index;
+    }
+    columns.count = static_cast<int>(fields.size());
+    if (columns.id < 0 || columns.name < 0 || columns.aov < 0 || columns.freq < 0 || columns.lifespan < 0) {
+        error = "CSV header must name id, name, averagePurchaseValue, purchaseFrequency and customerLifespan";
+        return false;
+    }
+    return true;
+}
+
+// Calls onLine(line, lineNumber) for every line in [begin, end); numbers start at 1.
+// Returns the number of lines.
+template<typename OnLine>
+size_t forEachLine(const char* begin, const char* end, OnLine onLine) {
+    size_t lineNumber = 0;
+    while (begin < end) {
+        const char* newline = static_cast<const char*>(std::memchr(begin, '\n', end - begin));
+        const char* lineEnd = newline ? newline : end;
+        onLine(std::string_view(begin, lineEnd - begin), ++lineNumber);
+        begin = newline ? newline + 1 : end;
+    }
+    return lineNumber;
+}
+
+inline size_t parseCSVChunk(const char* begin, const char* end, const CSVColumns& columns, ImportBatch& out) {
+    std::vector<std::string_view> fields;
+    std::vector<std::string> storage;
+    std::string error;
+    return forEachLine(begin, end, [&](std::string_view line, size_t lineNumber) {
+        if (trimmed(line).empty()) return;
+        if (!splitCSVLine(line, fields, storage, error)) {
+            out.errors.push_back(ImportError{lineNumber, error});
+            return;
+        }
+        if (static_cast<int>(fields.size()) < columns.count) {
+            out.errors.push_back(ImportError{lineNumber, "expected " + std::to_string(columns.count) +
+                                                         " fields, found " + std::to_string(fields.size())});
+            return;
+        }
+
+        ImportRow row;
+        row.line = lineNumber;
+        row.record.id = std::string(fields[columns.id]);
+        row.record.name = std::string(fields[columns.name]);
+        if (!parseNumber(fields[columns.aov], row.record.averagePurchaseValue) ||
+            !parseNumber(fields[columns.freq], row.record.purchaseFrequency) ||
+            !parseNumber(fields[columns.lifespan], row.record.customerLifespan)) {
+            out.errors.push_back(ImportError{lineNumber, "metric fields must be numbers"});
+            return;
+        }
+        out.rows.push_back(std::move(row));
+    });
+}
+
+inline size_t parseNDJSONChunk(const char* begin, const char* end, ImportBatch& out) {
+    std::string scratch;
+    return forEachLine(begin, end, [&](std::string_view line, size_t lineNumber) {
+        if (trimmed(line).empty()) return;
+        JsonReader reader(line.data(), line.size());
+        ImportRow row;
+        row.line = lineNumber;
+        try {
+            if (reader.peek() != '{') {
+                out.errors.push_back(ImportError{lineNumber, "expected a customer object"});
+                return;
+            }
+            std::string problem = readCustomerObject(reader, scratch, row.record);
+            if (problem.empty() && !reader.atEnd()) problem = "unexpected text after the object";
+            if (!problem.empty()) {
+                out.errors.push_back(ImportError{lineNumber, problem});
+                return;
+            }
+        } catch (const JsonParseError& e) {
+            out.errors.push_back(ImportError{lineNumber, e.what()});
+            return;
+        }
+        out.rows.push_back(std::move(row));
+    });
+}
+
+} // namespace bulk_import_detail
+
+// Parse a CSV or NDJSON document in batches of about batchBytes of input, in
+// order: consume(ImportBatch&) gets each batch's rows and errors (file line
+// numbers) before the next batch is parsed, so callers can store the rows
+// without holding the whole parsed file. The chunks of a batch are parsed in
+// parallel on pool.
+template<typename Consume>
+inline void parseCustomersBulkBatches(const char* data, size_t size, ImportFormat format, TaskPool& pool,
+                                      size_t batchBytes, Consume consume) {
+    using namespace bulk_import_detail;
+
+    // Skip a UTF-8 byte order mark
+    if (size >= 3 && std::memcmp(data, "\xEF\xBB\xBF", 3) == 0) {
+        data += 3;
+        size -= 3;
+    }
+    const char* end = data + size;
+    const char* body = data;
+    size_t lineOffset = 0;
+
+    CSVColumns columns;
+    if (format == ImportFormat::CSV) {
+        // The header is the first non-blank line
+        while (body < end) {
+            const char* newline = static_cast<const char*>(std::memchr(body, '\n', end - body));
+            const char* lineEnd = newline ? newline : end;
+            std::string_view line(body, lineEnd - body);
+            body = newline ? newline + 1 : end;
+            lineOffset++;
+            if (trimmed(line).empty()) continue;
+
+            std::string error;
+            if (!readCSVHeader(line, columns, error)) {
+                ImportBatch batch;
+                batch.errors.push_back(ImportError{lineOffset, error});
+                consume(batch);
+                return;
+            }
+            break;
+        }
+        if (columns.count == 0) return;
+    }
+
+    // Chunks of about 1 MB, each ending just after a newline; the split depends
+    // only on the input, not on the pool size
+    const size_t CHUNK_BYTES = 1 << 20;
+    std::vector<const char*> bounds{body};
+    while (static_cast<size_t>(end - bounds.back()) > CHUNK_BYTES) {
+        const char* target = bounds.back() + CHUNK_BYTES;
+        const char* newline = static_cast<const char*>(std::memchr(target, '\n', end - target));
+        if (!newline) break;
+        bounds.push_back(newline + 1);
+    }
+    bounds.push_back(end);
+    size_t chunkCount = bounds.size() - 1;
+    size_t chunksPerBatch = std::max<size_t>(1, batchBytes / CHUNK_BYTES);
+
+    std::vector<ImportBatch> parts;
+    std::vector<size_t> lineCounts;
+    for (size_t batchStart = 0; batchStart < chunkCount; batchStart += chunksPerBatch) {
+        size_t batchChunks = std::min(chunksPerBatch, chunkCount - batchStart);
+        parts.assign(batchChunks, ImportBatch());
+        lineCounts.assign(batchChunks, 0);
+        pool.parallelFor(batchChunks, 1, [&](size_t first, size_t last) {
+            for (size_t c = first; c < last; c++) {
+                const char* chunkBegin = bounds[batchStart + c];
+                const char* chunkEnd = bounds[batchStart + c + 1];
+                lineCounts[c] = format == ImportFormat::CSV
+                    ? parseCSVChunk(chunkBegin, chunkEnd, columns, parts[c])
+                    : parseNDJSONChunk(chunkBegin, chunkEnd, parts[c]);
+            }
+        });
+
+        // Stitch the chunks together in order, turning chunk-relative line numbers into file lines
+        ImportBatch batch;
+        size_t totalRows = 0;
+        for (const auto& part : parts) totalRows += part.rows.size();
+        batch.rows.reserve(totalRows);
+        for (size_t c = 0; c < batchChunks; c++) {
+            for (auto& row : parts[c].rows) {
+                row.line += lineOffset;
+                batch.rows.push_back(std::move(row));
+            }
+            for (auto& error : parts[c].errors) {
+                error.line += lineOffset;
+                batch.errors.push_back(std::move(error));
+            }
+            lineOffset += lineCounts[c];
+        }
+        consume(batch);
+    }
+}
+
+// Parse a whole CSV or NDJSON document, chunks in parallel on pool
+inline ImportBatch parseCustomersBulk(const char* data, size_t size, ImportFormat format,
+                                      TaskPool& pool = TaskPool::shared()) {
+    ImportBatch result;
+    parseCustomersBulkBatches(data, size, format, pool, SIZE_MAX, [&result](ImportBatch& batch) {
+        result = std::move(batch);  // One batch covers the whole document
+    });
+    return result;
+}
+
+#endif // BULK_IMPORT_HPP
@@ -4,10 +4,37 @@
 #include <iostream>
 #include <vector>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <string_view>
+#include <optional>
+#include <set>
+#include <queue>
+#include <iterator>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <shared_mutex>
+#include <atomic>
+#include <condition_variable>
 #include <algorithm>
+#include <limits>
 #include <fstream>
 #include <sstream>
 #include <ctime>
+#include <cmath>
+#include <cstdio>
+#include "clv_kernels.hpp"
+#include "clv_models.hpp"
+#include "clv_montecarlo.hpp"
+#include "clv_scenarios.hpp"
+#include "clv_statistics.hpp"
+#include "customer_index.hpp"
+#include "customer_segments.hpp"
+#include "task_pool.hpp"
+#include "customer_json.hpp"
+#include "customer_journal.hpp"
+#include "customer_snapshot.hpp"
 
 using namespace std;
 
@@ -47,37 +74,1064 @@ struct Customer {
     }
 };
 
+// Aggregate CLV statistics over all customers
+struct CLVAnalytics {
+    size_t totalCustomers = 0;
+    double totalCLV = 0;
+    double averageCLV = 0;
+    double highestCLV = 0;
+    double lowestCLV = 0;
+    double varianceCLV = 0;           // Population variance
+    double standardDeviationCLV = 0;
+};
+
+// Approximate CLV percentiles and an exact log-scale histogram
+struct CLVDistribution {
+    size_t totalCustomers = 0;
+    vector<pair<double, double>> percentiles;  // (quantile in [0, 1], CLV)
+    vector<LogHistogram::Bucket> histogram;    // Non-empty buckets, ascending
+    size_t sketchItems = 0;                    // Values the quantile sketch retains
+};
+
+// Outcome of one what-if scenario; top customers carry their adjusted metrics and CLV
+struct ScenarioResult {
+    string name;
+    size_t affectedCustomers = 0;
+    double totalCLV = 0;
+    double averageCLV = 0;
+    vector<Customer> top;
+};
+
+struct ScenarioReport {
+    size_t totalCustomers = 0;
+    double baselineTotalCLV = 0;  // Same model, no changes (summed in the same order as the scenarios)
+    vector<ScenarioResult> scenarios;
+};
+
+// One CLV tier: the CLV range its cut points give it and its members' totals
+struct SegmentTier {
+    string name;
+    double lowerQuantile = 0;  // CLV quantile the tier starts at
+    double lowerCLV = 0;       // Inclusive; -infinity for the lowest tier
+    double upperCLV = 0;       // Exclusive; +infinity for the highest tier
+    size_t customers = 0;
+    double totalCLV = 0;
+    double averageCLV = 0;
+};
+
+// Every tier plus the RFM-style score grid
+struct SegmentOverview {
+    size_t totalCustomers = 0;
+    vector<SegmentTier> tiers;
+    size_t levels = 0;               // Scores run 1..levels
+    vector<double> scoreCuts[3];     // AOV, frequency, lifespan: lowest value of scores 2..levels
+    vector<size_t> cells;            // Customers per (AOV, frequency, lifespan) score, AOV-major
+};
+
+// Members of one segment query: totals over all of them, one page in table order
+struct SegmentPage {
+    size_t customers = 0;
+    double totalCLV = 0;
+    double averageCLV = 0;
+    vector<Customer> members;
+};
+
+// Orders a paged customer listing can use
+enum class CustomerSortKey { CLV, AOV, FREQUENCY, LIFESPAN, NAME };
+const size_t CUSTOMER_SORT_KEYS = 5;
+
+// One page of the customer listing: filters, order and where to start
+struct CustomerListQuery {
+    CustomerSortKey sort = CustomerSortKey::CLV;
+    bool descending = true;
+    double minCLV = -numeric_limits<double>::infinity();
+    double maxCLV = numeric_limits<double>::infinity();
+    double minAOV = -numeric_limits<double>::infinity();
+    double maxAOV = numeric_limits<double>::infinity();
+    double minFrequency = -numeric_limits<double>::infinity();
+    double maxFrequency = numeric_limits<double>::infinity();
+    double minLifespan = -numeric_limits<double>::infinity();
+    double maxLifespan = numeric_limits<double>::infinity();
+    string namePrefix;  // Case-insensitive (ASCII)
+    string cursor;      // nextCursor of the previous page; the page starts after it
+    size_t offset = 0;  // Matches to skip (after the cursor, if any)
+    size_t limit = 100;
+};
+
+// Where one customer stands in the CLV order; equal CLVs share a rank
+struct CustomerRank {
+    Customer customer;
+    size_t rank = 0;            // 1 + customers with a higher CLV
+    size_t totalCustomers = 0;
+    size_t tiedCustomers = 0;   // Other customers with exactly the same CLV
+    double percentile = 0;      // Share of customers with a lower CLV, in percent
+};
+
+struct CustomerPage {
+    vector<Customer> customers;
+    optional<size_t> total;  // All matches, when countable without a scan
+    string nextCursor;       // Empty on the last page
+};
+
+// Why adding or updating one customer was refused
+struct MutationFailure {
+    enum Reason { NONE, DUPLICATE_ID, NOT_FOUND, INVALID, JOURNAL } reason = NONE;
+    string message;  // Fit to show a user
+};
+
 // CLV Calculator class - demonstrates DSA algorithms
 class CLVCalculator {
 private:
-    vector<Customer> customers;
+    // Columnar customer storage (DSA: Structure of Arrays). Row i of every
+    // column belongs to the same customer; the metric columns are contiguous
+    // doubles so scans and CLV recomputation stream through memory.
+    vector<string> ids;
+    vector<string> names;
+    vector<double> aovColumn;       // Average Order Value (AOV)
+    vector<double> freqColumn;      // Purchases per year
+    vector<double> lifespanColumn;  // Customer lifespan in years
+    vector<double> clvColumn;       // Calculated CLV
+
+    unordered_map<string, size_t> idIndex;  // Customer ID -> row (DSA: Hash map)
+    atomic<unsigned long long> dataVersion{0};  // Bumped on every mutation of customers
+    RunningStatistics clvStats;  // CLV aggregates, updated on every mutation
+    DistributionTracker clvDistribution;  // Quantile sketch + histogram, updated on every mutation
+    mutex distributionMutex;              // Readers refresh the sketch under the shared table lock
+    SegmentIndex segments;                // CLV tier and RFM score bitmaps, updated on every mutation
+    OrderedRowIndex sortIndexes[CUSTOMER_SORT_KEYS];  // Rows by each CustomerSortKey (then ID), for paged listings
+    bool sortIndexReady[CUSTOMER_SORT_KEYS] = {};     // Built on first use, then maintained on every mutation
+    mutex sortIndexMutex;                             // Readers build missing indexes under the shared table lock
+    mutex segmentsMutex;                  // Readers re-cut stale segments under the shared table lock
+    TaskPool* taskPool = &TaskPool::shared();  // Runs the whole-table loops in parallel
+    CLVModel clvModel;                         // Formula behind clvColumn (recomputeAll switches it)
+
+    // Readers-writer lock over the table: lookups, listings and analytics share it,
+    // mutations take it exclusively. Private helpers assume it is already held.
+    mutable shared_mutex tableMutex;
+    atomic<bool> verbose{true};          // Print a message per added customer
 
-    // Quicksort partition function (DSA Algorithm)
-    int partition(vector<Customer>& arr, int low, int high) {
-        double pivot = arr[high].clv;
-        int i = low - 1;
+    // Append a customer as a new row (caller has validated it)
+    void appendRow(string id, string name, double aov, double freq, double lifespan) {
+        idIndex.emplace(id, ids.size());
+        ids.push_back(std::move(id));
+        names.push_back(std::move(name));
+        aovColumn.push_back(aov);
+        freqColumn.push_back(freq);
+        lifespanColumn.push_back(lifespan);
+        clvColumn.push_back(clvModel.value(aov, freq, lifespan));
+    }
+
+    // Whole-table aggregates, built per chunk on the task pool and merged in chunk
+    // order, so the result does not depend on the number of threads. The value
+    // multiset that keeps min/max exact across removals is built once at the end.
+    void rebuildStatistics() {
+        clvStats = taskPool->parallelReduce(clvColumn.size(), TaskPool::DEFAULT_GRAIN, RunningStatistics(false),
+            [this](size_t begin, size_t end) {
+                RunningStatistics part(false);
+                part.rebuild(clvColumn.data() + begin, end - begin);
+                return part;
+            },
+            [](RunningStatistics total, const RunningStatistics& part) {
+                total.combine(part);
+                return total;
+            });
+        clvStats.trackValues(clvColumn.data(), clvColumn.size());
+    }
+
+    void rebuildDistribution() {
+        clvDistribution = taskPool->parallelReduce(clvColumn.size(), TaskPool::DEFAULT_GRAIN, DistributionTracker(),
+            [this](size_t begin, size_t end) {
+                DistributionTracker part;
+                part.rebuild(clvColumn.data() + begin, end - begin);
+                return part;
+            },
+            [](DistributionTracker total, const DistributionTracker& part) {
+                total.merge(part);
+                return total;
+            });
+    }
+
+    // Sum, min and max of a column (SIMD kernel per chunk)
+    static clv_kernels::ColumnSummary summarizeColumn(TaskPool& pool, const vector<double>& column) {
+        clv_kernels::ColumnSummary identity{0.0, numeric_limits<double>::infinity(), -numeric_limits<double>::infinity()};
+        return pool.parallelReduce(column.size(), TaskPool::DEFAULT_GRAIN, identity,
+            [&column](size_t begin, size_t end) {
+                return clv_kernels::summarize(column.data() + begin, end - begin);
+            },
+            [](clv_kernels::ColumnSummary total, const clv_kernels::ColumnSummary& part) {
+                total.sum += part.sum;
+                total.min = min(total.min, part.min);
+                total.max = max(total.max, part.max);
+                return total;
+            });
+    }
+
+    void rebuildSegments() {
+        segments.rebuild(*taskPool, clvColumn.data(), aovColumn.data(), freqColumn.data(),
+                         lifespanColumn.data(), clvColumn.size());
+    }
 
-        for (int j = low; j < high; j++) {
-            if (arr[j].clv > pivot) {  // Sort by CLV descending (highest first)
-                i++;
-                swap(arr[i], arr[j]);
+    // Everything derived from the metric and CLV columns (never touches ids or names)
+    void rebuildAggregates() {
+        rebuildStatistics();
+        rebuildDistribution();
+        rebuildSegments();
+        dropSortIndexes();
+    }
+
+    double sortValue(CustomerSortKey key, size_t row) const {
+        switch (key) {
+            case CustomerSortKey::AOV: return aovColumn[row];
+            case CustomerSortKey::FREQUENCY: return freqColumn[row];
+            case CustomerSortKey::LIFESPAN: return lifespanColumn[row];
+            default: return clvColumn[row];
+        }
+    }
+
+    // ASCII lower case (not the locale's: the name index must not change order at runtime)
+    static unsigned char foldCase(char c) {
+        unsigned char byte = static_cast<unsigned char>(c);
+        return byte >= 'A' && byte <= 'Z' ? byte + ('a' - 'A') : byte;
+    }
+
+    // Byte order with ASCII letters folded to lower case
+    static int compareFolded(const string& a, const string& b) {
+        size_t n = min(a.size(), b.size());
+        for (size_t i = 0; i < n; i++) {
+            unsigned char x = foldCase(a[i]), y = foldCase(b[i]);
+            if (x != y) return x < y ? -1 : 1;
+        }
+        return a.size() == b.size() ? 0 : (a.size() < b.size() ? -1 : 1);
+    }
+
+    static bool hasFoldedPrefix(const string& text, const string& prefix) {
+        if (text.size() < prefix.size()) return false;
+        for (size_t i = 0; i < prefix.size(); i++) {
+            if (foldCase(text[i]) != foldCase(prefix[i])) return false;
+        }
+        return true;
+    }
+
+    // Sort order of the listing indexes: the key (names folded), then ID. Equal
+    // metrics are held in descending ID order, so the default highest-first walk
+    // (backwards) lists them by ascending ID - the same order as the leaderboard
+    // and top lists. Names read A-Z by default, so equal names keep ascending IDs.
+    bool rowBefore(CustomerSortKey key, size_t a, size_t b) const {
+        if (key == CustomerSortKey::NAME) {
+            int order = compareFolded(names[a], names[b]);
+            if (order != 0) return order < 0;
+            return ids[a] < ids[b];
+        }
+        if (sortValue(key, a) != sortValue(key, b)) {
+            return sortValue(key, a) < sortValue(key, b);
+        }
+        return ids[a] > ids[b];
+    }
+
+    auto sortOrder(CustomerSortKey key) const {
+        return [this, key](uint32_t a, uint32_t b) { return rowBefore(key, a, b); };
+    }
+
+    void buildSortIndex(CustomerSortKey key) {
+        vector<uint32_t> rows(ids.size());
+        for (size_t row = 0; row < rows.size(); row++) rows[row] = static_cast<uint32_t>(row);
+        if (key == CustomerSortKey::NAME) {
+            // Sort on the first 8 folded bytes packed big-endian (same order as far as
+            // they go), comparing whole names only when those tie
+            vector<pair<uint64_t, uint32_t>> entries(rows.size());
+            for (size_t row = 0; row < rows.size(); row++) {
+                uint64_t packed = 0;
+                for (size_t i = 0; i < 8; i++) {
+                    packed = (packed << 8) | (i < names[row].size() ? foldCase(names[row][i]) : 0);
+                }
+                entries[row] = make_pair(packed, rows[row]);
             }
+            sort(entries.begin(), entries.end(), [this](const pair<uint64_t, uint32_t>& a, const pair<uint64_t, uint32_t>& b) {
+                if (a.first != b.first) return a.first < b.first;
+                return rowBefore(CustomerSortKey::NAME, a.second, b.second);
+            });
+            for (size_t i = 0; i < rows.size(); i++) rows[i] = entries[i].second;
+        } else {
+            // Sort (value, row) pairs so most comparisons don't touch the columns
+            vector<pair<double, uint32_t>> entries(rows.size());
+            for (size_t row = 0; row < rows.size(); row++) entries[row] = make_pair(sortValue(key, row), rows[row]);
+            sort(entries.begin(), entries.end(), [this](const pair<double, uint32_t>& a, const pair<double, uint32_t>& b) {
+                if (a.first != b.first) return a.first < b.first;
+                return ids[a.second] > ids[b.second];
+            });
+            for (size_t i = 0; i < rows.size(); i++) rows[i] = entries[i].second;
+        }
+        sortIndexes[static_cast<size_t>(key)].assign(rows);
+        sortIndexReady[static_cast<size_t>(key)] = true;
+    }
+
+    void dropSortIndexes() {
+        for (size_t k = 0; k < CUSTOMER_SORT_KEYS; k++) {
+            sortIndexes[k].clear();
+            sortIndexReady[k] = false;
         }
-        swap(arr[i + 1], arr[high]);
-        return i + 1;
     }
 
-    // Quicksort implementation (DSA Algorithm)
-    void quicksort(vector<Customer>& arr, int low, int high) {
-        if (low < high) {
-            int pi = partition(arr, low, high);
-            quicksort(arr, low, pi - 1);
-            quicksort(arr, pi + 1, high);
+    // Listing cursor: sort key, direction, the last row's key and ID, hex-encoded so
+    // it is opaque and URL-safe
+    string encodeCursor(CustomerSortKey key, bool descending, size_t row) const {
+        string keyText;
+        if (key == CustomerSortKey::NAME) {
+            keyText = names[row];
+        } else {
+            char number[32];
+            snprintf(number, sizeof(number), "%.17g", sortValue(key, row));
+            keyText = number;
+        }
+        string raw = to_string(static_cast<int>(key)) + (descending ? "d" : "a") +
+                     to_string(keyText.size()) + ":" + keyText + ids[row];
+        static const char HEX[] = "0123456789abcdef";
+        string cursor;
+        for (unsigned char c : raw) {
+            cursor += HEX[c >> 4];
+            cursor += HEX[c & 15];
+        }
+        return cursor;
+    }
+
+    static bool decodeCursor(const string& cursor, CustomerSortKey key, bool descending,
+                             string& keyText, string& id) {
+        auto hexValue = [](char c) {
+            if (c >= '0' && c <= '9') return c - '0';
+            if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+            return -1;
+        };
+        if (cursor.size() % 2 != 0) return false;
+        string raw;
+        for (size_t i = 0; i < cursor.size(); i += 2) {
+            int high = hexValue(cursor[i]), low = hexValue(cursor[i + 1]);
+            if (high < 0 || low < 0) return false;
+            raw += static_cast<char>(high * 16 + low);
+        }
+        string prefix = to_string(static_cast<int>(key)) + (descending ? "d" : "a");
+        if (raw.compare(0, prefix.size(), prefix) != 0) return false;
+        size_t colon = raw.find(':', prefix.size());
+        if (colon == string::npos || colon == prefix.size()) return false;
+        size_t length = 0;
+        for (size_t i = prefix.size(); i < colon; i++) {
+            if (!isdigit(static_cast<unsigned char>(raw[i]))) return false;
+            length = length * 10 + (raw[i] - '0');
+            if (length > raw.size()) return false;
+        }
+        if (colon + 1 + length > raw.size()) return false;
+        keyText = raw.substr(colon + 1, length);
+        id = raw.substr(colon + 1 + length);
+        return true;
+    }
+
+    // The listing index of key, built first if needed (under the shared table lock)
+    const OrderedRowIndex& readySortIndex(CustomerSortKey key) {
+        lock_guard<mutex> indexLock(sortIndexMutex);
+        if (!sortIndexReady[static_cast<size_t>(key)]) buildSortIndex(key);
+        return sortIndexes[static_cast<size_t>(key)];
+    }
+
+    // Positions in the CLV index: customers with CLV below value, and at most value
+    size_t countCLVBelow(const OrderedRowIndex& index, double value) const {
+        return index.lowerBound([&](uint32_t row) { return clvColumn[row] < value; });
+    }
+
+    size_t countCLVAtMost(const OrderedRowIndex& index, double value) const {
+        return index.lowerBound([&](uint32_t row) { return clvColumn[row] <= value; });
+    }
+
+    // Add a row to the built listing indexes (its values are in the columns)
+    void indexRow(size_t row) {
+        for (size_t k = 0; k < CUSTOMER_SORT_KEYS; k++) {
+            if (sortIndexReady[k]) sortIndexes[k].insert(row, sortOrder(static_cast<CustomerSortKey>(k)));
         }
     }
 
-    // Simple JSON helper functions
-    string escapeString(const string& str) {
+    // Take a row out of the built listing indexes (before its values change)
+    void unindexRow(size_t row) {
+        for (size_t k = 0; k < CUSTOMER_SORT_KEYS; k++) {
+            if (sortIndexReady[k]) sortIndexes[k].erase(row, sortOrder(static_cast<CustomerSortKey>(k)));
+        }
+    }
+
+    // Row `from` is about to be moved to `to` (still at `from` in the columns)
+    void renumberRow(size_t from, size_t to) {
+        for (size_t k = 0; k < CUSTOMER_SORT_KEYS; k++) {
+            if (sortIndexReady[k]) sortIndexes[k].renumber(from, to, sortOrder(static_cast<CustomerSortKey>(k)));
+        }
+    }
+
+    // Index a newly appended row in the segment bitmaps
+    void addToSegments(size_t row) {
+        segments.add(row, clvColumn[row], aovColumn[row], freqColumn[row], lifespanColumn[row]);
+    }
+
+    // Materialize one row as a Customer
+    Customer rowAt(size_t row) const {
+        Customer customer(ids[row], names[row], aovColumn[row], freqColumn[row], lifespanColumn[row]);
+        customer.clv = clvColumn[row];
+        return customer;
+    }
+
+    // The same row valued by another model
+    Customer rowAt(size_t row, const CLVModel& model) const {
+        Customer customer(ids[row], names[row], aovColumn[row], freqColumn[row], lifespanColumn[row]);
+        customer.clv = model.value(aovColumn[row], freqColumn[row], lifespanColumn[row]);
+        return customer;
+    }
+
+    // Evaluate model over the metric columns into out (sized to the table), on the task pool
+    void evaluateModel(const CLVModel& model, vector<double>& out) const {
+        out.resize(aovColumn.size());
+        taskPool->parallelFor(out.size(), [&](size_t begin, size_t end) {
+            model.evaluate(aovColumn.data() + begin, freqColumn.data() + begin,
+                           lifespanColumn.data() + begin, out.data() + begin, end - begin);
+        });
+    }
+
+    void reserveRows(size_t count) {
+        ids.reserve(count);
+        names.reserve(count);
+        aovColumn.reserve(count);
+        freqColumn.reserve(count);
+        lifespanColumn.reserve(count);
+        clvColumn.reserve(count);
+        idIndex.reserve(count);
+    }
+
+    void clearRows() {
+        ids.clear();
+        names.clear();
+        aovColumn.clear();
+        freqColumn.clear();
+        lifespanColumn.clear();
+        clvColumn.clear();
+        idIndex.clear();
+        clvStats.clear();
+        clvDistribution.clear();
+        segments.clear();
+        dropSortIndexes();
+    }
+
+    // Live top-K leaderboard (optional), ordered by CLV descending then ID
+    struct LeaderboardOrder {
+        bool operator()(const pair<double, string>& a, const pair<double, string>& b) const {
+            if (a.first != b.first) return a.first > b.first;
+            return a.second < b.second;
+        }
+    };
+    set<pair<double, string>, LeaderboardOrder> leaderboard;
+    size_t leaderboardSize = 0;      // 0 = disabled
+    bool leaderboardStale = false;   // A member dropped out; rebuild on next read
+    mutex leaderboardMutex;          // Readers rebuild a stale board under the shared table lock
+
+    // Keep the leaderboard current after a row gained or changed its CLV
+    void offerToLeaderboard(size_t row) {
+        if (leaderboardSize == 0 || leaderboardStale) return;
+        leaderboard.emplace(clvColumn[row], ids[row]);
+        if (leaderboard.size() > leaderboardSize) {
+            leaderboard.erase(prev(leaderboard.end()));
+        }
+    }
+
+    // A row is about to lose its current CLV (update or removal)
+    void withdrawFromLeaderboard(size_t row) {
+        if (leaderboardSize == 0 || leaderboardStale) return;
+        if (leaderboard.erase(make_pair(clvColumn[row], ids[row])) > 0) {
+            // Its replacement may be any row outside the board
+            leaderboardStale = true;
+        }
+    }
+
+    void rebuildLeaderboard() {
+        leaderboard.clear();
+        for (size_t row : selectTopRows(leaderboardSize)) {
+            leaderboard.emplace(clvColumn[row], ids[row]);
+        }
+        leaderboardStale = false;
+    }
+
+    // Column copy handed to the background saver
+    struct SaveSnapshot {
+        string filename;
+        vector<string> ids;
+        vector<string> names;
+        vector<double> aov;
+        vector<double> freq;
+        vector<double> lifespan;
+        vector<double> clv;
+        CLVModel model;                    // Recorded in binary snapshots
+        bool binary = false;               // Binary snapshot instead of JSON
+        bool completesCompaction = false;  // Rotated journal is obsolete once this is written
+    };
+
+    string saveBuffer;  // Reused by saveToJSON so large saves don't reallocate
+    mutex saveBufferMutex;
+
+    // Background saver thread (DSA: producer/consumer with a single coalescing slot)
+    thread saverThread;
+    mutex saverMutex;
+    condition_variable saverWake;
+    condition_variable saverIdle;
+    unique_ptr<SaveSnapshot> pendingSave;
+    bool saveInProgress = false;
+    bool saverStopping = false;
+
+    // Write-ahead journal (optional). Mutations are appended to it instead of
+    // rewriting the snapshot; once it grows past compactThreshold it is rotated
+    // and folded into a fresh snapshot by the saver thread.
+    CustomerJournal journal;
+    string snapshotPath = "customers.json";
+    string journalPath;
+    uint64_t compactThreshold = 0;
+    bool compacting = false;  // Guarded by saverMutex; a rotated journal is waiting for its snapshot
+
+    // Stamp of the snapshot as we last wrote or loaded it, so a change watcher
+    // can tell our own writes from edits made outside the process
+    mutex snapshotStampMutex;
+    FileStamp snapshotStamp;
+
+    bool writeSnapshotFile(string& buffer, const string& filename, bool binary,
+                           const vector<string>& ids, const vector<string>& names,
+                           const vector<double>& aov, const vector<double>& freq,
+                           const vector<double>& lifespan, const vector<double>& clv, const CLVModel& model) {
+        lock_guard<mutex> lock(snapshotStampMutex);
+        bool saved = binary ? writeCustomersBinary(buffer, filename, ids, names, aov, freq, lifespan, clv, model)
+                            : writeCustomersJSON(*taskPool, buffer, filename, ids, names, aov, freq, lifespan, clv);
+        if (saved && filename == snapshotPath) {
+            snapshotStamp = statFile(filename);
+        }
+        return saved;
+    }
+
+    string rotatedJournalPath() const {
+        return journalPath + ".1";
+    }
+
+    // Why a record cannot be stored, or "" if it is valid (NaN metrics are rejected too)
+    static string recordProblem(const CustomerRecord& record) {
+        if (record.id.empty() || record.name.empty()) return "empty id or name";
+        for (double value : {record.averagePurchaseValue, record.purchaseFrequency, record.customerLifespan}) {
+            if (!(value > 0) || isinf(value)) return "values must be positive numbers";
+        }
+        return "";
+    }
+
+    static bool refuse(MutationFailure& failure, MutationFailure::Reason reason, const string& message) {
+        cout << "❌ Error: " << message << "!" << endl;
+        failure.reason = reason;
+        failure.message = message;
+        return false;
+    }
+
+    // Log mutations before applying them; no-op when journaling is off
+    bool journalMutation(const vector<JournalRecord>& records, uint64_t& ticket) {
+        ticket = 0;
+        if (!journal.isOpen() || records.empty()) return true;
+        if (!journal.write(records, ticket)) {
+            cout << "❌ Error: Could not write to journal " << journalPath << endl;
+            return false;
+        }
+        return true;
+    }
+
+    bool journalMutation(const JournalRecord& record, uint64_t& ticket) {
+        ticket = 0;
+        if (!journal.isOpen()) return true;
+        if (!journal.write(record, ticket)) {
+            cout << "❌ Error: Could not write to journal " << journalPath << endl;
+            return false;
+        }
+        return true;
+    }
+
+    static JournalRecord modelRecord(const CLVModel& model) {
+        JournalRecord record;
+        record.op = JournalRecord::SET_MODEL;
+        record.name = model.name();
+        record.modelMargin = model.params.margin;
+        record.modelDiscountRate = model.params.discountRate;
+        return record;
+    }
+
+    // Binary snapshots record the model in their header; JSON snapshots don't,
+    // so a journal restarted next to one begins with the active model
+    void journalModelForJSONSnapshot() {
+        if (isBinarySnapshotPath(snapshotPath)) return;
+        uint64_t ticket;
+        journalMutation(modelRecord(clvModel), ticket);
+    }
+
+    // Switch the stored CLVs to model (table lock held exclusively)
+    void applyModel(const CLVModel& model) {
+        clvModel = model;
+        evaluateModel(clvModel, clvColumn);
+        rebuildAggregates();
+        leaderboardStale = true;
+        dataVersion++;
+    }
+
+    // Fold the journal into the snapshot once it is large enough
+    void maybeCompact() {
+        if (!journal.isOpen() || compactThreshold == 0 || journal.size() < compactThreshold) return;
+        {
+            lock_guard<mutex> lock(saverMutex);
+            if (compacting) return;  // Previous rotation not folded in yet
+            compacting = true;
+        }
+        // Rotate and copy the table at the same point, so the snapshot holds
+        // exactly the rotated records and the fresh journal holds the rest
+        if (!journal.rotate(rotatedJournalPath())) {
+            cout << "⚠️  Could not rotate journal " << journalPath << endl;
+            lock_guard<mutex> lock(saverMutex);
+            compacting = false;
+            return;
+        }
+        journalModelForJSONSnapshot();
+        queueSave(snapshotPath, isBinarySnapshotPath(snapshotPath), true);
+    }
+
+    void queueSave(const string& filename, bool binary, bool completesCompaction) {
+        unique_ptr<SaveSnapshot> snapshot(new SaveSnapshot{filename, ids, names, aovColumn, freqColumn,
+                                                           lifespanColumn, clvColumn, clvModel, binary,
+                                                           completesCompaction});
+        {
+            lock_guard<mutex> lock(saverMutex);
+            // The newer copy supersedes the pending one, including its compaction duty
+            if (pendingSave && pendingSave->completesCompaction) {
+                snapshot->completesCompaction = true;
+            }
+            pendingSave = std::move(snapshot);
+            if (!saverThread.joinable()) {
+                saverThread = thread(&CLVCalculator::saverLoop, this);
+            }
+        }
+        saverWake.notify_one();
+    }
+
+    void saverLoop() {
+        string buffer;
+        unique_lock<mutex> lock(saverMutex);
+        while (true) {
+            saverWake.wait(lock, [this] { return saverStopping || pendingSave; });
+            if (!pendingSave) break;  // Stopping with nothing left to write
+
+            unique_ptr<SaveSnapshot> job = std::move(pendingSave);
+            saveInProgress = true;
+            lock.unlock();
+            bool saved = writeSnapshotFile(buffer, job->filename, job->binary, job->ids, job->names,
+                                           job->aov, job->freq, job->lifespan, job->clv, job->model);
+            bool compacted = saved && job->completesCompaction;
+            if (compacted) {
+                ::unlink(rotatedJournalPath().c_str());
+            }
+            job.reset();
+            lock.lock();
+            // On failure the rotated journal stays in place (and compacting stays set)
+            // so a restart still replays it
+            if (compacted) compacting = false;
+            saveInProgress = false;
+            saverIdle.notify_all();
+        }
+    }
+
+    // Format the table into buffer with to_chars and replace filename atomically.
+    // Chunks of rows are formatted in parallel and joined in order.
+    static bool writeCustomersJSON(TaskPool& pool, string& buffer, const string& filename,
+                                   const vector<string>& ids, const vector<string>& names,
+                                   const vector<double>& aov, const vector<double>& freq,
+                                   const vector<double>& lifespan, const vector<double>& clv) {
+        size_t count = ids.size();
+        const size_t ROWS_PER_CHUNK = 16384;
+        vector<string> chunks((count + ROWS_PER_CHUNK - 1) / ROWS_PER_CHUNK);
+        pool.parallelFor(count, ROWS_PER_CHUNK, [&](size_t begin, size_t end) {
+            string& out = chunks[begin / ROWS_PER_CHUNK];
+            out.reserve((end - begin) * 200);
+            for (size_t i = begin; i < end; i++) {
+                out += "    {\n      \"id\": ";
+                appendJSONString(out, ids[i]);
+                out += ",\n      \"name\": ";
+                appendJSONString(out, names[i]);
+                out += ",\n      \"averagePurchaseValue\": ";
+                appendJSONNumber(out, aov[i]);
+                out += ",\n      \"purchaseFrequency\": ";
+                appendJSONNumber(out, freq[i]);
+                out += ",\n      \"customerLifespan\": ";
+                appendJSONNumber(out, lifespan[i]);
+                out += ",\n      \"clv\": ";
+                appendJSONNumber(out, clv[i]);
+                out += i + 1 < count ? "\n    },\n" : "\n    }\n";
+            }
+        });
+
+        size_t total = 256;
+        for (const auto& chunk : chunks) total += chunk.size();
+        buffer.clear();
+        buffer.reserve(total);
+        buffer += "{\n  \"customers\": [\n";
+        for (auto& chunk : chunks) {
+            buffer += chunk;
+            string().swap(chunk);
+        }
+        buffer += "  ],\n  \"totalCustomers\": ";
+        appendJSONNumber(buffer, count);
+        buffer += ",\n  \"averageCLV\": ";
+        appendJSONNumber(buffer, count == 0 ? 0.0 : summarizeColumn(pool, clv).sum / count);
+        buffer += ",\n  \"timestamp\": \"";
+        buffer += getCurrentTimestamp();
+        buffer += "\"\n}\n";
+
+        string error;
+        if (!writeFileAtomically(filename, buffer, error)) {
+            cout << "❌ Error: Could not save customers - " << error << endl;
+            return false;
+        }
+        cout << "💾 Saved " << count << " customers to " << filename << endl;
+        return true;
+    }
+
+    static bool writeCustomersBinary(string& buffer, const string& filename,
+                                     const vector<string>& ids, const vector<string>& names,
+                                     const vector<double>& aov, const vector<double>& freq,
+                                     const vector<double>& lifespan, const vector<double>& clv,
+                                     const CLVModel& model) {
+        string error;
+        if (!writeBinarySnapshot(buffer, filename, ids, names, aov, freq, lifespan, clv, model, error)) {
+            cout << "❌ Error: Could not save customers - " << error << endl;
+            return false;
+        }
+        cout << "💾 Saved " << ids.size() << " customers to " << filename << endl;
+        return true;
+    }
+
+    // Snapshots named *.json are JSON; anything else uses the binary format
+    static bool isBinarySnapshotPath(const string& path) {
+        return path.size() < 5 || path.compare(path.size() - 5, 5, ".json") != 0;
+    }
+
+    static string getCurrentTimestamp() {
+        time_t now = time(0);
+        char buf[80];
+        struct tm local;
+        localtime_r(&now, &local);
+        strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S", &local);
+        return string(buf);
+    }
+    // Rows of the n highest-CLV customers, highest first; ties by ascending ID, as on the leaderboard.
+    // Selects over (CLV, row) pairs without copying any Customer:
+    // a bounded min-heap for small n (O(N log n)), nth_element otherwise (O(N + n log n)).
+    vector<size_t> selectTopRows(size_t n) const {
+        return selectTopRows(clvColumn, n);
+    }
+
+    vector<size_t> selectTopRows(const vector<double>& values, size_t n) const {
+        size_t count = values.size();
+        n = min(n, count);
+        // "a ranks above b": higher CLV, or same CLV and lower ID
+        auto ranksAbove = [this](const pair<double, size_t>& a, const pair<double, size_t>& b) {
+            return a.first > b.first || (a.first == b.first && ids[a.second] < ids[b.second]);
+        };
+
+        vector<pair<double, size_t>> selected;
+        if (n == 0) {
+            // nothing to select
+        } else if (n <= 1024 && n * 16 <= count) {
+            // DSA: Bounded heap - the top of the heap is the weakest of the current best n.
+            // Each chunk keeps its own best n on the task pool; the overall best n are among them.
+            auto bestInRange = [&values, n, &ranksAbove](size_t begin, size_t end) {
+                priority_queue<pair<double, size_t>, vector<pair<double, size_t>>, decltype(ranksAbove)> heap(ranksAbove);
+                for (size_t row = begin; row < end; row++) {
+                    pair<double, size_t> candidate(values[row], row);
+                    if (heap.size() < n) {
+                        heap.push(candidate);
+                    } else if (ranksAbove(candidate, heap.top())) {
+                        heap.pop();
+                        heap.push(candidate);
+                    }
+                }
+                vector<pair<double, size_t>> best;
+                best.reserve(heap.size());
+                while (!heap.empty()) {
+                    best.push_back(heap.top());
+                    heap.pop();
+                }
+                return best;
+            };
+            selected = taskPool->parallelReduce(count, TaskPool::DEFAULT_GRAIN, vector<pair<double, size_t>>(), bestInRange,
+                [](vector<pair<double, size_t>> all, const vector<pair<double, size_t>>& part) {
+                    all.insert(all.end(), part.begin(), part.end());
+                    return all;
+                });
+            if (selected.size() > n) {
+                nth_element(selected.begin(), selected.begin() + (n - 1), selected.end(), ranksAbove);
+                selected.resize(n);
+            }
+        } else {
+            // DSA: Selection - partition the n best to the front, then sort just those
+            selected.reserve(count);
+            for (size_t row = 0; row < count; row++) {
+                selected.emplace_back(values[row], row);
+            }
+            nth_element(selected.begin(), selected.begin() + (n - 1), selected.end(), ranksAbove);
+            selected.resize(n);
+        }
+        sort(selected.begin(), selected.end(), ranksAbove);
+
+        vector<size_t> rows;
+        rows.reserve(selected.size());
+        for (const auto& entry : selected) {
+            rows.push_back(entry.second);
+        }
+        return rows;
+    }
+
+    // Replace the table with the customers in a JSON file or binary snapshot
+    // (tableMutex held exclusively). Returns false if the file exists but was not
+    // loaded in full: unreadable, rejected, a syntax error or skipped records.
+    // A missing file loads as an empty table.
+    bool loadRows(const string& filename, bool binary) {
+        if (filename == snapshotPath) {
+            lock_guard<mutex> lock(snapshotStampMutex);
+            snapshotStamp = statFile(filename);
+        }
+        if (binary) {
+            return loadBinaryRows(filename);
+        }
+
+        // Clear existing customers before loading to prevent duplicates
+        clearRows();
+        leaderboardStale = true;
+        dataVersion++;
+
+        MappedFile file;
+        if (!file.open(filename)) {
+            cout << "⚠️  Could not open " << filename << " - starting fresh!" << endl;
+            return statFile(filename).inode == 0;
+        }
+
+        // Saved records take ~200 bytes each; reserving avoids regrowing the columns and index
+        reserveRows(file.size() / 200 + 1);
+
+        vector<CustomerJSONError> errors;
+        bool complete = parseCustomersJSON(file.data(), file.size(), [this](CustomerRecord& record) -> string {
+            string problem = recordProblem(record);
+            if (!problem.empty()) return problem;
+            if (idIndex.count(record.id)) return "duplicate id '" + record.id + "'";
+            appendRow(std::move(record.id), std::move(record.name), record.averagePurchaseValue,
+                      record.purchaseFrequency, record.customerLifespan);
+            return "";
+        }, errors);
+
+        // Report malformed records with their position in the file
+        const size_t MAX_REPORTED = 10;
+        locateJSONErrors(file.data(), file.size(), errors, MAX_REPORTED);
+        for (size_t i = 0; i < errors.size() && i < MAX_REPORTED; i++) {
+            cout << "⚠️  " << filename << ":" << errors[i].line << ":" << errors[i].column
+                 << ": skipped customer - " << errors[i].message << endl;
+        }
+        if (errors.size() > MAX_REPORTED) {
+            cout << "⚠️  ... and " << (errors.size() - MAX_REPORTED) << " more malformed records" << endl;
+        }
+        if (!complete) {
+            cout << "⚠️  " << filename << " is not valid JSON - loaded the customers before the error" << endl;
+        }
+
+        rebuildAggregates();
+        cout << "📂 Loaded " << ids.size() << " customers from " << filename << endl;
+        return complete && errors.empty();
+    }
+
+    // Replace the table with a binary snapshot: the metric columns are copied
+    // straight out of the mapped file, only the strings are materialized
+    bool loadBinaryRows(const string& filename) {
+        clearRows();
+        leaderboardStale = true;
+        dataVersion++;
+
+        MappedSnapshot snapshot;
+        string error;
+        if (!snapshot.open(filename, error)) {
+            if (statFile(filename).inode == 0) {
+                cout << "⚠️  Could not open " << filename << " - starting fresh!" << endl;
+                return true;
+            }
+            cout << "⚠️  " << filename << ": " << error << " - starting fresh!" << endl;
+            return false;
+        }
+
+        size_t count = snapshot.rowCount();
+        reserveRows(count);
+        aovColumn.assign(snapshot.averagePurchaseValues(), snapshot.averagePurchaseValues() + count);
+        freqColumn.assign(snapshot.purchaseFrequencies(), snapshot.purchaseFrequencies() + count);
+        lifespanColumn.assign(snapshot.customerLifespans(), snapshot.customerLifespans() + count);
+        // The snapshot's model becomes the active one; CLVs are recomputed rather
+        // than copied, so they follow it
+        CLVModel stored;
+        if (snapshot.model(stored) && stored != clvModel) {
+            cout << "🧮 " << filename << " was saved with the " << stored.name() << " model - using it" << endl;
+            clvModel = stored;
+        }
+        evaluateModel(clvModel, clvColumn);
+
+        // Aggregates only need the CLV column; build them while the strings and index are filled in
+        thread aggregates([this] {
+            rebuildAggregates();
+        });
+        bool duplicate = false;
+        for (size_t row = 0; row < count; row++) {
+            if (!idIndex.emplace(string(snapshot.id(row)), row).second) {
+                cout << "⚠️  " << filename << ": duplicate id '" << snapshot.id(row) << "' - starting fresh!" << endl;
+                duplicate = true;
+                break;
+            }
+            ids.emplace_back(snapshot.id(row));
+            names.emplace_back(snapshot.name(row));
+        }
+        aggregates.join();
+        if (duplicate) {
+            clearRows();
+            return false;
+        }
+
+        cout << "📂 Loaded " << ids.size() << " customers from " << filename << endl;
+        return true;
+    }
+
+    // Mutations below expect tableMutex held exclusively. They log to the journal
+    // first and leave the ticket to wait on once the lock is released.
+    bool insertCustomer(const string& id, const string& name,
+                        double avgPurchaseValue, double purchaseFrequency, double lifespan,
+                        uint64_t& ticket, MutationFailure& failure) {
+        // Check for duplicate ID (DSA: O(1) hash lookup)
+        if (idIndex.count(id)) {
+            return refuse(failure, MutationFailure::DUPLICATE_ID, "Customer ID '" + id + "' already exists");
+        }
+
+        // Validate inputs (same rule as loads and imports, so every stored row reloads)
+        string problem = recordProblem(CustomerRecord{id, name, avgPurchaseValue, purchaseFrequency, lifespan});
+        if (!problem.empty()) {
+            return refuse(failure, MutationFailure::INVALID, problem);
+        }
+
+        if (!journalMutation(JournalRecord{JournalRecord::UPSERT, id, name,
+                                           avgPurchaseValue, purchaseFrequency, lifespan}, ticket)) {
+            failure.reason = MutationFailure::JOURNAL;
+            failure.message = "journal write failed";
+            return false;
+        }
+
+        // Store the new row (CLV calculated on append)
+        appendRow(id, name, avgPurchaseValue, purchaseFrequency, lifespan);
+        clvStats.add(clvColumn.back());
+        clvDistribution.add(clvColumn.back());
+        addToSegments(ids.size() - 1);
+        indexRow(ids.size() - 1);
+        offerToLeaderboard(ids.size() - 1);
+        dataVersion++;
+        maybeCompact();
+        return true;
+    }
+
+    bool replaceCustomer(const string& id, const string& name,
+                         double avgPurchaseValue, double purchaseFrequency, double lifespan,
+                         uint64_t& ticket, MutationFailure& failure) {
+        auto it = idIndex.find(id);
+        if (it == idIndex.end()) {
+            return refuse(failure, MutationFailure::NOT_FOUND, "Customer ID '" + id + "' not found");
+        }
+
+        string problem = recordProblem(CustomerRecord{id, name, avgPurchaseValue, purchaseFrequency, lifespan});
+        if (!problem.empty()) {
+            return refuse(failure, MutationFailure::INVALID, problem);
+        }
+
+        if (!journalMutation(JournalRecord{JournalRecord::UPSERT, id, name,
+                                           avgPurchaseValue, purchaseFrequency, lifespan}, ticket)) {
+            failure.reason = MutationFailure::JOURNAL;
+            failure.message = "journal write failed";
+            return false;
+        }
+
+        size_t row = it->second;
+        withdrawFromLeaderboard(row);
+        unindexRow(row);
+        names[row] = name;
+        aovColumn[row] = avgPurchaseValue;
+        freqColumn[row] = purchaseFrequency;
+        lifespanColumn[row] = lifespan;
+        double previousCLV = clvColumn[row];
+        clvColumn[row] = clvModel.value(avgPurchaseValue, purchaseFrequency, lifespan);
+        clvStats.replace(previousCLV, clvColumn[row]);
+        clvDistribution.replace(previousCLV, clvColumn[row]);
+        segments.update(row, previousCLV, clvColumn[row], avgPurchaseValue, purchaseFrequency, lifespan);
+        indexRow(row);
+        offerToLeaderboard(row);
+        dataVersion++;
+        maybeCompact();
+        return true;
+    }
+
+    // DSA: swap with last element and pop, O(1)
+    bool eraseCustomer(const string& id, uint64_t& ticket) {
+        auto it = idIndex.find(id);
+        if (it == idIndex.end()) {
+            return false;
+        }
+        JournalRecord record;
+        record.op = JournalRecord::REMOVE;
+        record.id = id;
+        if (!journalMutation(record, ticket)) {
+            return false;
+        }
+
+        size_t row = it->second;
+        size_t last = ids.size() - 1;
+        withdrawFromLeaderboard(row);
+        clvStats.remove(clvColumn[row]);
+        clvDistribution.remove(clvColumn[row]);
+        segments.remove(row, clvColumn[row]);
+        unindexRow(row);
+        idIndex.erase(it);
+        if (row != last) {
+            renumberRow(last, row);
+            ids[row] = std::move(ids[last]);
+            names[row] = std::move(names[last]);
+            aovColumn[row] = aovColumn[last];
+            freqColumn[row] = freqColumn[last];
+            lifespanColumn[row] = lifespanColumn[last];
+            clvColumn[row] = clvColumn[last];
+            idIndex[ids[row]] = row;
+        }
+        ids.pop_back();
+        names.pop_back();
+        aovColumn.pop_back();
+        freqColumn.pop_back();
+        lifespanColumn.pop_back();
+        clvColumn.pop_back();
+        dataVersion++;
+        maybeCompact();
+        return true;
+    }
+
+public:
+    CLVCalculator() = default;
+    CLVCalculator(const CLVCalculator&) = delete;
+    CLVCalculator& operator=(const CLVCalculator&) = delete;
+
+    // Finish any background save before going away
+    ~CLVCalculator() {
+        {
+            lock_guard<mutex> lock(saverMutex);
+            saverStopping = true;
+        }
+        saverWake.notify_all();
+        if (saverThread.joinable()) {
+            saverThread.join();
+        }
+    }
+
+    // Simple JSON helper function
+    static string escapeString(const string& str) {
         string escaped;
         for (char c : str) {
             if (c == '"' || c == '\\') {
@@ -88,230 +1142,814 @@ private:
         return escaped;
     }
 
-    string getCurrentTimestamp() {
-        time_t now = time(0);
-        char buf[80];
-        strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S", localtime(&now));
-        return string(buf);
+    // Add a new customer and calculate CLV immediately. On failure, says why
+    // in failure if given.
+    bool addCustomer(const string& id, const string& name,
+                     double avgPurchaseValue, double purchaseFrequency, double lifespan,
+                     MutationFailure* failure = nullptr) {
+        uint64_t ticket = 0;
+        double clv;
+        {
+            unique_lock<shared_mutex> lock(tableMutex);
+            MutationFailure refused;
+            if (!insertCustomer(id, name, avgPurchaseValue, purchaseFrequency, lifespan, ticket, refused)) {
+                if (failure) *failure = std::move(refused);
+                return false;
+            }
+            clv = clvColumn[idIndex.at(id)];
+        }
+        journal.waitDurable(ticket);
+
+        if (verbose) {
+            cout << "✅ Added customer: " << name << endl;
+            cout << "💰 CLV: ₹" << clv << endl;
+            cout << endl;
+        }
+        return true;
     }
 
-public:
-    // Add a new customer and calculate CLV immediately
-    void addCustomer(const string& id, const string& name,
-                     double avgPurchaseValue, double purchaseFrequency, double lifespan) {
+    // Add many customers under one lock and one journal write. Invalid records
+    // and ids that already exist (in the table or earlier in the batch) are
+    // skipped and reported in rejected as (index into records, reason).
+    // Strings are moved out of records. Returns the number added.
+    size_t addCustomersBatch(vector<CustomerRecord>& records, vector<pair<size_t, string>>& rejected) {
+        uint64_t ticket = 0;
+        size_t added = 0;
+        {
+            unique_lock<shared_mutex> lock(tableMutex);
+            vector<size_t> accepted;
+            accepted.reserve(records.size());
+            unordered_set<string_view> batchIds;
+            for (size_t i = 0; i < records.size(); i++) {
+                string problem = recordProblem(records[i]);
+                if (problem.empty() && (idIndex.count(records[i].id) || !batchIds.insert(records[i].id).second)) {
+                    problem = "duplicate id '" + records[i].id + "'";
+                }
+                if (problem.empty()) accepted.push_back(i);
+                else rejected.emplace_back(i, std::move(problem));
+            }
+            if (accepted.empty()) return 0;
+
+            vector<JournalRecord> entries;
+            if (journal.isOpen()) {
+                entries.reserve(accepted.size());
+                for (size_t i : accepted) {
+                    const CustomerRecord& record = records[i];
+                    entries.push_back(JournalRecord{JournalRecord::UPSERT, record.id, record.name,
+                                                    record.averagePurchaseValue, record.purchaseFrequency,
+                                                    record.customerLifespan});
+                }
+            }
+            if (!journalMutation(entries, ticket)) {
+                for (size_t i : accepted) rejected.emplace_back(i, "journal write failed");
+                sort(rejected.begin(), rejected.end());
+                return 0;
+            }
 
-        // Check for duplicate ID
-        for (const auto& customer : customers) {
-            if (customer.id == id) {
-                cout << "❌ Error: Customer ID '" << id << "' already exists!" << endl;
-                return;
+            // Grow geometrically so a stream of batches does not reallocate every time
+            size_t needed = ids.size() + accepted.size();
+            if (needed > ids.capacity()) reserveRows(max(needed, ids.size() * 2));
+            // A batch at least as large as the table is cheaper to fold in with one rebuild
+            bool rebuild = accepted.size() >= ids.size();
+            for (size_t i : accepted) {
+                CustomerRecord& record = records[i];
+                appendRow(std::move(record.id), std::move(record.name), record.averagePurchaseValue,
+                          record.purchaseFrequency, record.customerLifespan);
+                if (!rebuild) {
+                    clvStats.add(clvColumn.back());
+                    clvDistribution.add(clvColumn.back());
+                    addToSegments(ids.size() - 1);
+                    indexRow(ids.size() - 1);
+                    offerToLeaderboard(ids.size() - 1);
+                }
             }
+            if (rebuild) {
+                rebuildAggregates();
+                leaderboardStale = true;
+            }
+            added = accepted.size();
+            dataVersion++;
+            maybeCompact();
         }
+        journal.waitDurable(ticket);
 
-        // Validate inputs
-        if (avgPurchaseValue <= 0 || purchaseFrequency <= 0 || lifespan <= 0) {
-            cout << "❌ Error: All values must be positive!" << endl;
-            return;
+        if (verbose) {
+            cout << "✅ Imported " << added << " customers";
+            if (!rejected.empty()) cout << " (" << rejected.size() << " rejected)";
+            cout << endl;
         }
+        return added;
+    }
 
-        // Create new customer (CLV calculated in constructor)
-        Customer newCustomer(id, name, avgPurchaseValue, purchaseFrequency, lifespan);
-        customers.push_back(newCustomer);
+    // Find a customer by ID (DSA: O(1) hash lookup)
+    optional<Customer> findCustomer(const string& id) const {
+        shared_lock<shared_mutex> lock(tableMutex);
+        auto it = idIndex.find(id);
+        if (it == idIndex.end()) {
+            return nullopt;
+        }
+        return rowAt(it->second);
+    }
 
-        cout << "✅ Added customer: " << name << endl;
-        cout << "💰 CLV: ₹" << newCustomer.clv << endl;
-        cout << endl;
+    optional<Customer> findCustomer(const string& id, const CLVModel& model) const {
+        shared_lock<shared_mutex> lock(tableMutex);
+        auto it = idIndex.find(id);
+        if (it == idIndex.end()) {
+            return nullopt;
+        }
+        return rowAt(it->second, model);
+    }
+
+    // Replace an existing customer's details and recalculate CLV. On failure,
+    // says why in failure if given.
+    bool updateCustomer(const string& id, const string& name,
+                        double avgPurchaseValue, double purchaseFrequency, double lifespan,
+                        MutationFailure* failure = nullptr) {
+        uint64_t ticket = 0;
+        {
+            unique_lock<shared_mutex> lock(tableMutex);
+            MutationFailure refused;
+            if (!replaceCustomer(id, name, avgPurchaseValue, purchaseFrequency, lifespan, ticket, refused)) {
+                if (failure) *failure = std::move(refused);
+                return false;
+            }
+        }
+        journal.waitDurable(ticket);
+        return true;
+    }
+
+    // Remove a customer by ID
+    bool removeCustomer(const string& id) {
+        uint64_t ticket = 0;
+        {
+            unique_lock<shared_mutex> lock(tableMutex);
+            if (!eraseCustomer(id, ticket)) {
+                return false;
+            }
+        }
+        journal.waitDurable(ticket);
+        return true;
     }
 
     // Display all customers
     void displayAllCustomers() {
-        if (customers.empty()) {
+        shared_lock<shared_mutex> lock(tableMutex);
+        if (ids.empty()) {
             cout << "📭 No customers found." << endl;
             return;
         }
 
         cout << "=== All Customers ===" << endl;
-        cout << "Total customers: " << customers.size() << endl;
+        cout << "Total customers: " << ids.size() << endl;
         cout << endl;
 
-        for (const auto& customer : customers) {
-            customer.display();
+        for (size_t row = 0; row < ids.size(); row++) {
+            rowAt(row).display();
+        }
+    }
+
+    // Rows of the n highest-CLV customers, highest first; ties by ascending ID, as on the leaderboard.
+    // Row numbers are only meaningful until the next mutation.
+    vector<size_t> topCustomerRows(size_t n) const {
+        shared_lock<shared_mutex> lock(tableMutex);
+        return selectTopRows(n);
+    }
+
+    // Maintain a live top-k leaderboard that is updated as customers are added (0 disables it)
+    void enableLeaderboard(size_t k) {
+        unique_lock<shared_mutex> lock(tableMutex);
+        leaderboardSize = k;
+        leaderboard.clear();
+        leaderboardStale = k > 0;
+    }
+
+    // The n highest-CLV customers, highest first (served from the leaderboard when it covers n)
+    vector<Customer> getTopCustomers(size_t n) {
+        shared_lock<shared_mutex> lock(tableMutex);
+        vector<Customer> result;
+        if (leaderboardSize > 0 && n <= leaderboardSize) {
+            lock_guard<mutex> boardLock(leaderboardMutex);
+            if (leaderboardStale) rebuildLeaderboard();
+            for (const auto& entry : leaderboard) {
+                if (result.size() >= n) break;
+                result.push_back(rowAt(idIndex.at(entry.second)));
+            }
+            return result;
+        }
+
+        for (size_t row : selectTopRows(n)) {
+            result.push_back(rowAt(row));
+        }
+        return result;
+    }
+
+    // One page of customers in the query's order, from the sorted index of its sort key:
+    // the walk starts at the sort key's lower bound (or right after the cursor) and stops
+    // at its upper bound, so a page costs O(log N + page size). A name prefix bounds the
+    // walk when sorting by name; other filters are checked row by row on the way.
+    // Empty if the cursor was not issued for this sort key and direction.
+    optional<CustomerPage> listCustomers(const CustomerListQuery& query) {
+        shared_lock<shared_mutex> lock(tableMutex);
+        const CustomerSortKey key = query.sort;
+        const OrderedRowIndex& index = readySortIndex(key);
+
+        // Filters on each numeric key, indexed by CustomerSortKey
+        const double low[] = {query.minCLV, query.minAOV, query.minFrequency, query.minLifespan};
+        const double high[] = {query.maxCLV, query.maxAOV, query.maxFrequency, query.maxLifespan};
+        const bool byName = key == CustomerSortKey::NAME;
+        const string& prefix = query.namePrefix;
+
+        // [first, last): positions the sort key's own filter allows
+        size_t first, last;
+        if (byName) {
+            first = index.lowerBound([&](uint32_t row) { return compareFolded(names[row], prefix) < 0; });
+            last = prefix.empty() ? index.size() : index.lowerBound([&](uint32_t row) {
+                return compareFolded(names[row], prefix) < 0 || hasFoldedPrefix(names[row], prefix);
+            });
+        } else {
+            size_t k = static_cast<size_t>(key);
+            first = index.lowerBound([&](uint32_t row) { return sortValue(key, row) < low[k]; });
+            last = index.lowerBound([&](uint32_t row) { return !(sortValue(key, row) > high[k]); });
+        }
+        last = max(first, last);
+
+        // Filters the index range does not cover
+        bool residual = !byName && !prefix.empty();
+        for (size_t k = 0; k < 4; k++) {
+            if (k != static_cast<size_t>(key) && (low[k] > -numeric_limits<double>::infinity() ||
+                                                  high[k] < numeric_limits<double>::infinity())) {
+                residual = true;
+            }
+        }
+        auto matches = [&](size_t row) {
+            for (size_t k = 0; k < 4; k++) {
+                double value = sortValue(static_cast<CustomerSortKey>(k), row);
+                if (value < low[k] || value > high[k]) return false;
+            }
+            return prefix.empty() || hasFoldedPrefix(names[row], prefix);
+        };
+
+        CustomerPage page;
+        if (!residual) page.total = last - first;
+
+        // Narrow [first, last) to the rows after the cursor in walking order
+        if (!query.cursor.empty()) {
+            string keyText, id;
+            if (!decodeCursor(query.cursor, key, query.descending, keyText, id)) return nullopt;
+            double keyValue = 0;
+            if (!byName) {
+                char* end = nullptr;
+                keyValue = strtod(keyText.c_str(), &end);
+                if (end == keyText.c_str() || *end != '\0') return nullopt;
+            }
+            // Order of a row relative to the cursor's (key, ID)
+            auto compareToCursor = [&](uint32_t row) {
+                int order;
+                if (byName) {
+                    order = compareFolded(names[row], keyText);
+                } else {
+                    double value = sortValue(key, row);
+                    order = value < keyValue ? -1 : (value > keyValue ? 1 : 0);
+                }
+                if (order == 0) order = byName ? ids[row].compare(id) : id.compare(ids[row]);
+                return order;
+            };
+            if (query.descending) {
+                last = min(last, index.lowerBound([&](uint32_t row) { return compareToCursor(row) < 0; }));
+            } else {
+                first = max(first, index.lowerBound([&](uint32_t row) { return compareToCursor(row) <= 0; }));
+            }
+            last = max(first, last);
+        }
+
+        // Skip offset: by position when every row in range matches, otherwise while walking
+        size_t skip = query.offset;
+        if (!residual) {
+            size_t jump = min(skip, last - first);
+            if (query.descending) last -= jump; else first += jump;
+            skip -= jump;
+        }
+        if (first == last) return page;
+
+        size_t remaining = last - first;
+        size_t lastRow = 0;
+        bool more = false;
+        index.scan(query.descending ? last - 1 : first, !query.descending, [&](uint32_t row) {
+            if (remaining-- == 0) return false;
+            if (residual && !matches(row)) return true;
+            if (skip > 0) {
+                skip--;
+                return true;
+            }
+            if (page.customers.size() == query.limit) {
+                more = true;  // One more match exists: the page gets a cursor
+                return false;
+            }
+            page.customers.push_back(rowAt(row));
+            lastRow = row;
+            return true;
+        });
+        if (more && !page.customers.empty()) page.nextCursor = encodeCursor(key, query.descending, lastRow);
+        return page;
+    }
+
+    // Rank of a customer by CLV (1 = highest), from the CLV index in O(log N)
+    optional<CustomerRank> getCustomerRank(const string& id) {
+        shared_lock<shared_mutex> lock(tableMutex);
+        auto it = idIndex.find(id);
+        if (it == idIndex.end()) {
+            return nullopt;
         }
+        const OrderedRowIndex& index = readySortIndex(CustomerSortKey::CLV);
+        double clv = clvColumn[it->second];
+        size_t below = countCLVBelow(index, clv);
+        size_t higher = index.size() - countCLVAtMost(index, clv);
+
+        CustomerRank rank{rowAt(it->second)};
+        rank.rank = higher + 1;
+        rank.totalCustomers = index.size();
+        rank.tiedCustomers = index.size() - higher - below - 1;
+        rank.percentile = 100.0 * below / index.size();
+        return rank;
     }
 
-    // Sort and display top customers by CLV (DSA: Quicksort)
+    // Number of customers with CLV in [low, high] (0 when low > high), in O(log N)
+    size_t countCustomersInCLVRange(double low, double high) {
+        shared_lock<shared_mutex> lock(tableMutex);
+        const OrderedRowIndex& index = readySortIndex(CustomerSortKey::CLV);
+        size_t upper = countCLVAtMost(index, high);
+        size_t lower = countCLVBelow(index, low);
+        return upper > lower ? upper - lower : 0;
+    }
+
+    // The customer with the k-th highest CLV (k = 1 is the highest; equal CLVs in
+    // ascending ID order, as on the leaderboard), in O(log N)
+    optional<Customer> getKthHighestCLV(size_t k) {
+        shared_lock<shared_mutex> lock(tableMutex);
+        const OrderedRowIndex& index = readySortIndex(CustomerSortKey::CLV);
+        if (k == 0 || k > index.size()) {
+            return nullopt;
+        }
+        return rowAt(index.at(index.size() - k));
+    }
+
+    // Monte Carlo CLV bands (see clv_montecarlo.hpp): returns the interval of the
+    // portfolio total; perCustomer receives one interval per customer, in forEachCustomer order
+    CLVInterval simulateCLV(const MonteCarloSettings& settings, const CLVModel& model,
+                            vector<CLVInterval>* perCustomer = nullptr) const {
+        shared_lock<shared_mutex> lock(tableMutex);
+        return simulateCLVColumns(*taskPool, model, settings, ids.data(), aovColumn.data(), freqColumn.data(),
+                                  lifespanColumn.data(), ids.size(), perCustomer);
+    }
+
+    // One customer's band, drawn from the same random streams as in simulateCLV
+    optional<CLVInterval> simulateCustomer(const string& id, const MonteCarloSettings& settings,
+                                           const CLVModel& model) const {
+        shared_lock<shared_mutex> lock(tableMutex);
+        auto it = idIndex.find(id);
+        if (it == idIndex.end()) {
+            return nullopt;
+        }
+        size_t row = it->second;
+        vector<CLVInterval> interval;
+        simulateCLVColumns(*taskPool, model, settings, &ids[row], &aovColumn[row], &freqColumn[row],
+                           &lifespanColumn[row], 1, &interval);
+        return interval[0];
+    }
+
+    // Evaluate what-if scenarios in one fused scan, valued with model; stored data is not changed
+    ScenarioReport runScenarios(const vector<Scenario>& scenarios, const CLVModel& model, size_t topK) const {
+        shared_lock<shared_mutex> lock(tableMutex);
+        size_t count = ids.size();
+        vector<ScenarioOutcome> outcomes = evaluateScenarios(*taskPool, model, ids.data(), aovColumn.data(),
+                                                             freqColumn.data(), lifespanColumn.data(), count,
+                                                             scenarios, topK);
+        ScenarioReport report;
+        report.totalCustomers = count;
+        report.baselineTotalCLV = outcomes.back().totalCLV;
+        for (size_t s = 0; s < scenarios.size(); s++) {
+            const Scenario& scenario = scenarios[s];
+            ScenarioResult result;
+            result.name = scenario.name;
+            result.affectedCustomers = outcomes[s].affected;
+            result.totalCLV = outcomes[s].totalCLV;
+            result.averageCLV = count > 0 ? outcomes[s].totalCLV / count : 0;
+            for (const auto& entry : outcomes[s].top) {
+                Customer customer = rowAt(entry.second);
+                if (scenario.filter.matches(customer.averagePurchaseValue, customer.purchaseFrequency,
+                                            customer.customerLifespan)) {
+                    customer.averagePurchaseValue *= scenario.aovFactor;
+                    customer.purchaseFrequency *= scenario.frequencyFactor;
+                    customer.customerLifespan *= scenario.lifespanFactor;
+                }
+                customer.clv = entry.first;
+                result.top.push_back(customer);
+            }
+            report.scenarios.push_back(std::move(result));
+        }
+        return report;
+    }
+
+    // The n highest customers when valued by model (the stored CLVs are not changed)
+    vector<Customer> getTopCustomers(size_t n, const CLVModel& model) {
+        if (model == getModel()) return getTopCustomers(n);
+
+        shared_lock<shared_mutex> lock(tableMutex);
+        vector<double> values;
+        evaluateModel(model, values);
+        vector<Customer> result;
+        for (size_t row : selectTopRows(values, n)) {
+            result.push_back(rowAt(row, model));
+        }
+        return result;
+    }
+
+    // Display top customers by CLV (DSA: Heap-based top-K selection)
     void displayTopCustomers(int n = 5) {
-        if (customers.empty()) {
+        if (getCustomerCount() == 0) {
             cout << "📭 No customers found." << endl;
             return;
         }
 
-        // Create a copy for sorting (DSA: Vector copy)
-        vector<Customer> sortedCustomers = customers;
-
-        // Sort using quicksort (DSA Algorithm)
-        quicksort(sortedCustomers, 0, sortedCustomers.size() - 1);
-
-        // Limit to requested number
-        int displayCount = min(n, (int)sortedCustomers.size());
+        vector<Customer> topCustomers = getTopCustomers(n > 0 ? n : 0);
 
-        cout << "=== Top " << displayCount << " Customers by CLV ===" << endl;
-        for (int i = 0; i < displayCount; i++) {
-            cout << (i + 1) << ". " << sortedCustomers[i].name
-                      << " - CLV: ₹" << sortedCustomers[i].clv << endl;
+        cout << "=== Top " << topCustomers.size() << " Customers by CLV ===" << endl;
+        for (size_t i = 0; i < topCustomers.size(); i++) {
+            cout << (i + 1) << ". " << topCustomers[i].name
+                      << " - CLV: ₹" << topCustomers[i].clv << endl;
         }
         cout << endl;
     }
 
     // Calculate and display analytics
     void displayAnalytics() {
-        if (customers.empty()) {
+        CLVAnalytics analytics = getAnalytics();
+        if (analytics.totalCustomers == 0) {
             cout << "📊 No customers for analytics." << endl;
             return;
         }
 
         cout << "=== CLV Analytics ===" << endl;
-        cout << "Total Customers: " << customers.size() << endl;
+        cout << "Total Customers: " << analytics.totalCustomers << endl;
+        cout << "Average CLV: ₹" << analytics.averageCLV << endl;
+        cout << "Highest CLV: ₹" << analytics.highestCLV << endl;
+        cout << "Lowest CLV: ₹" << analytics.lowestCLV << endl;
+        cout << "Total CLV: ₹" << analytics.totalCLV << endl;
+        cout << "CLV Standard Deviation: ₹" << analytics.standardDeviationCLV << endl;
+        cout << endl;
+    }
 
-        // Calculate average CLV (DSA: Loop through vector)
-        double totalCLV = 0;
-        double highestCLV = 0;
-        double lowestCLV = customers[0].clv;
+    // Analytics from the incrementally maintained statistics, O(1)
+    CLVAnalytics getAnalytics() {
+        shared_lock<shared_mutex> lock(tableMutex);
+        CLVAnalytics analytics;
+        analytics.totalCustomers = clvStats.count();
+        analytics.totalCLV = clvStats.sum();
+        analytics.averageCLV = clvStats.mean();
+        analytics.highestCLV = clvStats.max();
+        analytics.lowestCLV = clvStats.min();
+        analytics.varianceCLV = clvStats.variance();
+        analytics.standardDeviationCLV = clvStats.standardDeviation();
+        return analytics;
+    }
 
-        for (const auto& customer : customers) {
-            totalCLV += customer.clv;
-            if (customer.clv > highestCLV) highestCLV = customer.clv;
-            if (customer.clv < lowestCLV) lowestCLV = customer.clv;
-        }
+    // Analytics as if CLV were computed by model, without changing the stored values.
+    // Same as getAnalytics() for the active model; otherwise one parallel pass.
+    CLVAnalytics getAnalytics(const CLVModel& model) {
+        if (model == getModel()) return getAnalytics();
 
-        double averageCLV = totalCLV / customers.size();
+        shared_lock<shared_mutex> lock(tableMutex);
+        vector<double> values;
+        evaluateModel(model, values);
+        RunningStatistics stats = taskPool->parallelReduce(values.size(), TaskPool::DEFAULT_GRAIN, RunningStatistics(false),
+            [&values](size_t begin, size_t end) {
+                RunningStatistics part(false);
+                part.rebuild(values.data() + begin, end - begin);
+                return part;
+            },
+            [](RunningStatistics total, const RunningStatistics& part) {
+                total.combine(part);
+                return total;
+            });
 
-        cout << "Average CLV: ₹" << averageCLV << endl;
-        cout << "Highest CLV: ₹" << highestCLV << endl;
-        cout << "Lowest CLV: ₹" << lowestCLV << endl;
-        cout << "Total CLV: ₹" << totalCLV << endl;
-        cout << endl;
+        CLVAnalytics analytics;
+        analytics.totalCustomers = stats.count();
+        analytics.totalCLV = stats.sum();
+        analytics.averageCLV = stats.mean();
+        analytics.highestCLV = stats.max();
+        analytics.lowestCLV = stats.min();
+        analytics.varianceCLV = stats.variance();
+        analytics.standardDeviationCLV = stats.standardDeviation();
+        return analytics;
     }
 
-    // Save customers to JSON file (DSA: File I/O)
-    void saveToJSON(const string& filename = "customers.json") {
-        ofstream file(filename);
-        if (!file.is_open()) {
-            cout << "❌ Error: Could not open file for writing!" << endl;
-            return;
+    // Percentiles (quantiles in [0, 1]) from the KLL sketch plus the CLV histogram.
+    // Memory is bounded whatever the customer count.
+    CLVDistribution getDistribution(const vector<double>& quantiles) {
+        shared_lock<shared_mutex> lock(tableMutex);
+        lock_guard<mutex> distributionLock(distributionMutex);
+        if (clvDistribution.needsRebuild()) {
+            rebuildDistribution();
         }
 
-        file << "{\n";
-        file << "  \"customers\": [\n";
-
-        for (size_t i = 0; i < customers.size(); i++) {
-            const auto& customer = customers[i];
-            file << "    {\n";
-            file << "      \"id\": \"" << escapeString(customer.id) << "\",\n";
-            file << "      \"name\": \"" << escapeString(customer.name) << "\",\n";
-            file << "      \"averagePurchaseValue\": " << customer.averagePurchaseValue << ",\n";
-            file << "      \"purchaseFrequency\": " << customer.purchaseFrequency << ",\n";
-            file << "      \"customerLifespan\": " << customer.customerLifespan << ",\n";
-            file << "      \"clv\": " << customer.clv << "\n";
-            file << "    }";
-            if (i < customers.size() - 1) {
-                file << ",";
-            }
-            file << "\n";
+        CLVDistribution distribution;
+        distribution.totalCustomers = clvDistribution.count();
+        for (double q : quantiles) {
+            distribution.percentiles.emplace_back(q, clvDistribution.quantiles().quantile(q));
         }
+        distribution.histogram = clvDistribution.buckets().buckets();
+        distribution.sketchItems = clvDistribution.quantiles().retainedItems();
+        return distribution;
+    }
 
-        file << "  ],\n";
-        file << "  \"totalCustomers\": " << customers.size() << ",\n";
-        file << "  \"averageCLV\": " << (customers.empty() ? 0 : customers[0].calculateCLV()) << ",\n";
-        file << "  \"timestamp\": \"" << getCurrentTimestamp() << "\"\n";
-        file << "}\n";
+    // CLV tiers with their totals and the customer count of every RFM score cell
+    SegmentOverview getSegments() {
+        shared_lock<shared_mutex> lock(tableMutex);
+        lock_guard<mutex> segmentsLock(segmentsMutex);
+        if (segments.stale()) {
+            rebuildSegments();
+        }
 
-        file.close();
-        cout << "💾 Saved " << customers.size() << " customers to " << filename << endl;
+        SegmentOverview overview;
+        overview.totalCustomers = ids.size();
+        const SegmentConfig& config = segments.getConfig();
+        const vector<double>& cuts = segments.getTierCuts();
+        for (size_t t = 0; t < segments.tierCount(); t++) {
+            SegmentTier tier;
+            tier.name = config.tierNames[t];
+            tier.lowerQuantile = t == 0 ? 0 : config.tierQuantiles[t - 1];
+            tier.lowerCLV = t == 0 ? -numeric_limits<double>::infinity() : cuts[t - 1];
+            tier.upperCLV = t < cuts.size() ? cuts[t] : numeric_limits<double>::infinity();
+            tier.customers = segments.tierSize(t);
+            tier.totalCLV = segments.tierTotal(t);
+            tier.averageCLV = tier.customers > 0 ? tier.totalCLV / tier.customers : 0;
+            overview.tiers.push_back(tier);
+        }
+        overview.levels = config.levels;
+        for (int m = 0; m < 3; m++) {
+            overview.scoreCuts[m] = segments.getScoreCuts(static_cast<SegmentIndex::Metric>(m));
+        }
+        overview.cells = segments.scoreCellCounts();
+        return overview;
     }
 
-    // Load customers from JSON file (DSA: File I/O)
-    void loadFromJSON(const string& filename = "customers.json") {
-        // Clear existing customers before loading to prevent duplicates
-        customers.clear();
-        ifstream file(filename);
-        if (!file.is_open()) {
-            cout << "⚠️  Could not open " << filename << " - starting fresh!" << endl;
-            return;
+    // Members of a segment (tier and/or score ranges): totals over every member and
+    // up to limit of them after skipping offset. Only the segment's bitmaps and its
+    // members' rows are read. Empty if the query names an unknown tier.
+    optional<SegmentPage> querySegment(const SegmentQuery& query, size_t offset, size_t limit) {
+        shared_lock<shared_mutex> lock(tableMutex);
+        lock_guard<mutex> segmentsLock(segmentsMutex);
+        if (segments.stale()) {
+            rebuildSegments();
         }
 
-        string content((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
-        file.close();
+        RowBitmap rows;
+        if (!segments.select(query, rows)) return nullopt;
+        SegmentPage page;
+        if (!query.tier.empty() && !segments.restrictsScores(query)) {
+            // A whole tier: its totals are maintained
+            size_t tier = segments.findTier(query.tier);
+            page.customers = segments.tierSize(tier);
+            page.totalCLV = segments.tierTotal(tier);
+        } else {
+            rows.forEach([&](size_t row) {
+                page.customers++;
+                page.totalCLV += clvColumn[row];
+            });
+        }
+        page.averageCLV = page.customers > 0 ? page.totalCLV / page.customers : 0;
+        for (size_t row : rows.page(offset, limit)) {
+            page.members.push_back(rowAt(row));
+        }
+        return page;
+    }
 
-        // Simple JSON parsing (basic implementation)
-        size_t pos = 0;
-        while ((pos = content.find("\"id\":", pos)) != string::npos) {
-            // Extract customer data from JSON (simplified parsing)
-            string id, name;
-            double aov = 0, freq = 0, lifespan = 0;
+    SegmentConfig getSegmentConfig() const {
+        shared_lock<shared_mutex> lock(tableMutex);
+        return segments.getConfig();
+    }
 
-            // Extract ID
-            size_t idStart = content.find("\"", pos + 6);
-            size_t idEnd = content.find("\"", idStart + 1);
-            if (idStart != string::npos && idEnd != string::npos) {
-                id = content.substr(idStart + 1, idEnd - idStart - 1);
-            }
+    // Switch to a new tier / score configuration and re-cut every customer.
+    // Returns what is wrong with config, or "" once applied.
+    string configureSegments(const SegmentConfig& config) {
+        string problem = config.validate();
+        if (!problem.empty()) return problem;
+        unique_lock<shared_mutex> lock(tableMutex);
+        segments.configure(config);
+        rebuildSegments();
+        return "";
+    }
 
-            // Extract name
-            pos = content.find("\"name\":", pos);
-            size_t nameStart = content.find("\"", pos + 8);
-            size_t nameEnd = content.find("\"", nameStart + 1);
-            if (nameStart != string::npos && nameEnd != string::npos) {
-                name = content.substr(nameStart + 1, nameEnd - nameStart - 1);
-            }
+    // Save customers to JSON file (DSA: File I/O)
+    bool saveToJSON(const string& filename = "customers.json") {
+        shared_lock<shared_mutex> lock(tableMutex);
+        lock_guard<mutex> bufferLock(saveBufferMutex);
+        return writeSnapshotFile(saveBuffer, filename, false, ids, names, aovColumn, freqColumn, lifespanColumn,
+                                 clvColumn, clvModel);
+    }
 
-            // Extract AOV
-            pos = content.find("\"averagePurchaseValue\":", pos);
-            size_t aovStart = pos + 25;
-            size_t aovEnd = content.find(",", aovStart);
-            if (aovEnd != string::npos) {
-                string aovStr = content.substr(aovStart, aovEnd - aovStart);
-                try {
-                    aov = stod(aovStr);
-                } catch (...) {}
-            }
+    // Save on a background thread so the caller doesn't wait for the rewrite.
+    // The columns are copied now; if saves arrive faster than they are written,
+    // only the newest pending copy is kept.
+    void saveToJSONAsync(const string& filename = "customers.json") {
+        shared_lock<shared_mutex> lock(tableMutex);
+        queueSave(filename, false, false);
+    }
 
-            // Extract frequency
-            pos = content.find("\"purchaseFrequency\":", pos);
-            size_t freqStart = pos + 22;
-            size_t freqEnd = content.find(",", freqStart);
-            if (freqEnd != string::npos) {
-                string freqStr = content.substr(freqStart, freqEnd - freqStart);
-                try {
-                    freq = stod(freqStr);
-                } catch (...) {}
-            }
+    // Rewrite the snapshot file (the one openWithJournal recovers from, in its own
+    // format) on the background saver, like saveToJSONAsync
+    void saveSnapshotAsync() {
+        shared_lock<shared_mutex> lock(tableMutex);
+        queueSave(snapshotPath, isBinarySnapshotPath(snapshotPath), false);
+    }
 
-            // Extract lifespan
-            pos = content.find("\"customerLifespan\":", pos);
-            size_t lifeStart = pos + 20;
-            size_t lifeEnd = content.find(",", lifeStart);
-            if (lifeEnd != string::npos) {
-                string lifeStr = content.substr(lifeStart, lifeEnd - lifeStart);
-                try {
-                    lifespan = stod(lifeStr);
-                } catch (...) {}
+    // Block until every requested background save has been written
+    void waitForPendingSaves() {
+        unique_lock<mutex> lock(saverMutex);
+        saverIdle.wait(lock, [this] { return !pendingSave && !saveInProgress; });
+    }
+
+    // Load customers from JSON file (DSA: File I/O, streaming tokenizer over an mmapped file).
+    // False if the file exists but not every customer in it was loaded.
+    bool loadFromJSON(const string& filename = "customers.json") {
+        unique_lock<shared_mutex> lock(tableMutex);
+        return loadRows(filename, false);
+    }
+
+    // Binary snapshot (customer_snapshot.hpp): loads without parsing
+    bool saveToBinary(const string& filename = "customers.bin") {
+        shared_lock<shared_mutex> lock(tableMutex);
+        lock_guard<mutex> bufferLock(saveBufferMutex);
+        return writeSnapshotFile(saveBuffer, filename, true, ids, names, aovColumn, freqColumn, lifespanColumn,
+                                 clvColumn, clvModel);
+    }
+
+    // False if the file exists but is not a valid snapshot (the table is left empty)
+    bool loadFromBinary(const string& filename = "customers.bin") {
+        unique_lock<shared_mutex> lock(tableMutex);
+        return loadRows(filename, true);
+    }
+
+    // Recover from snapshot + journal, then log every further mutation to the journal.
+    // Recovery loads the snapshot, replays a rotated journal left by an unfinished
+    // compaction and then the live journal; if anything was replayed it is folded
+    // into a new snapshot right away. compactBytes = 0 disables compaction.
+    // snapshotFile is JSON if it ends in .json and a binary snapshot otherwise.
+    bool openWithJournal(const string& snapshotFile, const string& journalFile,
+                         CustomerJournal::SyncMode mode = CustomerJournal::SYNC_GROUP,
+                         uint64_t compactBytes = 64ull << 20) {
+        unique_lock<shared_mutex> lock(tableMutex);
+        journal.close();
+        snapshotPath = snapshotFile;
+        journalPath = journalFile;
+        compactThreshold = compactBytes;
+
+        loadRows(snapshotFile, isBinarySnapshotPath(snapshotFile));
+
+        // The journal is closed, so replaying doesn't log the records again
+        auto apply = [this](const JournalRecord& record) {
+            uint64_t ticket;
+            MutationFailure ignored;
+            if (record.op == JournalRecord::SET_MODEL) {
+                CLVModel model;
+                model.params.margin = record.modelMargin;
+                model.params.discountRate = record.modelDiscountRate;
+                if (CLVModel::parseKind(record.name, model.kind) && model.validate().empty()) {
+                    applyModel(model);
+                }
+            } else if (record.op == JournalRecord::REMOVE) {
+                eraseCustomer(record.id, ticket);
+            } else if (idIndex.count(record.id)) {
+                replaceCustomer(record.id, record.name, record.averagePurchaseValue,
+                                record.purchaseFrequency, record.customerLifespan, ticket, ignored);
+            } else {
+                insertCustomer(record.id, record.name, record.averagePurchaseValue,
+                               record.purchaseFrequency, record.customerLifespan, ticket, ignored);
             }
+        };
+        size_t replayed = CustomerJournal::replay(rotatedJournalPath(), apply);
+        replayed += CustomerJournal::replay(journalPath, apply);
 
-            // Add customer if we have valid data
-            if (!id.empty() && !name.empty() && aov > 0 && freq > 0 && lifespan > 0) {
-                customers.emplace_back(id, name, aov, freq, lifespan);
+        if (replayed > 0) {
+            cout << "📜 Replayed " << replayed << " journal records from " << journalPath << endl;
+            lock_guard<mutex> bufferLock(saveBufferMutex);
+            if (!writeSnapshotFile(saveBuffer, snapshotFile, isBinarySnapshotPath(snapshotFile), ids, names,
+                                   aovColumn, freqColumn, lifespanColumn, clvColumn, clvModel)) {
+                return false;  // Keep the journals; they are still needed
+            }
+            ::unlink(rotatedJournalPath().c_str());
+            if (::truncate(journalPath.c_str(), 0) != 0) {
+                cout << "⚠️  Could not truncate journal " << journalPath << endl;
             }
+        }
+        if (!journal.open(journalPath, mode)) return false;
+        journalModelForJSONSnapshot();
+        return true;
+    }
 
-            pos++;
+    // Replace the in-memory table with the snapshot file as it is on disk now.
+    // The journal is emptied, since its records describe changes to the old data.
+    // Returns false if the snapshot could not be opened (the table is then empty).
+    bool reloadSnapshot() {
+        unique_lock<shared_mutex> lock(tableMutex);
+        // No saves can be queued while we hold the lock; let in-flight ones finish
+        // so they don't overwrite the file being reloaded
+        waitForPendingSaves();
+        loadRows(snapshotPath, isBinarySnapshotPath(snapshotPath));
+        if (journal.isOpen()) {
+            journal.truncate();
+            journalModelForJSONSnapshot();
+            ::unlink(rotatedJournalPath().c_str());
+            lock_guard<mutex> saverLock(saverMutex);
+            compacting = false;
         }
+        return statFile(snapshotPath).inode != 0;
+    }
 
-        cout << "📂 Loaded " << customers.size() << " customers from " << filename << endl;
+    // Reload if the snapshot was changed by someone other than this calculator
+    bool reloadIfChanged() {
+        {
+            lock_guard<mutex> lock(snapshotStampMutex);
+            if (statFile(snapshotPath) == snapshotStamp) return false;
+        }
+        reloadSnapshot();
+        return true;
+    }
+
+    const string& getSnapshotPath() const {
+        return snapshotPath;
+    }
+
+    bool isJournaling() const {
+        return journal.isOpen();
+    }
+
+    // Run whole-table loops on another pool (e.g. to measure scaling); the pool must outlive its use
+    void setTaskPool(TaskPool& pool) {
+        unique_lock<shared_mutex> lock(tableMutex);
+        taskPool = &pool;
+    }
+
+    // Per-customer console messages on/off (bulk operations turn them off)
+    void setVerbose(bool enabled) {
+        verbose = enabled;
     }
 
     // Get customer count
     size_t getCustomerCount() const {
-        return customers.size();
+        shared_lock<shared_mutex> lock(tableMutex);
+        return ids.size();
+    }
+
+    // Version of the customer data - changes whenever customers are added or reloaded
+    unsigned long long getDataVersion() const {
+        return dataVersion;
+    }
+
+    // Read-only traversal of all customers. Runs under the shared lock, so the
+    // visitor sees one consistent table and must not call back into mutators.
+    template<typename Visitor>
+    void forEachCustomer(Visitor visit) const {
+        shared_lock<shared_mutex> lock(tableMutex);
+        for (size_t row = 0; row < ids.size(); row++) {
+            visit(rowAt(row));
+        }
+    }
+
+    // Traversal with each customer's CLV computed by model
+    template<typename Visitor>
+    void forEachCustomer(const CLVModel& model, Visitor visit) const {
+        shared_lock<shared_mutex> lock(tableMutex);
+        for (size_t row = 0; row < ids.size(); row++) {
+            visit(rowAt(row, model));
+        }
+    }
+
+    // Recalculate every CLV from the metric columns, vectorized and spread over the task pool
+    void recomputeAllCLV() {
+        recomputeAll(getModel());
+    }
+
+    // Switch the stored CLVs (listing, analytics, leaderboard, saved files) to model
+    // and recompute them in one batch; later adds and updates use it too. The
+    // switch is journaled like a mutation and recorded in binary snapshots, so it
+    // survives a restart. Returns false (nothing changed) if the journal write fails.
+    bool recomputeAll(const CLVModel& model) {
+        uint64_t ticket = 0;
+        {
+            unique_lock<shared_mutex> lock(tableMutex);
+            if (!journalMutation(modelRecord(model), ticket)) {
+                return false;
+            }
+            applyModel(model);
+        }
+        journal.waitDurable(ticket);
+        return true;
+    }
+
+    CLVModel getModel() const {
+        shared_lock<shared_mutex> lock(tableMutex);
+        return clvModel;
     }
 
     // Interactive menu
@@ -324,7 +1962,7 @@ public:
             cout << endl;
             cout << "1. Add Customer" << endl;
             cout << "2. View All Customers" << endl;
-            cout << "3. View Top Customers (Quicksort)" << endl;
+            cout << "3. View Top Customers (Top-K Selection)" << endl;
             cout << "4. View Analytics" << endl;
             cout << "5. Save to JSON File" << endl;
             cout << "6. Load from JSON File" << endl;
@@ -0,0 +1,696 @@
+#ifndef CLV_CLI_HPP
+#define CLV_CLI_HPP
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <chrono>
+#include "clv_calculator.hpp"
+#include "bulk_import.hpp"
+#include "clv_probabilistic.hpp"
+
+using namespace std;
+
+// Non-interactive subcommands for scripts and cron jobs:
+//
+//   clv-calculator import --input FILE [--output customers.json] [--format csv|ndjson]
+//   clv-calculator top    [--input customers.json] [--count 10] [--output FILE]
+//   clv-calculator stats  [--input customers.json] [--output FILE]
+//   clv-calculator export [--input customers.json] --output FILE
+//   clv-calculator bench  [--count 1000000] [--threads N]
+//
+// Inputs and outputs are picked by extension: .json, .bin (binary snapshot),
+// .csv, .ndjson/.jsonl. Results go to stdout (or --output) as CSV or JSON;
+// progress and warnings go to stderr, or nowhere with --quiet. Exit status is
+// 0 on success, 1 on failure, 2 on a usage error and 3 when import rejected
+// rows (the accepted ones are still saved). A table that does not load in full
+// (--input, or the file import merges into) is a failure, and nothing is written.
+
+struct CLIOptions {
+    string command;
+    string input;
+    string output;
+    string format;        // Import format override
+    size_t count = 0;     // top: rows to list (10); bench/fitbench: customers to generate (1000000/100000)
+    size_t threads = 0;   // Worker threads, 0 = all cores
+    CLVModel model;       // top/stats/export: CLV formula (--model, --margin, --discount)
+    bool modelKindSet = false, marginSet = false, discountSet = false;  // Which of those were given
+    string rfm;           // fit: per-customer transaction summaries
+    double horizon = 52;  // fit: prediction window, in the RFM data's time unit
+    MonteCarloSettings montecarlo;  // simulate: draws, seed and input distributions
+    bool quiet = false;
+};
+
+const char* const CLI_USAGE =
+    "Usage: clv-calculator <command> [options]\n"
+    "  import  --input FILE [--output customers.json] [--format csv|ndjson]\n"
+    "  top     [--input customers.json] [--count 10] [--output FILE]\n"
+    "  stats   [--input customers.json] [--output FILE]\n"
+    "  export  [--input customers.json] --output FILE\n"
+    "  bench   [--count 1000000] [--threads N]\n"
+    "  fit     --rfm FILE [--input customers.json] [--horizon 52] [--margin M] [--output FILE]\n"
+    "  fitbench [--count 100000] [--threads N]\n"
+    "  simulate [--input customers.json] [--draws 1000] [--seed 1] [--distribution lognormal|normal|uniform]\n"
+    "           [--cv 0.2] [--cv-aov X] [--cv-frequency X] [--cv-lifespan X] [--output FILE]\n"
+    "Options: --threads N (worker threads), --quiet (no progress on stderr)\n"
+    "         --model simple|margin|discounted|retention [--margin M] [--discount D]\n"
+    "Files: .json, .bin, .csv, .ndjson/.jsonl (chosen by extension)\n"
+    "Exit status: 0 ok, 1 failure, 2 usage error, 3 import rejected rows\n";
+
+inline bool isCLICommand(const string& word) {
+    return word == "import" || word == "top" || word == "stats" || word == "export" || word == "bench" ||
+           word == "fit" || word == "fitbench" || word == "simulate";
+}
+
+inline bool parseCLIOptions(int argc, char* argv[], CLIOptions& options, string& error) {
+    options.command = argv[1];
+    // --cv applies to all inputs; --cv-aov etc. win over it regardless of order
+    double allCV = -1;
+    double inputCV[3] = {-1, -1, -1};
+    for (int i = 2; i < argc; i++) {
+        string arg = argv[i];
+        auto value = [&](string& target) {
+            if (i + 1 >= argc) {
+                error = arg + " needs a value";
+                return false;
+            }
+            target = argv[++i];
+            return true;
+        };
+        auto real = [&](double& target) {
+            string text;
+            if (!value(text)) return false;
+            char* end = nullptr;
+            target = strtod(text.c_str(), &end);
+            if (text.empty() || *end != '\0') {
+                error = arg + " expects a number";
+                return false;
+            }
+            return true;
+        };
+        auto number = [&](size_t& target) {
+            string text;
+            if (!value(text)) return false;
+            char* end = nullptr;
+            unsigned long long parsed = strtoull(text.c_str(), &end, 10);
+            if (text.empty() || *end != '\0') {
+                error = arg + " expects a number";
+                return false;
+            }
+            target = parsed;
+            return true;
+        };
+
+        bool ok = true;
+        if (arg == "--input" || arg == "-i") ok = value(options.input);
+        else if (arg == "--output" || arg == "-o") ok = value(options.output);
+        else if (arg == "--format") ok = value(options.format);
+        else if (arg == "--count" || arg == "-n") ok = number(options.count);
+        else if (arg == "--threads") ok = number(options.threads);
+        else if (arg == "--rfm") ok = value(options.rfm);
+        else if (arg == "--horizon") ok = real(options.horizon);
+        else if (arg == "--draws") ok = number(options.montecarlo.draws);
+        else if (arg == "--cv") ok = real(allCV);
+        else if (arg == "--cv-aov") ok = real(inputCV[0]);
+        else if (arg == "--cv-frequency") ok = real(inputCV[1]);
+        else if (arg == "--cv-lifespan") ok = real(inputCV[2]);
+        else if (arg == "--seed") {
+            size_t seed = 0;
+            ok = number(seed);
+            options.montecarlo.seed = seed;
+        }
+        else if (arg == "--distribution") {
+            string name;
+            ok = value(name);
+            InputDistribution distribution = InputDistribution::LOGNORMAL;
+            if (ok && !InputUncertainty::parseDistribution(name, distribution)) {
+                error = "unknown distribution " + name;
+                return false;
+            }
+            options.montecarlo.aov.distribution = distribution;
+            options.montecarlo.frequency.distribution = distribution;
+            options.montecarlo.lifespan.distribution = distribution;
+        }
+        else if (arg == "--margin") {
+            ok = real(options.model.params.margin);
+            options.marginSet = true;
+        }
+        else if (arg == "--discount") {
+            ok = real(options.model.params.discountRate);
+            options.discountSet = true;
+        }
+        else if (arg == "--model") {
+            string name;
+            ok = value(name);
+            options.modelKindSet = true;
+            if (ok && !CLVModel::parseKind(name, options.model.kind)) {
+                error = "unknown model " + name;
+                return false;
+            }
+        }
+        else if (arg == "--quiet" || arg == "-q") options.quiet = true;
+        else if (arg[0] != '-' && options.input.empty()) options.input = arg;  // clv-calculator import data.csv
+        else {
+            error = "unknown option " + arg;
+            return false;
+        }
+        if (!ok) return false;
+    }
+
+    if (options.command == "import" && options.input.empty()) {
+        error = "import needs --input";
+        return false;
+    }
+    if (options.command == "export" && options.output.empty()) {
+        error = "export needs --output";
+        return false;
+    }
+    if (options.command == "fit" && options.rfm.empty()) {
+        error = "fit needs --rfm";
+        return false;
+    }
+    if (!(options.horizon > 0) || isinf(options.horizon)) {
+        error = "--horizon must be a positive number";
+        return false;
+    }
+    InputUncertainty* inputs[] = {&options.montecarlo.aov, &options.montecarlo.frequency, &options.montecarlo.lifespan};
+    for (int k = 0; k < 3; k++) {
+        if (allCV >= 0) inputs[k]->cv = allCV;
+        if (inputCV[k] >= 0) inputs[k]->cv = inputCV[k];
+    }
+    error = options.model.validate();
+    if (error.empty()) error = options.montecarlo.validate();
+    if (!error.empty()) return false;
+    if (options.threads == 0) options.threads = TaskPool::defaultParallelism();
+    if (options.count == 0) {
+        options.count = options.command == "bench" ? 1000000 : options.command == "fitbench" ? 100000 : 10;
+    }
+    return true;
+}
+
+inline bool hasExtension(const string& path, const string& extension) {
+    return path.size() >= extension.size() &&
+           path.compare(path.size() - extension.size(), extension.size(), extension) == 0;
+}
+
+inline bool isBulkPath(const string& path) {
+    return hasExtension(path, ".csv") || hasExtension(path, ".ndjson") || hasExtension(path, ".jsonl");
+}
+
+// CSV field, quoted when it contains a separator, quote or line break
+inline void appendCSVField(string& out, const string& field) {
+    if (field.find_first_of(",\"\r\n") == string::npos) {
+        out += field;
+        return;
+    }
+    out += '"';
+    for (char c : field) {
+        if (c == '"') out += '"';
+        out += c;
+    }
+    out += '"';
+}
+
+// The whole output of a command goes to stdout or is written atomically to a file
+inline bool emitCLIOutput(const string& path, streambuf* stdoutBuffer, const string& text) {
+    if (path.empty() || path == "-") {
+        ostream out(stdoutBuffer);
+        out << text;
+        out.flush();
+        return bool(out);
+    }
+    string error;
+    if (!writeFileAtomically(path, text, error)) {
+        cerr << "❌ Error: " << error << endl;
+        return false;
+    }
+    return true;
+}
+
+// Add the rows of a CSV/NDJSON file; rejected rows are reported as file:line: reason.
+// The file is parsed and added in batches of 64 MB of input, so only one batch of
+// parsed rows is held at a time.
+inline bool importBulkFile(CLVCalculator& calculator, const string& path, const CLIOptions& options,
+                           size_t& imported, size_t& rejectedCount) {
+    MappedFile file;
+    if (!file.open(path)) {
+        cerr << "❌ Error: Could not open " << path << endl;
+        return false;
+    }
+    ImportFormat format = hasExtension(path, ".csv") ? ImportFormat::CSV
+                        : isBulkPath(path) ? ImportFormat::NDJSON
+                        : detectImportFormat(file.data(), file.size());
+    if (!options.format.empty() && !parseImportFormat(options.format, format)) {
+        cerr << "❌ Error: Unknown format '" << options.format << "' (use csv or ndjson)" << endl;
+        return false;
+    }
+
+    const size_t BATCH_BYTES = 64 << 20;
+    TaskPool pool(options.threads);
+    imported = 0;
+    rejectedCount = 0;
+    vector<CustomerRecord> records;
+    vector<pair<size_t, string>> rejected;
+    parseCustomersBulkBatches(file.data(), file.size(), format, pool, BATCH_BYTES, [&](ImportBatch& batch) {
+        records.clear();
+        records.reserve(batch.rows.size());
+        for (auto& row : batch.rows) {
+            records.push_back(std::move(row.record));
+        }
+        rejected.clear();
+        imported += calculator.addCustomersBatch(records, rejected);
+
+        vector<ImportError> errors = std::move(batch.errors);
+        for (auto& entry : rejected) {
+            errors.push_back(ImportError{batch.rows[entry.first].line, std::move(entry.second)});
+        }
+        sort(errors.begin(), errors.end(), [](const ImportError& a, const ImportError& b) { return a.line < b.line; });
+        for (const auto& error : errors) {
+            cout << "⚠️  " << path << ":" << error.line << ": " << error.message << endl;
+        }
+        rejectedCount += errors.size();
+    });
+    return true;
+}
+
+// The model a command works with: the loaded table's own (recorded in binary
+// snapshots), with only the settings given on the command line replaced
+inline CLVModel cliModel(const CLIOptions& options, CLVModel model) {
+    if (options.modelKindSet) model.kind = options.model.kind;
+    if (options.marginSet) model.params.margin = options.model.params.margin;
+    if (options.discountSet) model.params.discountRate = options.model.params.discountRate;
+    return model;
+}
+
+// Load the customer table from any supported file. Fails unless every customer in
+// it was loaded, so a command never works on (or writes back) part of a table.
+inline bool loadCLIInput(CLVCalculator& calculator, const string& path, const CLIOptions& options) {
+    if (statFile(path).inode == 0) {
+        cerr << "❌ Error: " << path << " does not exist" << endl;
+        return false;
+    }
+    bool loaded;
+    if (isBulkPath(path)) {
+        size_t imported, rejected;
+        loaded = importBulkFile(calculator, path, options, imported, rejected) && rejected == 0;
+    } else if (hasExtension(path, ".json")) {
+        loaded = calculator.loadFromJSON(path);
+    } else {
+        loaded = calculator.loadFromBinary(path);
+    }
+    if (!loaded) {
+        cerr << "❌ Error: Could not load all customers from " << path << " - nothing was written" << endl;
+    }
+    return loaded;
+}
+
+inline bool saveCLIOutput(CLVCalculator& calculator, const string& path, streambuf* stdoutBuffer) {
+    if (hasExtension(path, ".json")) return calculator.saveToJSON(path);
+    if (!isBulkPath(path)) return calculator.saveToBinary(path);
+
+    bool csv = hasExtension(path, ".csv");
+    string text;
+    if (csv) text = "id,name,averagePurchaseValue,purchaseFrequency,customerLifespan,clv\n";
+    calculator.forEachCustomer([&](const Customer& customer) {
+        if (csv) {
+            appendCSVField(text, customer.id);
+            text += ',';
+            appendCSVField(text, customer.name);
+            for (double value : {customer.averagePurchaseValue, customer.purchaseFrequency,
+                                 customer.customerLifespan, customer.clv}) {
+                text += ',';
+                appendJSONNumber(text, value);
+            }
+        } else {
+            text += "{\"id\":";
+            appendJSONString(text, customer.id);
+            text += ",\"name\":";
+            appendJSONString(text, customer.name);
+            text += ",\"averagePurchaseValue\":";
+            appendJSONNumber(text, customer.averagePurchaseValue);
+            text += ",\"purchaseFrequency\":";
+            appendJSONNumber(text, customer.purchaseFrequency);
+            text += ",\"customerLifespan\":";
+            appendJSONNumber(text, customer.customerLifespan);
+            text += ",\"clv\":";
+            appendJSONNumber(text, customer.clv);
+            text += '}';
+        }
+        text += '\n';
+    });
+    return emitCLIOutput(path, stdoutBuffer, text);
+}
+
+// Time the parallel whole-table operations on a synthetic table at 1, 2, 4, ...
+// threads up to options.threads. Prints CSV; "identical" says whether the
+// results match the single-threaded run bit for bit.
+inline int runBenchmark(CLVCalculator& calculator, const CLIOptions& options, streambuf* stdoutBuffer) {
+    // Deterministic synthetic customers, added in batches to bound memory
+    uint64_t state = 0x2545F4914F6CDD1Dull;
+    auto uniform = [&state](double low, double high) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return low + (high - low) * ((state >> 11) * (1.0 / 9007199254740992.0));
+    };
+    const size_t BATCH = 1 << 20;
+    vector<CustomerRecord> records;
+    vector<pair<size_t, string>> rejected;
+    for (size_t start = 0; start < options.count; start += BATCH) {
+        size_t end = min(options.count, start + BATCH);
+        records.resize(end - start);
+        for (size_t i = start; i < end; i++) {
+            CustomerRecord& record = records[i - start];
+            record.id = "B" + to_string(i);
+            record.name = "Customer " + to_string(i);
+            record.averagePurchaseValue = uniform(10, 500);
+            record.purchaseFrequency = uniform(1, 20);
+            record.customerLifespan = uniform(1, 10);
+        }
+        calculator.addCustomersBatch(records, rejected);
+    }
+    cout << "🧪 Benchmarking " << calculator.getCustomerCount() << " customers" << endl;
+
+    auto elapsedMs = [](chrono::steady_clock::time_point since) {
+        return chrono::duration<double, milli>(chrono::steady_clock::now() - since).count();
+    };
+    string text = "threads,recompute_ms,top_ms,recompute_speedup,top_speedup,identical\n";
+    double baseRecompute = 0, baseTop = 0;
+    string baseline;
+    for (size_t threads = 1; ; threads = min(threads * 2, options.threads)) {
+        TaskPool pool(threads);
+        calculator.setTaskPool(pool);
+
+        // Best of three runs
+        double recomputeMs = 1e300, topMs = 1e300;
+        vector<Customer> top;
+        for (int run = 0; run < 3; run++) {
+            auto start = chrono::steady_clock::now();
+            calculator.recomputeAllCLV();
+            recomputeMs = min(recomputeMs, elapsedMs(start));
+            start = chrono::steady_clock::now();
+            top = calculator.getTopCustomers(100);
+            topMs = min(topMs, elapsedMs(start));
+        }
+
+        // Bit-exact fingerprint of everything computed in parallel
+        CLVAnalytics analytics = calculator.getAnalytics();
+        CLVDistribution distribution = calculator.getDistribution({0.5, 0.9, 0.99});
+        string fingerprint;
+        for (double value : {analytics.totalCLV, analytics.varianceCLV, analytics.lowestCLV, analytics.highestCLV}) {
+            appendJSONNumber(fingerprint, value);
+            fingerprint += ',';
+        }
+        for (const auto& percentile : distribution.percentiles) {
+            appendJSONNumber(fingerprint, percentile.second);
+            fingerprint += ',';
+        }
+        for (const auto& customer : top) fingerprint += customer.id + ',';
+
+        if (threads == 1) {
+            baseRecompute = recomputeMs;
+            baseTop = topMs;
+            baseline = fingerprint;
+        }
+        char line[160];
+        snprintf(line, sizeof(line), "%zu,%.2f,%.2f,%.2f,%.2f,%s\n", threads, recomputeMs, topMs,
+                 baseRecompute / recomputeMs, baseTop / topMs, fingerprint == baseline ? "true" : "false");
+        text += line;
+
+        calculator.setTaskPool(TaskPool::shared());
+        if (threads >= options.threads) break;
+    }
+    return emitCLIOutput(options.output, stdoutBuffer, text) ? 0 : 1;
+}
+
+inline void printFitSummary(const ProbabilisticCLV& model, const FitSummary& bgnbd, const FitSummary& gammaGamma) {
+    const BGNBDParams& purchases = model.bgnbd();
+    const GammaGammaParams& spend = model.gammaGamma();
+    cout << "📈 BG/NBD: r=" << purchases.r << " alpha=" << purchases.alpha << " a=" << purchases.a
+         << " b=" << purchases.b << " (log-likelihood " << bgnbd.logLikelihood << ", "
+         << bgnbd.evaluations << " evaluations" << (bgnbd.converged ? "" : ", not converged") << ")" << endl;
+    cout << "💰 Gamma-Gamma: p=" << spend.p << " q=" << spend.q << " v=" << spend.v << " (log-likelihood "
+         << gammaGamma.logLikelihood << ", " << gammaGamma.evaluations << " evaluations"
+         << (gammaGamma.converged ? "" : ", not converged") << ")" << endl;
+}
+
+// Fit BG/NBD and Gamma-Gamma to the --rfm summaries and predict every customer's
+// CLV over --horizon. With a customer table, its customers are scored (those
+// without history are skipped); otherwise every row of the RFM file is.
+inline int runFit(CLVCalculator& calculator, const CLIOptions& options, streambuf* stdoutBuffer) {
+    MappedFile file;
+    if (!file.open(options.rfm)) {
+        cerr << "❌ Error: Could not open " << options.rfm << endl;
+        return 1;
+    }
+    RFMData rfm;
+    vector<ImportError> errors;
+    parseRFMCSV(file.data(), file.size(), rfm, errors);
+    for (const auto& error : errors) {
+        cout << "⚠️  " << options.rfm << ":" << error.line << ": " << error.message << endl;
+    }
+    if (rfm.size() == 0) {
+        cerr << "❌ Error: " << options.rfm << " has no usable rows" << endl;
+        return 1;
+    }
+
+    string input = options.input.empty() ? "customers.json" : options.input;
+    bool haveTable = !options.input.empty() || statFile(input).inode != 0;
+    if (haveTable && !loadCLIInput(calculator, input, options)) return 1;
+
+    TaskPool pool(options.threads);
+    ProbabilisticCLV model(rfm, pool);
+    cout << "🧮 Fitting " << rfm.size() << " customers (" << model.repeatCustomers() << " repeat)" << endl;
+    FitSummary bgnbd = model.fitBGNBD();
+    FitSummary gammaGamma = model.fitGammaGamma();
+    printFitSummary(model, bgnbd, gammaGamma);
+    vector<CLVPrediction> predictions = model.predictAll(options.horizon, options.model.params.margin);
+
+    string text = "id,name,frequency,recency,T,monetary,probabilityAlive,expectedPurchases,expectedSpend,predictedCLV,clv\n";
+    auto appendRow = [&](size_t row, const Customer* customer) {
+        appendCSVField(text, rfm.ids[row]);
+        text += ',';
+        if (customer) appendCSVField(text, customer->name);
+        const CLVPrediction& prediction = predictions[row];
+        for (double value : {rfm.frequency[row], rfm.recency[row], rfm.age[row], rfm.monetary[row],
+                             prediction.probabilityAlive, prediction.expectedPurchases,
+                             prediction.expectedSpend, prediction.clv}) {
+            text += ',';
+            appendJSONNumber(text, value);
+        }
+        text += ',';
+        if (customer) appendJSONNumber(text, customer->clv);
+        text += '\n';
+    };
+    if (haveTable) {
+        unordered_map<string_view, size_t> rows;
+        rows.reserve(rfm.size());
+        for (size_t row = 0; row < rfm.size(); row++) rows.emplace(rfm.ids[row], row);
+        size_t missing = 0;
+        calculator.forEachCustomer([&](const Customer& customer) {
+            auto it = rows.find(customer.id);
+            if (it == rows.end()) missing++;
+            else appendRow(it->second, &customer);
+        });
+        if (missing > 0) cout << "⚠️  " << missing << " customers have no transaction history" << endl;
+    } else {
+        for (size_t row = 0; row < rfm.size(); row++) appendRow(row, nullptr);
+    }
+    return emitCLIOutput(options.output, stdoutBuffer, text) ? 0 : 1;
+}
+
+// Fit timing and accuracy on synthetic customers drawn from the parameters
+// Fader, Hardie & Lee report for the CDNOW dataset: 27-39 weeks of history and
+// a 39-week holdout. Prints a timing CSV (1, 2, 4, ... threads), a blank line,
+// then a CSV comparing the fitted parameters and holdout purchases to the truth.
+inline int runFitBenchmark(const CLIOptions& options, streambuf* stdoutBuffer) {
+    const BGNBDParams truePurchases{0.243, 4.414, 0.793, 2.426};
+    const GammaGammaParams trueSpend{6.25, 3.74, 15.44};
+    const double HOLDOUT = 39;
+    RFMData rfm;
+    vector<double> holdoutPurchases;
+    simulateRFM(options.count, truePurchases, trueSpend, 27, 39, HOLDOUT, 20050101, rfm, &holdoutPurchases);
+    cout << "🧪 Fitting " << rfm.size() << " synthetic customers" << endl;
+
+    auto elapsedMs = [](chrono::steady_clock::time_point since) {
+        return chrono::duration<double, milli>(chrono::steady_clock::now() - since).count();
+    };
+    string text = "threads,bgnbd_ms,gamma_gamma_ms,predict_ms,bgnbd_speedup,identical\n";
+    double baseFit = 0;
+    string baseline;
+    BGNBDParams fittedPurchases;
+    GammaGammaParams fittedSpend;
+    vector<CLVPrediction> predictions;
+    for (size_t threads = 1; ; threads = min(threads * 2, options.threads)) {
+        TaskPool pool(threads);
+        ProbabilisticCLV model(rfm, pool);
+        auto start = chrono::steady_clock::now();
+        FitSummary bgnbd = model.fitBGNBD();
+        double fitMs = elapsedMs(start);
+        start = chrono::steady_clock::now();
+        FitSummary gammaGamma = model.fitGammaGamma();
+        double spendMs = elapsedMs(start);
+        start = chrono::steady_clock::now();
+        predictions = model.predictAll(HOLDOUT, 1.0);
+        double predictMs = elapsedMs(start);
+        if (threads == 1) printFitSummary(model, bgnbd, gammaGamma);
+
+        fittedPurchases = model.bgnbd();
+        fittedSpend = model.gammaGamma();
+        string fingerprint;
+        for (double value : {fittedPurchases.r, fittedPurchases.alpha, fittedPurchases.a, fittedPurchases.b,
+                             fittedSpend.p, fittedSpend.q, fittedSpend.v}) {
+            appendJSONNumber(fingerprint, value);
+            fingerprint += ',';
+        }
+        if (threads == 1) {
+            baseFit = fitMs;
+            baseline = fingerprint;
+        }
+        char line[160];
+        snprintf(line, sizeof(line), "%zu,%.2f,%.2f,%.2f,%.2f,%s\n", threads, fitMs, spendMs, predictMs,
+                 baseFit / fitMs, fingerprint == baseline ? "true" : "false");
+        text += line;
+        if (threads >= options.threads) break;
+    }
+
+    double actual = 0, predicted = 0;
+    for (size_t row = 0; row < rfm.size(); row++) {
+        actual += holdoutPurchases[row];
+        predicted += predictions[row].expectedPurchases;
+    }
+    const pair<const char*, pair<double, double>> rows[] = {
+        {"r", {truePurchases.r, fittedPurchases.r}}, {"alpha", {truePurchases.alpha, fittedPurchases.alpha}},
+        {"a", {truePurchases.a, fittedPurchases.a}}, {"b", {truePurchases.b, fittedPurchases.b}},
+        {"p", {trueSpend.p, fittedSpend.p}}, {"q", {trueSpend.q, fittedSpend.q}}, {"v", {trueSpend.v, fittedSpend.v}},
+        {"holdout_purchases", {actual, predicted}}};
+    text += "\nquantity,true,fitted,relative_error\n";
+    for (const auto& row : rows) {
+        char line[160];
+        snprintf(line, sizeof(line), "%s,%.6g,%.6g,%.4f\n", row.first, row.second.first, row.second.second,
+                 (row.second.second - row.second.first) / row.second.first);
+        text += line;
+    }
+    return emitCLIOutput(options.output, stdoutBuffer, text) ? 0 : 1;
+}
+
+inline int runCLICommand(const CLIOptions& options, streambuf* stdoutBuffer) {
+    CLVCalculator calculator;
+    calculator.setVerbose(false);
+
+    if (options.command == "bench") {
+        return runBenchmark(calculator, options, stdoutBuffer);
+    }
+    if (options.command == "fit") {
+        return runFit(calculator, options, stdoutBuffer);
+    }
+    if (options.command == "fitbench") {
+        return runFitBenchmark(options, stdoutBuffer);
+    }
+
+    if (options.command == "import") {
+        // Merge into the output data file (created if missing)
+        string target = options.output.empty() ? "customers.json" : options.output;
+        if (statFile(target).inode != 0 && !loadCLIInput(calculator, target, options)) return 1;
+
+        size_t imported, rejected;
+        if (!importBulkFile(calculator, options.input, options, imported, rejected)) return 1;
+        if (!saveCLIOutput(calculator, target, stdoutBuffer)) return 1;
+
+        string summary = "{\"imported\":" + to_string(imported) + ",\"rejected\":" + to_string(rejected) +
+                         ",\"totalCustomers\":" + to_string(calculator.getCustomerCount()) + "}\n";
+        if (!emitCLIOutput("", stdoutBuffer, summary)) return 1;
+        return rejected > 0 ? 3 : 0;  // The accepted rows are saved either way
+    }
+
+    string input = options.input.empty() ? "customers.json" : options.input;
+    if (!loadCLIInput(calculator, input, options)) return 1;
+    CLVModel model = cliModel(options, calculator.getModel());
+    if (model != calculator.getModel()) calculator.recomputeAll(model);
+
+    if (options.command == "export") {
+        return saveCLIOutput(calculator, options.output, stdoutBuffer) ? 0 : 1;
+    }
+
+    string text;
+    if (options.command == "simulate") {
+        // Per-customer CLV bands as CSV; the portfolio band goes to the log
+        TaskPool pool(options.threads);
+        calculator.setTaskPool(pool);
+        vector<CLVInterval> intervals;
+        CLVInterval total = calculator.simulateCLV(options.montecarlo, model, &intervals);
+        calculator.setTaskPool(TaskPool::shared());
+        cout << "🎲 Total CLV over " << options.montecarlo.draws << " draws: mean " << total.mean << ", P5 "
+             << total.p5 << ", P50 " << total.p50 << ", P95 " << total.p95 << endl;
+        text = "id,name,clv,mean,p5,p50,p95\n";
+        size_t row = 0;
+        calculator.forEachCustomer([&](const Customer& customer) {
+            const CLVInterval& interval = intervals[row++];
+            appendCSVField(text, customer.id);
+            text += ',';
+            appendCSVField(text, customer.name);
+            for (double value : {customer.clv, interval.mean, interval.p5, interval.p50, interval.p95}) {
+                text += ',';
+                appendJSONNumber(text, value);
+            }
+            text += '\n';
+        });
+    } else if (options.command == "top") {
+        text = "rank,id,name,averagePurchaseValue,purchaseFrequency,customerLifespan,clv\n";
+        vector<Customer> top = calculator.getTopCustomers(options.count);
+        for (size_t i = 0; i < top.size(); i++) {
+            text += to_string(i + 1) + ',';
+            appendCSVField(text, top[i].id);
+            text += ',';
+            appendCSVField(text, top[i].name);
+            for (double value : {top[i].averagePurchaseValue, top[i].purchaseFrequency,
+                                 top[i].customerLifespan, top[i].clv}) {
+                text += ',';
+                appendJSONNumber(text, value);
+            }
+            text += '\n';
+        }
+    } else {
+        CLVAnalytics analytics = calculator.getAnalytics();
+        CLVDistribution distribution = calculator.getDistribution({0.1, 0.25, 0.5, 0.75, 0.9, 0.99});
+        text = "{\"totalCustomers\":" + to_string(analytics.totalCustomers);
+        const pair<const char*, double> fields[] = {
+            {"totalCLV", analytics.totalCLV}, {"averageCLV", analytics.averageCLV},
+            {"highestCLV", analytics.highestCLV}, {"lowestCLV", analytics.lowestCLV},
+            {"varianceCLV", analytics.varianceCLV}, {"standardDeviationCLV", analytics.standardDeviationCLV}};
+        for (const auto& field : fields) {
+            text += ",\"" + string(field.first) + "\":";
+            appendJSONNumber(text, field.second);
+        }
+        text += ",\"percentiles\":{";
+        for (size_t i = 0; i < distribution.percentiles.size(); i++) {
+            if (i > 0) text += ',';
+            text += "\"p" + to_string(static_cast<int>(distribution.percentiles[i].first * 100 + 0.5)) + "\":";
+            appendJSONNumber(text, distribution.percentiles[i].second);
+        }
+        text += "}}\n";
+    }
+    return emitCLIOutput(options.output, stdoutBuffer, text) ? 0 : 1;
+}
+
+// Entry point for `clv-calculator <command> ...`
+inline int runCLI(int argc, char* argv[]) {
+    CLIOptions options;
+    string error;
+    if (!parseCLIOptions(argc, argv, options, error)) {
+        cerr << "❌ Error: " << error << "\n" << CLI_USAGE;
+        return 2;
+    }
+
+    // Calculator messages are written to cout; keep stdout for results only
+    ostream discard(nullptr);
+    streambuf* stdoutBuffer = cout.rdbuf(options.quiet ? discard.rdbuf() : cerr.rdbuf());
+    int status = runCLICommand(options, stdoutBuffer);
+    cout.rdbuf(stdoutBuffer);
+    cout.clear();  // Writes to the discarded stream set badbit
+    return status;
+}
+
+#endif // CLV_CLI_HPP
@@ -0,0 +1,237 @@
+#ifndef CLV_MONTECARLO_HPP
+#define CLV_MONTECARLO_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "clv_models.hpp"
+#include "task_pool.hpp"
+
+// Monte Carlo CLV uncertainty.
+//
+// Each customer's AOV, frequency and lifespan are treated as the means of
+// distributions with a configured shape and coefficient of variation; every
+// draw samples all three and values them with a CLVModel. Per customer this
+// gives the mean and P5/P50/P95 of CLV, and summing draw d over all customers
+// gives the distribution of the portfolio total.
+//
+// Random numbers come from Philox4x32-10, a counter-based generator: the
+// numbers for (customer, input, draw) are a pure function of the seed and that
+// counter. A customer is identified by a 64-bit hash of its id, not its row, so
+// its stream survives deletes, reloads and reordering of the table. Any thread
+// can produce any customer's stream without coordination, and results are
+// identical for every thread count and chunking.
+
+// Philox4x32-10 (Salmon et al., "Parallel random numbers: as easy as 1, 2, 3")
+struct Philox4x32 {
+    uint32_t key[2];
+
+    explicit Philox4x32(uint64_t seed) {
+        key[0] = static_cast<uint32_t>(seed);
+        key[1] = static_cast<uint32_t>(seed >> 32);
+    }
+
+    // Four independent 32-bit outputs for one 128-bit counter
+    void operator()(const uint32_t counter[4], uint32_t out[4]) const {
+        uint32_t c0 = counter[0], c1 = counter[1], c2 = counter[2], c3 = counter[3];
+        uint32_t k0 = key[0], k1 = key[1];
+        for (int round = 0; round < 10; round++) {
+            uint64_t product0 = static_cast<uint64_t>(0xD2511F53u) * c0;
+            uint64_t product1 = static_cast<uint64_t>(0xCD9E8D57u) * c2;
+            uint32_t next0 = static_cast<uint32_t>(product1 >> 32) ^ c1 ^ k0;
+            uint32_t next2 = static_cast<uint32_t>(product0 >> 32) ^ c3 ^ k1;
+            c1 = static_cast<uint32_t>(product1);
+            c3 = static_cast<uint32_t>(product0);
+            c0 = next0;
+            c2 = next2;
+            k0 += 0x9E3779B9u;
+            k1 += 0xBB67AE85u;
+        }
+        out[0] = c0;
+        out[1] = c1;
+        out[2] = c2;
+        out[3] = c3;
+    }
+};
+
+enum class InputDistribution { LOGNORMAL, NORMAL, UNIFORM };
+
+// How one input varies around a customer's point estimate m: standard deviation cv × m
+struct InputUncertainty {
+    InputDistribution distribution = InputDistribution::LOGNORMAL;
+    double cv = 0.2;
+
+    // "lognormal", "normal" or "uniform"
+    static bool parseDistribution(const std::string& name, InputDistribution& distribution) {
+        if (name == "lognormal") distribution = InputDistribution::LOGNORMAL;
+        else if (name == "normal") distribution = InputDistribution::NORMAL;
+        else if (name == "uniform") distribution = InputDistribution::UNIFORM;
+        else return false;
+        return true;
+    }
+};
+
+struct MonteCarloSettings {
+    size_t draws = 1000;
+    uint64_t seed = 1;
+    InputUncertainty aov;
+    InputUncertainty frequency;
+    InputUncertainty lifespan;
+
+    // Empty if usable, otherwise what is wrong
+    std::string validate() const {
+        if (draws < 2 || draws > 100000) return "draws must be between 2 and 100000";
+        for (const InputUncertainty* input : {&aov, &frequency, &lifespan}) {
+            if (!(input->cv >= 0) || !(input->cv <= 10)) return "cv must be between 0 and 10";
+            if (input->distribution == InputDistribution::UNIFORM && input->cv > 1 / std::sqrt(3.0)) {
+                return "uniform cv must be at most 0.577 (the range would include negative values)";
+            }
+        }
+        return "";
+    }
+};
+
+struct CLVInterval {
+    double mean = 0;
+    double p5 = 0;
+    double p50 = 0;
+    double p95 = 0;
+};
+
+namespace montecarlo_detail {
+
+// Linear-interpolated quantile of values (reordered in place)
+inline double quantile(std::vector<double>& values, size_t count, double q) {
+    double position = (count - 1) * q;
+    size_t lower = static_cast<size_t>(position);
+    std::nth_element(values.begin(), values.begin() + lower, values.begin() + count);
+    double result = values[lower];
+    double fraction = position - lower;
+    if (fraction > 0) {
+        double next = *std::min_element(values.begin() + lower + 1, values.begin() + count);
+        result += fraction * (next - result);
+    }
+    return result;
+}
+
+inline CLVInterval summarize(std::vector<double>& values, size_t count) {
+    CLVInterval interval;
+    double total = 0;
+    for (size_t i = 0; i < count; i++) total += values[i];
+    interval.mean = total / count;
+    interval.p50 = quantile(values, count, 0.50);
+    interval.p5 = quantile(values, count, 0.05);
+    interval.p95 = quantile(values, count, 0.95);
+    return interval;
+}
+
+// Uniform in (0, 1) from the top 53 bits of two 32-bit words
+inline double unitInterval(uint32_t high, uint32_t low) {
+    uint64_t bits = (static_cast<uint64_t>(high) << 21) ^ (low >> 11);
+    return (static_cast<double>(bits) + 0.5) * (1.0 / 9007199254740992.0);
+}
+
+// Stable 64-bit stream key of a customer id: FNV-1a, then the SplitMix64
+// finalizer so ids differing in one character land far apart
+inline uint64_t streamKey(std::string_view id) {
+    uint64_t hash = 0xCBF29CE484222325ull;
+    for (unsigned char c : id) {
+        hash ^= c;
+        hash *= 0x100000001B3ull;
+    }
+    hash ^= hash >> 30;
+    hash *= 0xBF58476D1CE4E5B9ull;
+    hash ^= hash >> 27;
+    hash *= 0x94D049BB133111EBull;
+    return hash ^ (hash >> 31);
+}
+
+// out[d] for d < draws: samples of an input with mean m. Input number `input`
+// of the customer with stream key `key` owns the counters (pair, input, key low,
+// key high); each counter yields the draws 2 pair and 2 pair + 1.
+inline void sampleInput(const Philox4x32& philox, uint64_t key, uint32_t input, double m,
+                        const InputUncertainty& uncertainty, double* out, size_t draws) {
+    if (uncertainty.cv == 0) {
+        std::fill(out, out + draws, m);
+        return;
+    }
+    // Lognormal with mean m: exp(mu + sigma z), sigma² = ln(1 + cv²), mu = ln m - sigma²/2
+    double sigma = std::sqrt(std::log1p(uncertainty.cv * uncertainty.cv));
+    double logMean = std::log(m) - 0.5 * sigma * sigma;
+    double halfWidth = uncertainty.cv * std::sqrt(3.0);  // Uniform m(1 ± halfWidth) has sd cv × m
+    const double TWO_PI = 6.283185307179586;
+
+    uint32_t counter[4] = {0, input, static_cast<uint32_t>(key), static_cast<uint32_t>(key >> 32)};
+    uint32_t bits[4];
+    for (size_t d = 0; d < draws; d += 2) {
+        counter[0] = static_cast<uint32_t>(d / 2);
+        philox(counter, bits);
+        double u1 = unitInterval(bits[0], bits[1]);
+        double u2 = unitInterval(bits[2], bits[3]);
+        double x0, x1;
+        if (uncertainty.distribution == InputDistribution::UNIFORM) {
+            x0 = m * (1 + halfWidth * (2 * u1 - 1));
+            x1 = m * (1 + halfWidth * (2 * u2 - 1));
+        } else {
+            // Box-Muller: two independent standard normals
+            double radius = std::sqrt(-2 * std::log(u1));
+            double z0 = radius * std::cos(TWO_PI * u2);
+            double z1 = radius * std::sin(TWO_PI * u2);
+            if (uncertainty.distribution == InputDistribution::LOGNORMAL) {
+                x0 = std::exp(logMean + sigma * z0);
+                x1 = std::exp(logMean + sigma * z1);
+            } else {
+                // Normal, clipped at zero
+                x0 = std::max(0.0, m * (1 + uncertainty.cv * z0));
+                x1 = std::max(0.0, m * (1 + uncertainty.cv * z1));
+            }
+        }
+        out[d] = x0;
+        if (d + 1 < draws) out[d + 1] = x1;
+    }
+}
+
+} // namespace montecarlo_detail
+
+// Run the simulation over count rows of the metric columns; ids[row] keys each
+// row's random streams. Returns the interval of the portfolio total;
+// perCustomer (if given) receives one interval per row.
+inline CLVInterval simulateCLVColumns(TaskPool& pool, const CLVModel& model, const MonteCarloSettings& settings,
+                                      const std::string* ids, const double* aov, const double* freq,
+                                      const double* lifespan, size_t count, std::vector<CLVInterval>* perCustomer) {
+    using namespace montecarlo_detail;
+    const size_t draws = settings.draws;
+    const size_t GRAIN = 1024;  // Customers per chunk
+    Philox4x32 philox(settings.seed);
+    if (perCustomer) perCustomer->assign(count, CLVInterval());
+
+    // Each chunk returns its per-draw CLV totals; chunks are added in order
+    std::vector<double> totals = pool.parallelReduce(count, GRAIN, std::vector<double>(),
+        [&](size_t begin, size_t end) {
+            std::vector<double> chunkTotals(draws, 0.0);
+            std::vector<double> a(draws), f(draws), l(draws), clv(draws);
+            for (size_t row = begin; row < end; row++) {
+                uint64_t key = streamKey(ids[row]);
+                sampleInput(philox, key, 0, aov[row], settings.aov, a.data(), draws);
+                sampleInput(philox, key, 1, freq[row], settings.frequency, f.data(), draws);
+                sampleInput(philox, key, 2, lifespan[row], settings.lifespan, l.data(), draws);
+                model.evaluate(a.data(), f.data(), l.data(), clv.data(), draws);
+                for (size_t d = 0; d < draws; d++) chunkTotals[d] += clv[d];
+                if (perCustomer) (*perCustomer)[row] = summarize(clv, draws);
+            }
+            return chunkTotals;
+        },
+        [](std::vector<double> total, std::vector<double> part) {
+            if (total.empty()) return part;
+            for (size_t d = 0; d < part.size(); d++) total[d] += part[d];
+            return total;
+        });
+
+    if (totals.empty()) return CLVInterval();
+    return summarize(totals, draws);
+}
+
+#endif // CLV_MONTECARLO_HPP
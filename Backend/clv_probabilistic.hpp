@@ -0,0 +1,483 @@
+#ifndef CLV_PROBABILISTIC_HPP
+#define CLV_PROBABILISTIC_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+#include "bulk_import.hpp"
+#include "task_pool.hpp"
+
+// Probabilistic CLV from transaction history: BG/NBD for the number of future
+// purchases and Gamma-Gamma for their value (Fader, Hardie & Lee 2005).
+//
+// Input is one summary per customer, all times in the same unit (e.g. weeks):
+//   frequency x  - repeat purchases (purchases after the first one)
+//   recency t_x  - age of the customer at the last purchase (0 if x = 0)
+//   T            - age of the customer (time since the first purchase)
+//   monetary m   - mean value of the repeat purchases (0 if x = 0)
+//
+// Parameters are fitted by maximum likelihood with Nelder-Mead on their logs.
+// A likelihood evaluation is one pass over flat columns, split over the task
+// pool: the lgamma terms only depend on the frequency, so they are computed
+// once per distinct frequency and looked up, which leaves a branch-free loop of
+// a few log/exp calls per customer. Chunks are summed in a fixed order, so the
+// fitted parameters are the same for any thread count.
+
+struct RFMData {
+    std::vector<std::string> ids;
+    std::vector<double> frequency;
+    std::vector<double> recency;
+    std::vector<double> age;
+    std::vector<double> monetary;
+
+    size_t size() const { return ids.size(); }
+
+    void add(std::string id, double x, double tx, double T, double m) {
+        ids.push_back(std::move(id));
+        frequency.push_back(x);
+        recency.push_back(tx);
+        age.push_back(T);
+        monetary.push_back(m);
+    }
+};
+
+// Empty if the summary is consistent, otherwise what is wrong with it
+inline std::string rfmProblem(double x, double tx, double T, double m) {
+    if (!(x >= 0) || x != std::floor(x) || x > 1e9) return "frequency must be a whole number >= 0";
+    if (!(T > 0) || std::isinf(T)) return "T must be a positive number";
+    if (!(tx >= 0) || tx > T) return "recency must be between 0 and T";
+    if (x == 0 && tx != 0) return "recency must be 0 when frequency is 0";
+    if (x > 0 && (!(m > 0) || std::isinf(m))) return "monetary must be positive when frequency > 0";
+    return "";
+}
+
+// CSV with a header naming id, frequency, recency, T (or age) and monetary
+// (or monetary_value), in any order - the layout lifetimes' summary tables use
+inline void parseRFMCSV(const char* data, size_t size, RFMData& out, std::vector<ImportError>& errors) {
+    using namespace bulk_import_detail;
+    if (size >= 3 && std::memcmp(data, "\xEF\xBB\xBF", 3) == 0) {
+        data += 3;
+        size -= 3;
+    }
+
+    int id = -1, x = -1, tx = -1, T = -1, m = -1, count = 0;
+    std::vector<std::string_view> fields;
+    std::vector<std::string> storage;
+    std::string error;
+    forEachLine(data, data + size, [&](std::string_view line, size_t lineNumber) {
+        if (trimmed(line).empty()) return;
+        if (!splitCSVLine(line, fields, storage, error)) {
+            errors.push_back(ImportError{lineNumber, error});
+            return;
+        }
+        if (count == 0) {
+            for (size_t i = 0; i < fields.size(); i++) {
+                int index = static_cast<int>(i);
+                if (equalsIgnoreCase(fields[i], "id")) id = index;
+                else if (equalsIgnoreCase(fields[i], "frequency")) x = index;
+                else if (equalsIgnoreCase(fields[i], "recency")) tx = index;
+                else if (equalsIgnoreCase(fields[i], "T") || equalsIgnoreCase(fields[i], "age")) T = index;
+                else if (equalsIgnoreCase(fields[i], "monetary") || equalsIgnoreCase(fields[i], "monetary_value")) m = index;
+            }
+            count = static_cast<int>(fields.size());
+            if (id < 0 || x < 0 || tx < 0 || T < 0 || m < 0) {
+                errors.push_back(ImportError{lineNumber, "CSV header must name id, frequency, recency, T and monetary"});
+                count = -1;
+            }
+            return;
+        }
+        if (count < 0) return;
+        if (static_cast<int>(fields.size()) < count) {
+            errors.push_back(ImportError{lineNumber, "expected " + std::to_string(count) +
+                                                     " fields, found " + std::to_string(fields.size())});
+            return;
+        }
+
+        double values[4];
+        if (!parseNumber(fields[x], values[0]) || !parseNumber(fields[tx], values[1]) ||
+            !parseNumber(fields[T], values[2]) || !parseNumber(fields[m], values[3])) {
+            errors.push_back(ImportError{lineNumber, "frequency, recency, T and monetary must be numbers"});
+            return;
+        }
+        std::string problem = rfmProblem(values[0], values[1], values[2], values[3]);
+        if (fields[id].empty()) problem = "id must not be empty";
+        if (!problem.empty()) {
+            errors.push_back(ImportError{lineNumber, problem});
+            return;
+        }
+        out.add(std::string(fields[id]), values[0], values[1], values[2], values[0] > 0 ? values[3] : 0);
+    });
+}
+
+// Purchase process: purchase rate ~ Gamma(r, alpha), dropout after each purchase ~ Beta(a, b)
+struct BGNBDParams {
+    double r = 1;
+    double alpha = 1;
+    double a = 1;
+    double b = 1;
+};
+
+// Spend per purchase ~ Gamma(p, nu) with nu ~ Gamma(q, v) per customer
+struct GammaGammaParams {
+    double p = 1;
+    double q = 1;
+    double v = 1;
+};
+
+struct FitSummary {
+    double logLikelihood = 0;  // At the fitted parameters, summed over the customers used
+    size_t evaluations = 0;    // Likelihood passes over the data
+    bool converged = false;
+};
+
+struct CLVPrediction {
+    double probabilityAlive = 0;
+    double expectedPurchases = 0;  // Over the horizon
+    double expectedSpend = 0;      // Per purchase
+    double clv = 0;                // margin × expectedPurchases × expectedSpend
+};
+
+namespace probabilistic_detail {
+
+struct SimplexResult {
+    std::vector<double> point;
+    double value;
+    size_t evaluations;
+    bool converged;
+};
+
+// Minimize f from start (Nelder-Mead with the usual 1, 2, 1/2, 1/2 coefficients).
+// Stops when the simplex is within tolerance in both position and value.
+inline SimplexResult nelderMead(const std::function<double(const std::vector<double>&)>& f,
+                                const std::vector<double>& start, double step, double tolerance,
+                                size_t maxEvaluations) {
+    size_t n = start.size();
+    std::vector<std::vector<double>> simplex(n + 1, start);
+    std::vector<double> values(n + 1);
+    size_t evaluations = 0;
+    auto evaluate = [&](const std::vector<double>& point) {
+        evaluations++;
+        double value = f(point);
+        return std::isnan(value) ? std::numeric_limits<double>::infinity() : value;
+    };
+    for (size_t i = 0; i < n; i++) simplex[i + 1][i] += step;
+    for (size_t i = 0; i <= n; i++) values[i] = evaluate(simplex[i]);
+
+    std::vector<size_t> order(n + 1);
+    std::vector<double> centroid(n), reflected(n), trial(n);
+    auto along = [&](double t, std::vector<double>& out) {
+        for (size_t j = 0; j < n; j++) out[j] = centroid[j] + t * (simplex[order[n]][j] - centroid[j]);
+    };
+    bool converged = false;
+    while (evaluations < maxEvaluations) {
+        for (size_t i = 0; i <= n; i++) order[i] = i;
+        std::sort(order.begin(), order.end(), [&](size_t x, size_t y) { return values[x] < values[y]; });
+
+        double spread = 0, valueSpread = 0;
+        for (size_t i = 1; i <= n; i++) {
+            valueSpread = std::max(valueSpread, std::fabs(values[order[i]] - values[order[0]]));
+            for (size_t j = 0; j < n; j++) {
+                spread = std::max(spread, std::fabs(simplex[order[i]][j] - simplex[order[0]][j]));
+            }
+        }
+        if (spread <= tolerance && valueSpread <= tolerance) {
+            converged = true;
+            break;
+        }
+
+        std::fill(centroid.begin(), centroid.end(), 0.0);
+        for (size_t i = 0; i < n; i++) {
+            for (size_t j = 0; j < n; j++) centroid[j] += simplex[order[i]][j] / n;
+        }
+        size_t worst = order[n];
+        along(-1.0, reflected);
+        double reflectedValue = evaluate(reflected);
+        if (reflectedValue < values[order[0]]) {
+            along(-2.0, trial);
+            double expandedValue = evaluate(trial);
+            if (expandedValue < reflectedValue) {
+                simplex[worst] = trial;
+                values[worst] = expandedValue;
+            } else {
+                simplex[worst] = reflected;
+                values[worst] = reflectedValue;
+            }
+        } else if (reflectedValue < values[order[n - 1]]) {
+            simplex[worst] = reflected;
+            values[worst] = reflectedValue;
+        } else {
+            // Contract towards the better of the worst point and its reflection
+            bool outside = reflectedValue < values[worst];
+            along(outside ? -0.5 : 0.5, trial);
+            double contractedValue = evaluate(trial);
+            if (contractedValue < (outside ? reflectedValue : values[worst])) {
+                simplex[worst] = trial;
+                values[worst] = contractedValue;
+            } else {
+                for (size_t i = 1; i <= n; i++) {
+                    std::vector<double>& point = simplex[order[i]];
+                    for (size_t j = 0; j < n; j++) {
+                        point[j] = simplex[order[0]][j] + 0.5 * (point[j] - simplex[order[0]][j]);
+                    }
+                    values[order[i]] = evaluate(point);
+                }
+            }
+        }
+    }
+
+    size_t best = std::min_element(values.begin(), values.end()) - values.begin();
+    return SimplexResult{simplex[best], values[best], evaluations, converged};
+}
+
+// Gauss hypergeometric 2F1(a, b; c; z) by its power series, for 0 <= z < 1
+inline double hypergeometric2F1(double a, double b, double c, double z) {
+    double sum = 1, term = 1;
+    for (size_t k = 0; k < 100000; k++) {
+        term *= (a + k) * (b + k) / ((c + k) * (k + 1)) * z;
+        sum += term;
+        if (std::fabs(term) <= 1e-15 * std::fabs(sum)) break;
+    }
+    return sum;
+}
+
+} // namespace probabilistic_detail
+
+// Fits and scores the two models over one RFMData, which must outlive it
+class ProbabilisticCLV {
+    const RFMData& data;
+    TaskPool* pool;
+
+    // Distinct frequencies, and each customer's index into them
+    std::vector<double> distinctFrequencies;
+    std::vector<uint32_t> frequencyIndex;
+
+    // Gamma-Gamma uses the repeat customers (x > 0) only
+    std::vector<uint32_t> repeatIndex;
+    std::vector<double> repeatFrequency;
+    std::vector<double> repeatMonetary;
+    std::vector<double> repeatLogMonetary;
+
+    BGNBDParams bgnbdParams;
+    GammaGammaParams gammaGammaParams;
+
+    static const size_t MAX_EVALUATIONS = 4000;
+
+    template<typename Map>
+    double sumChunks(size_t count, Map map) const {
+        return pool->parallelReduce(count, TaskPool::DEFAULT_GRAIN, 0.0, map,
+                                    [](double total, double part) { return total + part; });
+    }
+
+public:
+    explicit ProbabilisticCLV(const RFMData& rfm, TaskPool& taskPool = TaskPool::shared())
+        : data(rfm), pool(&taskPool) {
+        distinctFrequencies = data.frequency;
+        std::sort(distinctFrequencies.begin(), distinctFrequencies.end());
+        distinctFrequencies.erase(std::unique(distinctFrequencies.begin(), distinctFrequencies.end()),
+                                  distinctFrequencies.end());
+        frequencyIndex.resize(data.size());
+        for (size_t i = 0; i < data.size(); i++) {
+            size_t index = std::lower_bound(distinctFrequencies.begin(), distinctFrequencies.end(), data.frequency[i]) -
+                           distinctFrequencies.begin();
+            frequencyIndex[i] = static_cast<uint32_t>(index);
+            if (data.frequency[i] > 0) {
+                repeatIndex.push_back(frequencyIndex[i]);
+                repeatFrequency.push_back(data.frequency[i]);
+                repeatMonetary.push_back(data.monetary[i]);
+                repeatLogMonetary.push_back(std::log(data.monetary[i]));
+            }
+        }
+    }
+
+    size_t repeatCustomers() const { return repeatFrequency.size(); }
+
+    const BGNBDParams& bgnbd() const { return bgnbdParams; }
+    const GammaGammaParams& gammaGamma() const { return gammaGammaParams; }
+    void setBGNBD(const BGNBDParams& params) { bgnbdParams = params; }
+    void setGammaGamma(const GammaGammaParams& params) { gammaGammaParams = params; }
+
+    // BG/NBD log-likelihood summed over all customers:
+    //   ln Γ(r+x) - ln Γ(r) + r ln α + ln B(a, b+x) - ln B(a, b)
+    //   + ln[(α+T)^-(r+x) + [x > 0] a/(b+x-1) (α+t_x)^-(r+x)]
+    double bgnbdLogLikelihood(const BGNBDParams& params) const {
+        const double r = params.r, alpha = params.alpha, a = params.a, b = params.b;
+        std::vector<double> countTerm(distinctFrequencies.size()), dropoutTerm(distinctFrequencies.size());
+        double base = std::lgamma(a + b) - std::lgamma(b) - std::lgamma(r);
+        for (size_t k = 0; k < distinctFrequencies.size(); k++) {
+            double x = distinctFrequencies[k];
+            countTerm[k] = base + std::lgamma(r + x) + std::lgamma(b + x) - std::lgamma(a + b + x);
+            dropoutTerm[k] = x > 0 ? std::log(a) - std::log(b + x - 1) : -std::numeric_limits<double>::infinity();
+        }
+
+        const double* frequency = data.frequency.data();
+        const double* recency = data.recency.data();
+        const double* age = data.age.data();
+        const uint32_t* index = frequencyIndex.data();
+        double total = sumChunks(data.size(), [&](size_t begin, size_t end) {
+            double sum = 0;
+            for (size_t i = begin; i < end; i++) {
+                double rx = r + frequency[i];
+                double alive = -rx * std::log(alpha + age[i]);
+                double dropped = dropoutTerm[index[i]] - rx * std::log(alpha + recency[i]);
+                double high = std::max(alive, dropped);
+                sum += countTerm[index[i]] + high + std::log1p(std::exp(std::min(alive, dropped) - high));
+            }
+            return sum;
+        });
+        return total + data.size() * r * std::log(alpha);
+    }
+
+    // Gamma-Gamma log-likelihood of the mean spends m of the repeat customers:
+    //   ln Γ(px+q) - ln Γ(px) - ln Γ(q) + q ln v + (px-1) ln m + px ln x - (px+q) ln(xm+v)
+    double gammaGammaLogLikelihood(const GammaGammaParams& params) const {
+        const double p = params.p, q = params.q, v = params.v;
+        std::vector<double> countTerm(distinctFrequencies.size(), 0.0);
+        for (size_t k = 0; k < distinctFrequencies.size(); k++) {
+            double x = distinctFrequencies[k];
+            if (x > 0) countTerm[k] = std::lgamma(p * x + q) - std::lgamma(p * x) + p * x * std::log(x);
+        }
+
+        const double* frequency = repeatFrequency.data();
+        const double* monetary = repeatMonetary.data();
+        const double* logMonetary = repeatLogMonetary.data();
+        const uint32_t* index = repeatIndex.data();
+        double total = sumChunks(repeatFrequency.size(), [&](size_t begin, size_t end) {
+            double sum = 0;
+            for (size_t i = begin; i < end; i++) {
+                double px = p * frequency[i];
+                sum += countTerm[index[i]] + (px - 1) * logMonetary[i] - (px + q) * std::log(frequency[i] * monetary[i] + v);
+            }
+            return sum;
+        });
+        return total + repeatFrequency.size() * (q * std::log(v) - std::lgamma(q));
+    }
+
+    // Maximum-likelihood BG/NBD parameters, starting from the current ones
+    FitSummary fitBGNBD() {
+        FitSummary summary;
+        if (data.size() == 0) return summary;
+        double scale = 1.0 / data.size();
+        std::vector<double> start = {std::log(bgnbdParams.r), std::log(bgnbdParams.alpha),
+                                     std::log(bgnbdParams.a), std::log(bgnbdParams.b)};
+        auto result = probabilistic_detail::nelderMead([&](const std::vector<double>& logs) {
+            BGNBDParams params{std::exp(logs[0]), std::exp(logs[1]), std::exp(logs[2]), std::exp(logs[3])};
+            return -bgnbdLogLikelihood(params) * scale;
+        }, start, 0.5, 1e-9, MAX_EVALUATIONS);
+
+        bgnbdParams = BGNBDParams{std::exp(result.point[0]), std::exp(result.point[1]),
+                                  std::exp(result.point[2]), std::exp(result.point[3])};
+        summary.logLikelihood = -result.value * data.size();
+        summary.evaluations = result.evaluations;
+        summary.converged = result.converged;
+        return summary;
+    }
+
+    // Maximum-likelihood Gamma-Gamma parameters from the repeat customers
+    FitSummary fitGammaGamma() {
+        FitSummary summary;
+        if (repeatFrequency.empty()) return summary;
+        double scale = 1.0 / repeatFrequency.size();
+        std::vector<double> start = {std::log(gammaGammaParams.p), std::log(gammaGammaParams.q),
+                                     std::log(gammaGammaParams.v)};
+        auto result = probabilistic_detail::nelderMead([&](const std::vector<double>& logs) {
+            GammaGammaParams params{std::exp(logs[0]), std::exp(logs[1]), std::exp(logs[2])};
+            return -gammaGammaLogLikelihood(params) * scale;
+        }, start, 0.5, 1e-9, MAX_EVALUATIONS);
+
+        gammaGammaParams = GammaGammaParams{std::exp(result.point[0]), std::exp(result.point[1]),
+                                            std::exp(result.point[2])};
+        summary.logLikelihood = -result.value * repeatFrequency.size();
+        summary.evaluations = result.evaluations;
+        summary.converged = result.converged;
+        return summary;
+    }
+
+    // Prediction for one customer over the next horizon time units
+    CLVPrediction predict(size_t row, double horizon, double margin) const {
+        const double r = bgnbdParams.r, alpha = bgnbdParams.alpha, b = bgnbdParams.b;
+        double a = bgnbdParams.a;
+        if (std::fabs(a - 1) < 1e-9) a = 1 + 1e-9;  // E[Y] has a removable singularity at a = 1
+        double x = data.frequency[row], tx = data.recency[row], T = data.age[row];
+
+        CLVPrediction prediction;
+        // P(alive) = 1 / (1 + [x > 0] a/(b+x-1) ((α+T)/(α+t_x))^(r+x)), odds taken in logs
+        double logOdds = x > 0
+            ? std::log(a) - std::log(b + x - 1) + (r + x) * (std::log(alpha + T) - std::log(alpha + tx))
+            : -std::numeric_limits<double>::infinity();
+        prediction.probabilityAlive = 1 / (1 + std::exp(logOdds));
+
+        // E[Y(t)] = (a+b+x-1)/(a-1) [1 - ((α+T)/(α+T+t))^(r+x) 2F1(r+x, b+x; a+b+x-1; z)] P(alive),
+        // z = t/(α+T+t). Euler's transformation turns the power and the series into
+        // (1-z)^(a-1) 2F1(a+b-1-r, a-1; a+b+x-1; z), which does not overflow for large x.
+        double z = horizon / (alpha + T + horizon);
+        double remaining = std::pow(1 - z, a - 1) *
+                           probabilistic_detail::hypergeometric2F1(a + b - 1 - r, a - 1, a + b + x - 1, z);
+        prediction.expectedPurchases = (a + b + x - 1) / (a - 1) * (1 - remaining) * prediction.probabilityAlive;
+
+        // E[M | x, m] = p (v + x m) / (px + q - 1); without a finite prior mean (q <= 1),
+        // fall back to the customer's own mean
+        const double p = gammaGammaParams.p, q = gammaGammaParams.q, v = gammaGammaParams.v;
+        prediction.expectedSpend = q > 1 ? p * (v + x * data.monetary[row]) / (p * x + q - 1) : data.monetary[row];
+        prediction.clv = margin * prediction.expectedPurchases * prediction.expectedSpend;
+        return prediction;
+    }
+
+    // Predictions for every customer, in row order
+    std::vector<CLVPrediction> predictAll(double horizon, double margin) const {
+        std::vector<CLVPrediction> predictions(data.size());
+        pool->parallelFor(data.size(), 4096, [&](size_t begin, size_t end) {
+            for (size_t row = begin; row < end; row++) {
+                predictions[row] = predict(row, horizon, margin);
+            }
+        });
+        return predictions;
+    }
+};
+
+// Synthetic customers drawn from known parameters, for checking a fit. Each
+// customer is observed for T in [minAge, maxAge]; holdoutPurchases (if given)
+// receives the purchases each one makes in the following holdout time units.
+inline void simulateRFM(size_t count, const BGNBDParams& bgnbd, const GammaGammaParams& gammaGamma,
+                        double minAge, double maxAge, double holdout, uint64_t seed,
+                        RFMData& out, std::vector<double>* holdoutPurchases) {
+    std::mt19937_64 random(seed);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    std::gamma_distribution<double> rate(bgnbd.r, 1 / bgnbd.alpha);
+    std::gamma_distribution<double> dropoutA(bgnbd.a, 1.0), dropoutB(bgnbd.b, 1.0);
+    std::gamma_distribution<double> spendRate(gammaGamma.q, 1 / gammaGamma.v);
+
+    for (size_t i = 0; i < count; i++) {
+        double lambda = std::max(rate(random), 1e-300);
+        double dropA = dropoutA(random);
+        double dropout = dropA / (dropA + dropoutB(random));
+        double nu = spendRate(random);
+        std::gamma_distribution<double> spend(gammaGamma.p, 1 / nu);
+        std::exponential_distribution<double> wait(lambda);
+        double T = minAge + (maxAge - minAge) * unit(random);
+
+        // Purchases arrive at rate lambda until the customer drops out after one of them
+        double t = 0, tx = 0, total = 0, later = 0;
+        size_t x = 0;
+        while (true) {
+            t += wait(random);
+            if (t > T + holdout) break;
+            if (t <= T) {
+                x++;
+                tx = t;
+                total += spend(random);
+            } else {
+                later++;
+            }
+            if (unit(random) < dropout) break;
+        }
+        out.add("S" + std::to_string(i), static_cast<double>(x), tx, T, x > 0 ? total / x : 0);
+        if (holdoutPurchases) holdoutPurchases->push_back(later);
+    }
+}
+
+#endif // CLV_PROBABILISTIC_HPP
@@ -0,0 +1,231 @@
+#ifndef CLV_SCENARIOS_HPP
+#define CLV_SCENARIOS_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <string>
+#include <utility>
+#include <vector>
+#include "clv_models.hpp"
+#include "customer_json.hpp"
+#include "task_pool.hpp"
+
+// What-if scenarios: "frequency +10% for customers with AOV >= 2000".
+//
+// A scenario scales the metrics of the customers its filter matches and
+// reports the resulting CLV total, mean and top customers. Stored data is
+// never modified or copied: the adjusted metrics of a block of rows are
+// written to small block-local buffers (an overlay) and valued there.
+//
+// All scenarios of a request are evaluated in one fused scan. The table is
+// walked block by block, and every scenario processes a block while it is
+// still in L1, so memory traffic is one pass no matter how many scenarios
+// there are. Filtering is a branch-free select, and valuation uses the
+// CLVModel column kernels (AVX2/AVX-512 where available). Chunks run on the
+// task pool and are merged in chunk order, so results do not depend on the
+// thread count.
+
+// A customer matches when every metric lies in its [min, max] range
+struct ScenarioFilter {
+    double minAOV = -std::numeric_limits<double>::infinity();
+    double maxAOV = std::numeric_limits<double>::infinity();
+    double minFrequency = -std::numeric_limits<double>::infinity();
+    double maxFrequency = std::numeric_limits<double>::infinity();
+    double minLifespan = -std::numeric_limits<double>::infinity();
+    double maxLifespan = std::numeric_limits<double>::infinity();
+
+    bool matches(double aov, double freq, double lifespan) const {
+        return (aov >= minAOV) & (aov <= maxAOV) & (freq >= minFrequency) & (freq <= maxFrequency) &
+               (lifespan >= minLifespan) & (lifespan <= maxLifespan);
+    }
+};
+
+struct Scenario {
+    std::string name;
+    ScenarioFilter filter;
+    double aovFactor = 1;        // Multipliers for matching customers (1.1 = +10%)
+    double frequencyFactor = 1;
+    double lifespanFactor = 1;
+};
+
+// Totals of one scenario; top holds (clv, row) pairs, best first
+struct ScenarioOutcome {
+    size_t affected = 0;
+    double totalCLV = 0;
+    std::vector<std::pair<double, size_t>> top;
+};
+
+const size_t MAX_SCENARIOS = 256;
+const size_t MAX_SCENARIO_TOP = 1000;
+
+// Parse {"top": 10, "scenarios": [{"name": "...", "minAOV": 2000, "frequencyChange": 0.1}, ...]}.
+// Filters: minAOV, maxAOV, minFrequency, maxFrequency, minLifespan, maxLifespan.
+// Changes are relative: aovChange, frequencyChange, lifespanChange (0.1 = +10%, -0.2 = -20%).
+// Returns "" on success, otherwise what is wrong with the request.
+inline std::string parseScenarioRequest(const std::string& body, std::vector<Scenario>& scenarios, size_t& top) {
+    scenarios.clear();
+    top = 10;
+    JsonReader reader(body.data(), body.size());
+    std::string scratch;
+    try {
+        reader.expect('{');
+        if (!reader.consume('}')) {
+            do {
+                std::string key(reader.readString(scratch));
+                reader.expect(':');
+                if (key == "top" && reader.isNumberNext()) {
+                    double value = reader.readNumber();
+                    if (!(value >= 0) || value > MAX_SCENARIO_TOP || value != std::floor(value)) {
+                        return "'top' must be a whole number from 0 to " + std::to_string(MAX_SCENARIO_TOP);
+                    }
+                    top = static_cast<size_t>(value);
+                } else if (key == "scenarios" && reader.peek() == '[') {
+                    reader.expect('[');
+                    if (reader.consume(']')) continue;
+                    do {
+                        if (scenarios.size() == MAX_SCENARIOS) {
+                            return "at most " + std::to_string(MAX_SCENARIOS) + " scenarios per request";
+                        }
+                        Scenario scenario;
+                        scenario.name = "scenario " + std::to_string(scenarios.size() + 1);
+                        reader.expect('{');
+                        if (!reader.consume('}')) {
+                            do {
+                                std::string field(reader.readString(scratch));
+                                reader.expect(':');
+                                if (field == "name" && reader.peek() == '"') {
+                                    scenario.name = reader.readString(scratch);
+                                    continue;
+                                }
+                                if (!reader.isNumberNext()) {
+                                    return "scenario field '" + field + "' must be a number";
+                                }
+                                double value = reader.readNumber();
+                                ScenarioFilter& filter = scenario.filter;
+                                if (field == "minAOV") filter.minAOV = value;
+                                else if (field == "maxAOV") filter.maxAOV = value;
+                                else if (field == "minFrequency") filter.minFrequency = value;
+                                else if (field == "maxFrequency") filter.maxFrequency = value;
+                                else if (field == "minLifespan") filter.minLifespan = value;
+                                else if (field == "maxLifespan") filter.maxLifespan = value;
+                                else if (field == "aovChange") scenario.aovFactor = 1 + value;
+                                else if (field == "frequencyChange") scenario.frequencyFactor = 1 + value;
+                                else if (field == "lifespanChange") scenario.lifespanFactor = 1 + value;
+                                else return "unknown scenario field '" + field + "'";
+                            } while (reader.nextElement('}'));
+                        }
+                        for (double factor : {scenario.aovFactor, scenario.frequencyFactor, scenario.lifespanFactor}) {
+                            if (!(factor > 0) || std::isinf(factor)) {
+                                return "changes in '" + scenario.name + "' must be greater than -1";
+                            }
+                        }
+                        scenarios.push_back(std::move(scenario));
+                    } while (reader.nextElement(']'));
+                } else {
+                    reader.skipValue();
+                }
+            } while (reader.nextElement('}'));
+        }
+        if (!reader.atEnd()) return "unexpected text after the request";
+    } catch (const JsonParseError& e) {
+        return std::string("invalid JSON: ") + e.what();
+    }
+    if (scenarios.empty()) return "'scenarios' must list at least one scenario";
+    return "";
+}
+
+namespace scenario_detail {
+
+// "a ranks above b": higher CLV, or same CLV and lower ID (the leaderboard order)
+struct RanksAbove {
+    const std::string* ids;
+    bool operator()(const std::pair<double, size_t>& a, const std::pair<double, size_t>& b) const {
+        return a.first > b.first || (a.first == b.first && ids[a.second] < ids[b.second]);
+    }
+};
+
+// Keep the best n of candidates, best first
+inline void trimTop(std::vector<std::pair<double, size_t>>& candidates, size_t n, RanksAbove ranksAbove) {
+    if (candidates.size() > n) {
+        std::nth_element(candidates.begin(), candidates.begin() + n, candidates.end(), ranksAbove);
+        candidates.resize(n);
+    }
+    std::sort(candidates.begin(), candidates.end(), ranksAbove);
+}
+
+} // namespace scenario_detail
+
+// Evaluate every scenario over the metric columns in one fused scan. The result
+// has one outcome per scenario followed by the baseline (no changes). ids only
+// order equal CLVs in the top lists.
+inline std::vector<ScenarioOutcome> evaluateScenarios(TaskPool& pool, const CLVModel& model,
+                                                      const std::string* ids, const double* aov,
+                                                      const double* freq, const double* lifespan, size_t count,
+                                                      const std::vector<Scenario>& scenarios, size_t topK) {
+    const scenario_detail::RanksAbove ranksAbove{ids};
+    const size_t BLOCK = 512;  // 3 metric + 3 overlay + 1 CLV buffers of 4 KB stay in L1
+    const size_t outcomes = scenarios.size() + 1;
+    Scenario baseline;
+
+    auto scanChunk = [&](size_t begin, size_t end) {
+        std::vector<ScenarioOutcome> result(outcomes);
+        double a[BLOCK], f[BLOCK], l[BLOCK], clv[BLOCK];
+        for (size_t block = begin; block < end; block += BLOCK) {
+            size_t n = std::min(BLOCK, end - block);
+            const double* blockAOV = aov + block;
+            const double* blockFreq = freq + block;
+            const double* blockLifespan = lifespan + block;
+            for (size_t s = 0; s < outcomes; s++) {
+                const Scenario& scenario = s < scenarios.size() ? scenarios[s] : baseline;
+                ScenarioOutcome& outcome = result[s];
+
+                // Overlay: matching rows get scaled metrics, the rest keep theirs
+                size_t affected = 0;
+                for (size_t i = 0; i < n; i++) {
+                    bool match = scenario.filter.matches(blockAOV[i], blockFreq[i], blockLifespan[i]);
+                    affected += match;
+                    a[i] = blockAOV[i] * (match ? scenario.aovFactor : 1.0);
+                    f[i] = blockFreq[i] * (match ? scenario.frequencyFactor : 1.0);
+                    l[i] = blockLifespan[i] * (match ? scenario.lifespanFactor : 1.0);
+                }
+                model.evaluate(a, f, l, clv, n);
+
+                double total = 0;
+                for (size_t i = 0; i < n; i++) total += clv[i];
+                outcome.affected += affected;
+                outcome.totalCLV += total;
+
+                // Bounded min-heap of the chunk's best topK; the weakest is at the front
+                auto& top = outcome.top;
+                for (size_t i = 0; i < n && topK > 0; i++) {
+                    std::pair<double, size_t> candidate(clv[i], block + i);
+                    if (top.size() < topK) {
+                        top.push_back(candidate);
+                        std::push_heap(top.begin(), top.end(), ranksAbove);
+                    } else if (ranksAbove(candidate, top.front())) {
+                        std::pop_heap(top.begin(), top.end(), ranksAbove);
+                        top.back() = candidate;
+                        std::push_heap(top.begin(), top.end(), ranksAbove);
+                    }
+                }
+            }
+        }
+        return result;
+    };
+
+    std::vector<ScenarioOutcome> totals = pool.parallelReduce(count, TaskPool::DEFAULT_GRAIN,
+        std::vector<ScenarioOutcome>(outcomes), scanChunk,
+        [topK, ranksAbove](std::vector<ScenarioOutcome> total, std::vector<ScenarioOutcome> part) {
+            for (size_t s = 0; s < total.size(); s++) {
+                total[s].affected += part[s].affected;
+                total[s].totalCLV += part[s].totalCLV;
+                total[s].top.insert(total[s].top.end(), part[s].top.begin(), part[s].top.end());
+                scenario_detail::trimTop(total[s].top, topK, ranksAbove);
+            }
+            return total;
+        });
+    return totals;
+}
+
+#endif // CLV_SCENARIOS_HPP
@@ -0,0 +1,376 @@
+#ifndef CLV_STATISTICS_HPP
+#define CLV_STATISTICS_HPP
+
+#include <set>
+#include <vector>
+#include <cstddef>
+#include <cmath>
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+
+// Count, sum, mean, variance, min and max of a changing set of values, kept
+// current as values are added, removed or replaced so reads are O(1).
+//
+// Mean and variance use Welford's update (and its inverse for removals), which
+// stays accurate where the naive sum-of-squares formula cancels badly. A sorted
+// multiset keeps min/max correct when the current extreme is removed. Statistics
+// of separate parts combine() into the statistics of the whole (Chan et al.), so
+// rebuilds can run in parallel; partial results and one-shot summaries, which
+// never remove values, are built without the multiset and get one from
+// trackValues() if they become the maintained statistics.
+class RunningStatistics {
+private:
+    size_t n = 0;
+    double total = 0;
+    double runningMean = 0;
+    double m2 = 0;                // Sum of squared distances from the mean
+    double low = 0;               // Extremes of values only ever added
+    double high = 0;
+    bool removable = true;        // values holds every value, so remove() is allowed
+    std::multiset<double> values; // DSA: Balanced BST for O(log n) min/max maintenance
+
+public:
+    explicit RunningStatistics(bool supportRemoval = true) : removable(supportRemoval) {}
+
+    void add(double x) {
+        if (n == 0) {
+            low = high = x;
+        } else {
+            low = std::min(low, x);
+            high = std::max(high, x);
+        }
+        n++;
+        total += x;
+        double delta = x - runningMean;
+        runningMean += delta / n;
+        m2 += delta * (x - runningMean);
+        if (removable) values.insert(x);
+    }
+
+    // x must be a value that was added before; needs removal support
+    void remove(double x) {
+        if (!removable) return;
+        auto it = values.find(x);
+        if (it == values.end()) return;
+        values.erase(it);
+
+        if (n == 1) {
+            clear();
+            return;
+        }
+        double previousMean = (n * runningMean - x) / (n - 1);
+        m2 -= (x - runningMean) * (x - previousMean);
+        if (m2 < 0) m2 = 0;  // Rounding can push it just below zero
+        runningMean = previousMean;
+        total -= x;
+        n--;
+    }
+
+    void replace(double oldValue, double newValue) {
+        if (oldValue == newValue) return;
+        remove(oldValue);
+        add(newValue);
+    }
+
+    void clear() {
+        n = 0;
+        total = 0;
+        runningMean = 0;
+        m2 = 0;
+        low = high = 0;
+        values.clear();
+    }
+
+    // Recompute from scratch (after bulk loads, and to shed accumulated rounding error)
+    void rebuild(const double* data, size_t count) {
+        clear();
+        if (count == 0) return;
+        n = count;
+        low = high = data[0];
+        for (size_t i = 0; i < count; i++) {
+            total += data[i];
+            low = std::min(low, data[i]);
+            high = std::max(high, data[i]);
+        }
+        runningMean = total / n;
+        for (size_t i = 0; i < count; i++) m2 += (data[i] - runningMean) * (data[i] - runningMean);
+        if (removable) trackValues(data, count);
+    }
+
+    // Enable removals: data must hold exactly the values these statistics describe
+    void trackValues(const double* data, size_t count) {
+        std::vector<double> sorted(data, data + count);
+        std::sort(sorted.begin(), sorted.end());
+        values = std::multiset<double>(sorted.begin(), sorted.end());  // Linear from a sorted range
+        removable = true;
+    }
+
+    // Fold in the statistics of another, disjoint set of values
+    void combine(const RunningStatistics& other) {
+        if (other.n == 0) return;
+        if (n == 0) {
+            bool keepValues = removable && other.removable;
+            *this = other;
+            removable = keepValues;
+            if (!removable) values.clear();
+            return;
+        }
+        size_t combined = n + other.n;
+        double delta = other.runningMean - runningMean;
+        m2 += other.m2 + delta * delta * (static_cast<double>(n) * other.n / combined);
+        total += other.total;
+        runningMean = total / combined;
+        low = std::min(low, other.low);
+        high = std::max(high, other.high);
+        removable = removable && other.removable;
+        if (removable) values.insert(other.values.begin(), other.values.end());
+        else values.clear();
+        n = combined;
+    }
+
+    size_t count() const { return n; }
+    double sum() const { return total; }
+    double mean() const { return runningMean; }
+    double min() const { return n == 0 ? 0 : removable ? *values.begin() : low; }
+    double max() const { return n == 0 ? 0 : removable ? *values.rbegin() : high; }
+
+    // Population variance
+    double variance() const { return n == 0 ? 0 : m2 / n; }
+    double standardDeviation() const { return std::sqrt(variance()); }
+};
+
+// KLL quantile sketch (Karnin, Lang & Liberty): approximate quantiles of a
+// stream in bounded memory. Level h holds items standing for 2^h inputs; when a
+// level outgrows its capacity it is sorted and every other item (random offset)
+// is promoted, halving it. Capacities shrink geometrically towards the lower
+// levels, so the sketch keeps O(k) items whatever the stream length, with rank
+// error around 1.7/k. Sketches built on separate data can be merged.
+class KllSketch {
+private:
+    size_t k;
+    std::vector<std::vector<double>> levels;
+    size_t n = 0;
+    uint64_t randomState = 0x9E3779B97F4A7C15ull;  // Fixed seed: identical input gives identical sketch
+
+    // Sorted (value, cumulative weight) view for queries, rebuilt after updates
+    mutable std::vector<std::pair<double, uint64_t>> sortedView;
+    mutable bool viewValid = false;
+
+    size_t capacity(size_t level) const {
+        size_t depth = levels.size() - 1 - level;
+        double c = static_cast<double>(k);
+        for (size_t i = 0; i < depth; i++) c *= 2.0 / 3.0;
+        return std::max<size_t>(2, static_cast<size_t>(std::ceil(c)));
+    }
+
+    bool randomBit() {
+        // xorshift64
+        randomState ^= randomState << 13;
+        randomState ^= randomState >> 7;
+        randomState ^= randomState << 17;
+        return randomState & 1;
+    }
+
+    void compress() {
+        for (size_t level = 0; level < levels.size(); level++) {
+            if (levels[level].size() < capacity(level)) continue;
+            if (level + 1 == levels.size()) levels.emplace_back();
+
+            std::vector<double>& items = levels[level];
+            std::sort(items.begin(), items.end());
+            // An odd item out stays behind so total weight is preserved
+            double leftover = 0;
+            bool hasLeftover = items.size() % 2 == 1;
+            if (hasLeftover) {
+                leftover = items.back();
+                items.pop_back();
+            }
+            for (size_t i = randomBit() ? 1 : 0; i < items.size(); i += 2) {
+                levels[level + 1].push_back(items[i]);
+            }
+            items.clear();
+            if (hasLeftover) items.push_back(leftover);
+        }
+    }
+
+    void buildView() const {
+        sortedView.clear();
+        for (size_t level = 0; level < levels.size(); level++) {
+            for (double x : levels[level]) sortedView.emplace_back(x, uint64_t(1) << level);
+        }
+        std::sort(sortedView.begin(), sortedView.end());
+        uint64_t cumulative = 0;
+        for (auto& entry : sortedView) {
+            cumulative += entry.second;
+            entry.second = cumulative;
+        }
+        viewValid = true;
+    }
+
+public:
+    explicit KllSketch(size_t k = 200) : k(k), levels(1) {}
+
+    void add(double x) {
+        levels[0].push_back(x);
+        n++;
+        viewValid = false;
+        if (levels[0].size() >= capacity(0)) compress();
+    }
+
+    void merge(const KllSketch& other) {
+        while (levels.size() < other.levels.size()) levels.emplace_back();
+        for (size_t level = 0; level < other.levels.size(); level++) {
+            levels[level].insert(levels[level].end(), other.levels[level].begin(), other.levels[level].end());
+        }
+        n += other.n;
+        viewValid = false;
+        compress();
+    }
+
+    void clear() {
+        levels.assign(1, std::vector<double>());
+        n = 0;
+        viewValid = false;
+    }
+
+    size_t count() const { return n; }
+
+    size_t retainedItems() const {
+        size_t total = 0;
+        for (const auto& level : levels) total += level.size();
+        return total;
+    }
+
+    // Approximate value at quantile q in [0, 1]
+    double quantile(double q) const {
+        if (n == 0) return 0;
+        if (!viewValid) buildView();
+        uint64_t totalWeight = sortedView.back().second;
+        double target = std::min(std::max(q, 0.0), 1.0) * totalWeight;
+        auto it = std::lower_bound(sortedView.begin(), sortedView.end(), target,
+                                   [](const std::pair<double, uint64_t>& entry, double t) { return entry.second < t; });
+        return it == sortedView.end() ? sortedView.back().first : it->first;
+    }
+};
+
+// Fixed log-scale histogram: BUCKETS_PER_DECADE buckets per power of ten from
+// 10^MIN_EXPONENT to 10^MAX_EXPONENT, plus one underflow and one overflow bucket.
+// Counts are exact and support removal.
+class LogHistogram {
+public:
+    static const int MIN_EXPONENT = 0;
+    static const int MAX_EXPONENT = 10;
+    static const int BUCKETS_PER_DECADE = 4;
+    static const size_t BUCKET_COUNT = (MAX_EXPONENT - MIN_EXPONENT) * BUCKETS_PER_DECADE + 2;
+
+    struct Bucket {
+        double lower;  // Inclusive; -infinity for the underflow bucket
+        double upper;  // Exclusive; +infinity for the overflow bucket
+        size_t count;
+    };
+
+private:
+    size_t counts[BUCKET_COUNT] = {};
+
+    static double boundary(size_t edge) {
+        return std::pow(10.0, MIN_EXPONENT + static_cast<double>(edge) / BUCKETS_PER_DECADE);
+    }
+
+    static size_t bucketOf(double x) {
+        if (!(x >= boundary(0))) return 0;
+        if (!(x < boundary(BUCKET_COUNT - 2))) return BUCKET_COUNT - 1;
+        double position = (std::log10(x) - MIN_EXPONENT) * BUCKETS_PER_DECADE;
+        size_t bucket = 1 + static_cast<size_t>(position);
+        // log10 rounding can land a value on the wrong side of an edge
+        if (bucket < BUCKET_COUNT - 1 && x >= boundary(bucket)) bucket++;
+        else if (bucket > 1 && x < boundary(bucket - 1)) bucket--;
+        return std::min(bucket, BUCKET_COUNT - 1);
+    }
+
+public:
+    void add(double x) { counts[bucketOf(x)]++; }
+    void remove(double x) {
+        size_t bucket = bucketOf(x);
+        if (counts[bucket] > 0) counts[bucket]--;
+    }
+    void clear() { std::fill(counts, counts + BUCKET_COUNT, 0); }
+
+    void merge(const LogHistogram& other) {
+        for (size_t i = 0; i < BUCKET_COUNT; i++) counts[i] += other.counts[i];
+    }
+
+    // Non-empty buckets in ascending order
+    std::vector<Bucket> buckets() const {
+        std::vector<Bucket> result;
+        for (size_t i = 0; i < BUCKET_COUNT; i++) {
+            if (counts[i] == 0) continue;
+            double lower = i == 0 ? -HUGE_VAL : boundary(i - 1);
+            double upper = i == BUCKET_COUNT - 1 ? HUGE_VAL : boundary(i);
+            result.push_back(Bucket{lower, upper, counts[i]});
+        }
+        return result;
+    }
+};
+
+// CLV distribution: a KLL sketch for percentiles and a log histogram.
+// The histogram follows every mutation exactly. KLL cannot forget values, so
+// removals and updates are only counted; once they exceed 1% of the values the
+// sketch is rebuilt from the data (needsRebuild), keeping the extra rank error
+// within about 1%.
+class DistributionTracker {
+private:
+    KllSketch sketch;
+    LogHistogram histogram;
+    size_t removedSinceRebuild = 0;
+    size_t liveCount = 0;
+
+public:
+    void add(double x) {
+        sketch.add(x);
+        histogram.add(x);
+        liveCount++;
+    }
+
+    void remove(double x) {
+        histogram.remove(x);
+        removedSinceRebuild++;
+        liveCount--;
+    }
+
+    void replace(double oldValue, double newValue) {
+        if (oldValue == newValue) return;
+        remove(oldValue);
+        add(newValue);
+    }
+
+    void clear() {
+        sketch.clear();
+        histogram.clear();
+        removedSinceRebuild = 0;
+        liveCount = 0;
+    }
+
+    void rebuild(const double* data, size_t count) {
+        clear();
+        for (size_t i = 0; i < count; i++) add(data[i]);
+    }
+
+    // Fold in a tracker built over other values (parallel rebuilds merge per-chunk trackers)
+    void merge(const DistributionTracker& other) {
+        sketch.merge(other.sketch);
+        histogram.merge(other.histogram);
+        removedSinceRebuild += other.removedSinceRebuild;
+        liveCount += other.liveCount;
+    }
+
+    bool needsRebuild() const {
+        return removedSinceRebuild > 0 && removedSinceRebuild * 100 > liveCount;
+    }
+
+    size_t count() const { return liveCount; }
+    const KllSketch& quantiles() const { return sketch; }
+    const LogHistogram& buckets() const { return histogram; }
+};
+
+#endif // CLV_STATISTICS_HPP
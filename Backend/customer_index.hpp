@@ -0,0 +1,216 @@
+#ifndef CUSTOMER_INDEX_HPP
+#define CUSTOMER_INDEX_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+// Sorted secondary index over table rows.
+//
+// Rows are kept in an order defined by the caller (e.g. CLV then ID) in a
+// two-level sorted array: a list of blocks of at most 2 × BLOCK row numbers,
+// plus a Fenwick tree over the block sizes. The index stores only row numbers
+// (4 bytes per customer); the order is always evaluated against the table's
+// columns, so a row's values must not change while it is indexed - erase it
+// first, change it, insert it again.
+//
+//   - seek by key (partition point of a predicate): binary search over the
+//     blocks' last rows, then within one block        O(log N)
+//   - seek by position, position of a block           O(log N) via the Fenwick tree
+//   - insert / erase: one seek plus a memmove inside one block; a block that
+//     overflows is split, an emptied block is dropped (both rebuild the
+//     Fenwick tree, O(N / BLOCK), once per BLOCK operations at most)
+//
+// A position is a row's 0-based place in the order.
+class OrderedRowIndex {
+public:
+    static const size_t BLOCK = 512;
+
+private:
+    std::vector<std::vector<uint32_t>> blocks;
+    std::vector<size_t> fenwick;  // 1-based partial sums of the block sizes
+    size_t total = 0;
+
+    void rebuildFenwick() {
+        fenwick.assign(blocks.size() + 1, 0);
+        for (size_t b = 1; b <= blocks.size(); b++) {
+            fenwick[b] += blocks[b - 1].size();
+            size_t parent = b + (b & (0 - b));
+            if (parent <= blocks.size()) fenwick[parent] += fenwick[b];
+        }
+    }
+
+    void adjustFenwick(size_t block, long delta) {
+        for (size_t b = block + 1; b <= blocks.size(); b += b & (0 - b)) fenwick[b] += delta;
+    }
+
+    // Rows in blocks before `block`
+    size_t rowsBefore(size_t block) const {
+        size_t sum = 0;
+        for (size_t b = block; b > 0; b -= b & (0 - b)) sum += fenwick[b];
+        return sum;
+    }
+
+    // Block and offset of a position (< total), by Fenwick descent: the last block
+    // whose preceding rows are at most position
+    void locate(size_t position, size_t& block, size_t& offset) const {
+        size_t step = 1;
+        while (step * 2 <= blocks.size()) step *= 2;
+        block = 0;
+        offset = position;
+        for (; step > 0; step /= 2) {
+            if (block + step <= blocks.size() && fenwick[block + step] <= offset) {
+                block += step;
+                offset -= fenwick[block];
+            }
+        }
+    }
+
+    // Block holding the first row for which before(row) is false (blocks.size() if none)
+    template<typename Before>
+    size_t findBlock(Before before) const {
+        size_t low = 0, high = blocks.size();
+        while (low < high) {
+            size_t mid = (low + high) / 2;
+            if (before(blocks[mid].back())) low = mid + 1;
+            else high = mid;
+        }
+        return low;
+    }
+
+    // Place of row in the index, assuming it is indexed and less defines the order
+    template<typename Less>
+    bool find(uint32_t row, Less less, size_t& block, size_t& offset) const {
+        auto before = [&](uint32_t other) { return less(other, row); };
+        block = findBlock(before);
+        if (block == blocks.size()) return false;
+        const std::vector<uint32_t>& rows = blocks[block];
+        offset = std::partition_point(rows.begin(), rows.end(), before) - rows.begin();
+        return offset < rows.size() && rows[offset] == row;
+    }
+
+public:
+    OrderedRowIndex() { clear(); }
+
+    size_t size() const { return total; }
+    bool empty() const { return total == 0; }
+
+    void clear() {
+        blocks.clear();
+        fenwick.assign(1, 0);
+        total = 0;
+    }
+
+    // Replace the contents with rows already in order
+    void assign(const std::vector<uint32_t>& sortedRows) {
+        blocks.clear();
+        for (size_t begin = 0; begin < sortedRows.size(); begin += BLOCK) {
+            size_t end = std::min(sortedRows.size(), begin + BLOCK);
+            blocks.emplace_back(sortedRows.begin() + begin, sortedRows.begin() + end);
+        }
+        total = sortedRows.size();
+        rebuildFenwick();
+    }
+
+    // Position of the first row for which before(row) is false (size() if none).
+    // before must be true for a prefix of the order and false after it.
+    template<typename Before>
+    size_t lowerBound(Before before) const {
+        size_t block = findBlock(before);
+        if (block == blocks.size()) return total;
+        const std::vector<uint32_t>& rows = blocks[block];
+        return rowsBefore(block) + (std::partition_point(rows.begin(), rows.end(), before) - rows.begin());
+    }
+
+    // Row at a position (< size())
+    uint32_t at(size_t position) const {
+        size_t block, offset;
+        locate(position, block, offset);
+        return blocks[block][offset];
+    }
+
+    // Position of an indexed row; size() if it is not indexed
+    template<typename Less>
+    size_t positionOf(uint32_t row, Less less) const {
+        size_t block, offset;
+        if (!find(row, less, block, offset)) return total;
+        return rowsBefore(block) + offset;
+    }
+
+    // Visit rows from position onwards (or backwards, towards position 0) until
+    // visit returns false or the index ends
+    template<typename Visitor>
+    void scan(size_t position, bool forward, Visitor visit) const {
+        if (position >= total) return;
+        size_t block, offset;
+        locate(position, block, offset);
+        if (forward) {
+            for (; block < blocks.size(); block++, offset = 0) {
+                for (; offset < blocks[block].size(); offset++) {
+                    if (!visit(blocks[block][offset])) return;
+                }
+            }
+        } else {
+            for (;;) {
+                for (size_t i = offset + 1; i-- > 0;) {
+                    if (!visit(blocks[block][i])) return;
+                }
+                if (block == 0) return;
+                block--;
+                offset = blocks[block].size() - 1;
+            }
+        }
+    }
+
+    template<typename Less>
+    void insert(uint32_t row, Less less) {
+        auto before = [&](uint32_t other) { return less(other, row); };
+        size_t block = findBlock(before);
+        if (blocks.empty()) {
+            blocks.emplace_back();
+            block = 0;
+        } else if (block == blocks.size()) {
+            block--;  // Goes after every row: end of the last block
+        }
+        std::vector<uint32_t>& rows = blocks[block];
+        rows.insert(std::partition_point(rows.begin(), rows.end(), before), row);
+        total++;
+        if (rows.size() > 2 * BLOCK) {
+            std::vector<uint32_t> upper(rows.begin() + BLOCK, rows.end());
+            rows.resize(BLOCK);
+            blocks.insert(blocks.begin() + block + 1, std::move(upper));
+            rebuildFenwick();
+        } else if (fenwick.size() != blocks.size() + 1) {
+            rebuildFenwick();
+        } else {
+            adjustFenwick(block, 1);
+        }
+    }
+
+    // Remove an indexed row; false if it was not found
+    template<typename Less>
+    bool erase(uint32_t row, Less less) {
+        size_t block, offset;
+        if (!find(row, less, block, offset)) return false;
+        blocks[block].erase(blocks[block].begin() + offset);
+        total--;
+        if (blocks[block].empty()) {
+            blocks.erase(blocks.begin() + block);
+            rebuildFenwick();
+        } else {
+            adjustFenwick(block, -1);
+        }
+        return true;
+    }
+
+    // The table moved row `from` to row `to` (values unchanged): renumber its entry
+    template<typename Less>
+    bool renumber(uint32_t from, uint32_t to, Less less) {
+        size_t block, offset;
+        if (!find(from, less, block, offset)) return false;
+        blocks[block][offset] = to;
+        return true;
+    }
+};
+
+#endif // CUSTOMER_INDEX_HPP
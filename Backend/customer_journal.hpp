@@ -0,0 +1,387 @@
+#ifndef CUSTOMER_JOURNAL_HPP
+#define CUSTOMER_JOURNAL_HPP
+
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <cerrno>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <iostream>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+// One customer mutation as stored in the journal.
+// Adds and updates are both upserts so replaying a record twice is harmless.
+// SET_MODEL switches the CLV model for the records after it: the model's name
+// ("simple", "margin", ...) is in name, its parameters in modelMargin and
+// modelDiscountRate, and id is empty.
+struct JournalRecord {
+    enum Op : uint8_t { UPSERT = 1, REMOVE = 2, SET_MODEL = 3 };
+
+    Op op = UPSERT;
+    std::string id;
+    std::string name;
+    double averagePurchaseValue = 0;
+    double purchaseFrequency = 0;
+    double customerLifespan = 0;
+    double modelMargin = 0;
+    double modelDiscountRate = 0;
+};
+
+// Append-only write-ahead log of customer mutations.
+//
+// Each record is framed as [u32 payload length][u32 CRC-32 of payload][payload]
+// in host byte order, so a torn write at the tail is detected on replay and cut
+// off. Durability is chosen per journal:
+//   SYNC_NONE   - leave flushing to the OS
+//   SYNC_ALWAYS - fdatasync after every append
+//   SYNC_GROUP  - appenders wait for a background flusher whose single
+//                 fdatasync covers every record written since the last one
+class CustomerJournal {
+public:
+    enum SyncMode { SYNC_NONE, SYNC_ALWAYS, SYNC_GROUP };
+
+private:
+    int fd;
+    std::string path;
+    SyncMode syncMode;
+    uint64_t bytesWritten;   // Size of the file up to the last complete write
+    bool failed;             // A partial write could not be cut off; no further writes
+    std::mutex writeMutex;
+    std::string encodeBuffer;
+
+    // Group commit state
+    std::thread flusher;
+    std::mutex syncMutex;
+    std::condition_variable syncRequested;
+    std::condition_variable syncDone;
+    uint64_t appendedSeq;
+    uint64_t syncedSeq;      // Only ever increases
+    bool syncing;            // The flusher is inside fdatasync (on syncFd)
+    bool stopping;
+
+    static uint32_t crc32(const char* data, size_t length) {
+        static uint32_t table[256];
+        static bool initialized = [] {
+            for (uint32_t i = 0; i < 256; i++) {
+                uint32_t c = i;
+                for (int k = 0; k < 8; k++) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+                table[i] = c;
+            }
+            return true;
+        }();
+        (void)initialized;
+
+        uint32_t crc = 0xFFFFFFFFu;
+        for (size_t i = 0; i < length; i++) {
+            crc = table[(crc ^ static_cast<unsigned char>(data[i])) & 0xFF] ^ (crc >> 8);
+        }
+        return crc ^ 0xFFFFFFFFu;
+    }
+
+    template<typename T>
+    static void put(std::string& out, const T& value) {
+        out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    template<typename T>
+    static bool get(const char*& cursor, const char* end, T& value) {
+        if (size_t(end - cursor) < sizeof(T)) return false;
+        std::memcpy(&value, cursor, sizeof(T));
+        cursor += sizeof(T);
+        return true;
+    }
+
+    static void encode(std::string& out, const JournalRecord& record) {
+        size_t frameStart = out.size();
+        put<uint32_t>(out, 0);
+        put<uint32_t>(out, 0);
+        size_t payloadStart = out.size();
+
+        put<uint8_t>(out, record.op);
+        put<uint32_t>(out, static_cast<uint32_t>(record.id.size()));
+        out += record.id;
+        if (record.op == JournalRecord::UPSERT) {
+            put<uint32_t>(out, static_cast<uint32_t>(record.name.size()));
+            out += record.name;
+            put<double>(out, record.averagePurchaseValue);
+            put<double>(out, record.purchaseFrequency);
+            put<double>(out, record.customerLifespan);
+        } else if (record.op == JournalRecord::SET_MODEL) {
+            put<uint32_t>(out, static_cast<uint32_t>(record.name.size()));
+            out += record.name;
+            put<double>(out, record.modelMargin);
+            put<double>(out, record.modelDiscountRate);
+        }
+
+        uint32_t length = static_cast<uint32_t>(out.size() - payloadStart);
+        uint32_t checksum = crc32(out.data() + payloadStart, length);
+        std::memcpy(&out[frameStart], &length, sizeof(length));
+        std::memcpy(&out[frameStart + sizeof(length)], &checksum, sizeof(checksum));
+    }
+
+    static bool decode(const char* payload, size_t length, JournalRecord& record) {
+        const char* cursor = payload;
+        const char* end = payload + length;
+        uint8_t op;
+        uint32_t size;
+        if (!get(cursor, end, op) || !get(cursor, end, size) || size_t(end - cursor) < size) return false;
+        record.op = static_cast<JournalRecord::Op>(op);
+        record.id.assign(cursor, size);
+        cursor += size;
+
+        if (record.op == JournalRecord::REMOVE) {
+            record.name.clear();
+            return cursor == end;
+        }
+        if (record.op != JournalRecord::UPSERT && record.op != JournalRecord::SET_MODEL) return false;
+        if (!get(cursor, end, size) || size_t(end - cursor) < size) return false;
+        record.name.assign(cursor, size);
+        cursor += size;
+        if (record.op == JournalRecord::SET_MODEL) {
+            return get(cursor, end, record.modelMargin) && get(cursor, end, record.modelDiscountRate) && cursor == end;
+        }
+        return get(cursor, end, record.averagePurchaseValue) &&
+               get(cursor, end, record.purchaseFrequency) &&
+               get(cursor, end, record.customerLifespan) && cursor == end;
+    }
+
+    bool writeAll(const std::string& data) {
+        size_t written = 0;
+        while (written < data.size()) {
+            ssize_t n = ::write(fd, data.data() + written, data.size() - written);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) return false;
+            written += n;
+        }
+        bytesWritten += data.size();
+        return true;
+    }
+
+    void flusherLoop() {
+        std::unique_lock<std::mutex> lock(syncMutex);
+        while (true) {
+            syncRequested.wait(lock, [this] { return stopping || appendedSeq > syncedSeq; });
+            if (appendedSeq == syncedSeq) return;  // Stopping and everything is synced
+
+            uint64_t target = appendedSeq;
+            int syncFd = fd;
+            syncing = true;
+            lock.unlock();
+            ::fdatasync(syncFd);
+            lock.lock();
+            syncing = false;
+            syncedSeq = std::max(syncedSeq, target);
+            syncDone.notify_all();
+        }
+    }
+
+    void stopFlusher() {
+        {
+            std::lock_guard<std::mutex> lock(syncMutex);
+            stopping = true;
+        }
+        syncRequested.notify_all();
+        if (flusher.joinable()) flusher.join();
+    }
+
+public:
+    CustomerJournal()
+        : fd(-1), syncMode(SYNC_GROUP), bytesWritten(0), failed(false),
+          appendedSeq(0), syncedSeq(0), syncing(false), stopping(false) {}
+
+    ~CustomerJournal() {
+        close();
+    }
+
+    CustomerJournal(const CustomerJournal&) = delete;
+    CustomerJournal& operator=(const CustomerJournal&) = delete;
+
+    bool open(const std::string& journalPath, SyncMode mode = SYNC_GROUP) {
+        close();
+        fd = ::open(journalPath.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+        if (fd < 0) {
+            std::cerr << "❌ Could not open journal " << journalPath << ": " << std::strerror(errno) << std::endl;
+            return false;
+        }
+        struct stat info;
+        bytesWritten = fstat(fd, &info) == 0 ? info.st_size : 0;
+        failed = false;
+        path = journalPath;
+        syncMode = mode;
+        appendedSeq = syncedSeq = 0;
+        syncing = false;
+        stopping = false;
+        if (syncMode == SYNC_GROUP) {
+            flusher = std::thread(&CustomerJournal::flusherLoop, this);
+        }
+        return true;
+    }
+
+    void close() {
+        if (fd < 0) return;
+        stopFlusher();
+        ::fdatasync(fd);
+        ::close(fd);
+        fd = -1;
+    }
+
+    bool isOpen() const { return fd >= 0; }
+    uint64_t size() const { return bytesWritten; }
+    const std::string& filePath() const { return path; }
+
+    // Write records as one write() without waiting for them to reach the disk.
+    // ticket identifies the write for waitDurable(); callers can issue it while
+    // holding their own lock (keeping journal order = apply order) and wait after
+    // releasing it, so concurrent writers share one fdatasync.
+    // A write that fails partway (ENOSPC, EIO) is cut off again: replay stops at
+    // the first torn frame, so a fragment left in place would hide every record
+    // appended after it. If the cut fails too, the journal refuses further writes.
+    bool write(const std::vector<JournalRecord>& records, uint64_t& ticket) {
+        ticket = 0;
+        if (fd < 0 || records.empty()) return false;
+
+        std::lock_guard<std::mutex> lock(writeMutex);
+        if (failed) return false;
+        encodeBuffer.clear();
+        for (const auto& record : records) {
+            encode(encodeBuffer, record);
+        }
+        if (!writeAll(encodeBuffer)) {
+            int error = errno;
+            if (::ftruncate(fd, bytesWritten) != 0) {
+                failed = true;
+                std::cerr << "❌ Journal write failed: " << std::strerror(error)
+                          << " (and the partial record could not be removed - journal disabled)" << std::endl;
+            } else {
+                std::cerr << "❌ Journal write failed: " << std::strerror(error) << std::endl;
+            }
+            return false;
+        }
+        if (syncMode != SYNC_NONE) {
+            std::lock_guard<std::mutex> syncLock(syncMutex);
+            ticket = ++appendedSeq;
+        }
+        return true;
+    }
+
+    bool write(const JournalRecord& record, uint64_t& ticket) {
+        return write(std::vector<JournalRecord>{record}, ticket);
+    }
+
+    // Block until the write behind ticket is as durable as the sync mode promises
+    void waitDurable(uint64_t ticket) {
+        if (ticket == 0) return;
+        if (syncMode == SYNC_ALWAYS) {
+            std::lock_guard<std::mutex> lock(writeMutex);
+            std::lock_guard<std::mutex> syncLock(syncMutex);
+            if (syncedSeq >= ticket) return;
+            uint64_t target = appendedSeq;
+            ::fdatasync(fd);
+            syncedSeq = std::max(syncedSeq, target);
+            return;
+        }
+
+        // Group commit: wait for a flush that covers this write
+        std::unique_lock<std::mutex> lock(syncMutex);
+        syncRequested.notify_one();
+        syncDone.wait(lock, [this, ticket] { return syncedSeq >= ticket; });
+    }
+
+    bool append(const std::vector<JournalRecord>& records) {
+        uint64_t ticket;
+        if (!write(records, ticket)) return false;
+        waitDurable(ticket);
+        return true;
+    }
+
+    bool append(const JournalRecord& record) {
+        return append(std::vector<JournalRecord>{record});
+    }
+
+    // Move the current log to rotatedPath and continue in a fresh, empty file.
+    // Used by compaction: everything in the rotated file is folded into a snapshot.
+    // The flusher is held out for the whole swap: an fdatasync it already started
+    // on the old descriptor is waited for, and it cannot start another until the
+    // new descriptor is in place.
+    bool rotate(const std::string& rotatedPath) {
+        std::lock_guard<std::mutex> lock(writeMutex);
+        if (fd < 0) return false;
+        std::unique_lock<std::mutex> syncLock(syncMutex);
+        syncDone.wait(syncLock, [this] { return !syncing; });
+
+        ::fdatasync(fd);
+        uint64_t target = appendedSeq;  // No appends while writeMutex is held
+        if (::rename(path.c_str(), rotatedPath.c_str()) != 0) return false;
+
+        int fresh = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_TRUNC | O_CLOEXEC, 0644);
+        if (fresh < 0) return false;
+        ::close(fd);
+        fd = fresh;
+        syncedSeq = std::max(syncedSeq, target);  // Everything so far was synced above
+        bytesWritten = 0;
+        failed = false;
+        syncLock.unlock();
+        syncDone.notify_all();
+        return true;
+    }
+
+    // Empty the log (after its contents were written into a snapshot)
+    bool truncate() {
+        std::lock_guard<std::mutex> lock(writeMutex);
+        if (fd < 0 || ::ftruncate(fd, 0) != 0) return false;
+        ::fdatasync(fd);
+        bytesWritten = 0;
+        failed = false;
+        return true;
+    }
+
+    // Feed every intact record of a journal file to apply(const JournalRecord&), in order.
+    // A torn or corrupt tail is cut off so later appends start on a record boundary.
+    // Returns the number of records replayed (0 if the file does not exist).
+    template<typename Apply>
+    static size_t replay(const std::string& journalPath, Apply apply) {
+        int in = ::open(journalPath.c_str(), O_RDONLY | O_CLOEXEC);
+        if (in < 0) return 0;
+
+        std::string data;
+        char chunk[65536];
+        ssize_t got;
+        while ((got = ::read(in, chunk, sizeof(chunk))) > 0) {
+            data.append(chunk, got);
+        }
+        ::close(in);
+
+        size_t offset = 0;
+        size_t replayed = 0;
+        JournalRecord record;
+        while (data.size() - offset >= 8) {
+            uint32_t length, checksum;
+            std::memcpy(&length, data.data() + offset, sizeof(length));
+            std::memcpy(&checksum, data.data() + offset + 4, sizeof(checksum));
+            if (data.size() - offset - 8 < length) break;
+
+            const char* payload = data.data() + offset + 8;
+            if (crc32(payload, length) != checksum || !decode(payload, length, record)) break;
+            apply(static_cast<const JournalRecord&>(record));
+            offset += 8 + length;
+            replayed++;
+        }
+
+        if (offset < data.size()) {
+            std::cerr << "⚠️  Journal " << journalPath << ": discarding " << (data.size() - offset)
+                      << " bytes of incomplete or corrupt records" << std::endl;
+            if (::truncate(journalPath.c_str(), offset) != 0) {
+                std::cerr << "⚠️  Could not truncate " << journalPath << std::endl;
+            }
+        }
+        return replayed;
+    }
+};
+
+#endif // CUSTOMER_JOURNAL_HPP
@@ -0,0 +1,539 @@
+#ifndef CUSTOMER_JSON_HPP
+#define CUSTOMER_JSON_HPP
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <charconv>
+#include <stdexcept>
+#include <cstring>
+#include <cerrno>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+// Read-only view of a whole file, memory-mapped when possible
+class MappedFile {
+private:
+    const char* bytes;
+    size_t length;
+    bool mapped;
+    std::string fallback;  // Used for files mmap cannot handle (empty files, pipes)
+
+public:
+    MappedFile() : bytes(nullptr), length(0), mapped(false) {}
+
+    ~MappedFile() {
+        close();
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const std::string& path) {
+        close();
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) return false;
+
+        struct stat info;
+        if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0) {
+            void* address = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (address != MAP_FAILED) {
+                madvise(address, info.st_size, MADV_SEQUENTIAL);
+                bytes = static_cast<const char*>(address);
+                length = info.st_size;
+                mapped = true;
+                ::close(fd);
+                return true;
+            }
+        }
+
+        char buffer[65536];
+        ssize_t got;
+        while ((got = ::read(fd, buffer, sizeof(buffer))) > 0) {
+            fallback.append(buffer, got);
+        }
+        ::close(fd);
+        if (got < 0) return false;
+        bytes = fallback.data();
+        length = fallback.size();
+        return true;
+    }
+
+    void close() {
+        if (mapped) munmap(const_cast<char*>(bytes), length);
+        bytes = nullptr;
+        length = 0;
+        mapped = false;
+        fallback.clear();
+    }
+
+    const char* data() const { return bytes; }
+    size_t size() const { return length; }
+};
+
+// Identity of a file's current contents as seen by stat(). A file replaced by
+// rename or rewritten in place gets a different stamp.
+struct FileStamp {
+    dev_t device = 0;
+    ino_t inode = 0;
+    off_t size = 0;
+    long long modifiedNs = 0;
+
+    bool operator==(const FileStamp& other) const {
+        return device == other.device && inode == other.inode &&
+               size == other.size && modifiedNs == other.modifiedNs;
+    }
+    bool operator!=(const FileStamp& other) const { return !(*this == other); }
+};
+
+// Stamp of the file at path; a missing file gets the empty stamp
+inline FileStamp statFile(const std::string& path) {
+    FileStamp stamp;
+    struct stat info;
+    if (::stat(path.c_str(), &info) == 0) {
+        stamp.device = info.st_dev;
+        stamp.inode = info.st_ino;
+        stamp.size = info.st_size;
+        stamp.modifiedNs = static_cast<long long>(info.st_mtim.tv_sec) * 1000000000LL + info.st_mtim.tv_nsec;
+    }
+    return stamp;
+}
+
+// Thrown for JSON syntax errors; offset is the byte position in the input
+class JsonParseError : public std::runtime_error {
+public:
+    size_t offset;
+    JsonParseError(const std::string& message, size_t at) : std::runtime_error(message), offset(at) {}
+};
+
+// Pull tokenizer over an in-memory JSON document.
+// Strings without escapes are returned as views into the input; numbers are
+// converted with std::from_chars, so reading does not allocate.
+class JsonReader {
+private:
+    const char* begin;
+    const char* cursor;
+    const char* end;
+
+    [[noreturn]] void fail(const std::string& message) const {
+        throw JsonParseError(message, cursor - begin);
+    }
+
+    static void appendUtf8(std::string& out, unsigned int code) {
+        if (code < 0x80) {
+            out += static_cast<char>(code);
+        } else if (code < 0x800) {
+            out += static_cast<char>(0xC0 | (code >> 6));
+            out += static_cast<char>(0x80 | (code & 0x3F));
+        } else if (code < 0x10000) {
+            out += static_cast<char>(0xE0 | (code >> 12));
+            out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (code & 0x3F));
+        } else {
+            out += static_cast<char>(0xF0 | (code >> 18));
+            out += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+            out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (code & 0x3F));
+        }
+    }
+
+    unsigned int readHex4() {
+        if (end - cursor < 4) fail("truncated \\u escape");
+        unsigned int value = 0;
+        for (int i = 0; i < 4; i++) {
+            char c = *cursor++;
+            value <<= 4;
+            if (c >= '0' && c <= '9') value |= c - '0';
+            else if (c >= 'a' && c <= 'f') value |= c - 'a' + 10;
+            else if (c >= 'A' && c <= 'F') value |= c - 'A' + 10;
+            else fail("invalid \\u escape");
+        }
+        return value;
+    }
+
+public:
+    JsonReader(const char* data, size_t size) : begin(data), cursor(data), end(data + size) {}
+
+    size_t offset() const { return cursor - begin; }
+
+    void skipWhitespace() {
+        while (cursor < end && (*cursor == ' ' || *cursor == '\n' || *cursor == '\r' || *cursor == '\t')) {
+            cursor++;
+        }
+    }
+
+    // Next significant character, or '\0' at end of input
+    char peek() {
+        skipWhitespace();
+        return cursor < end ? *cursor : '\0';
+    }
+
+    bool atEnd() {
+        skipWhitespace();
+        return cursor >= end;
+    }
+
+    void expect(char c) {
+        if (peek() != c) fail(std::string("expected '") + c + "'");
+        cursor++;
+    }
+
+    // Consume c if it is next
+    bool consume(char c) {
+        if (peek() != c) return false;
+        cursor++;
+        return true;
+    }
+
+    // After an element inside an object/array: true if another one follows
+    bool nextElement(char close) {
+        if (consume(',')) return true;
+        if (consume(close)) return false;
+        fail(std::string("expected ',' or '") + close + "'");
+    }
+
+    // Read a string. Returns a view into the input, or into scratch if it had escapes.
+    std::string_view readString(std::string& scratch) {
+        expect('"');
+        const char* start = cursor;
+        while (cursor < end && *cursor != '"' && *cursor != '\\') cursor++;
+        if (cursor >= end) fail("unterminated string");
+        if (*cursor == '"') {
+            return std::string_view(start, cursor++ - start);
+        }
+
+        scratch.assign(start, cursor - start);
+        while (cursor < end && *cursor != '"') {
+            char c = *cursor++;
+            if (c != '\\') {
+                scratch += c;
+                continue;
+            }
+            if (cursor >= end) break;
+            char escape = *cursor++;
+            switch (escape) {
+                case '"': scratch += '"'; break;
+                case '\\': scratch += '\\'; break;
+                case '/': scratch += '/'; break;
+                case 'b': scratch += '\b'; break;
+                case 'f': scratch += '\f'; break;
+                case 'n': scratch += '\n'; break;
+                case 'r': scratch += '\r'; break;
+                case 't': scratch += '\t'; break;
+                case 'u': {
+                    unsigned int code = readHex4();
+                    if (code >= 0xD800 && code < 0xDC00 && end - cursor >= 6 && cursor[0] == '\\' && cursor[1] == 'u') {
+                        cursor += 2;
+                        unsigned int low = readHex4();
+                        code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                    }
+                    appendUtf8(scratch, code);
+                    break;
+                }
+                default: fail("invalid escape sequence");
+            }
+        }
+        if (cursor >= end) fail("unterminated string");
+        cursor++;
+        return scratch;
+    }
+
+    double readNumber() {
+        skipWhitespace();
+        const char* start = cursor;
+        if (cursor < end && *cursor == '-') cursor++;
+        while (cursor < end && ((*cursor >= '0' && *cursor <= '9') || *cursor == '.' ||
+                                *cursor == 'e' || *cursor == 'E' || *cursor == '+' || *cursor == '-')) {
+            cursor++;
+        }
+        double value = 0;
+        auto result = std::from_chars(start, cursor, value);
+        if (start == cursor || result.ec != std::errc() || result.ptr != cursor) {
+            cursor = start;
+            fail("invalid number");
+        }
+        return value;
+    }
+
+    bool isNumberNext() {
+        char c = peek();
+        return c == '-' || (c >= '0' && c <= '9');
+    }
+
+    // Containers nested deeper than this are rejected, so untrusted input cannot
+    // exhaust the stack
+    static constexpr size_t MAX_NESTING = 64;
+
+    // Skip any value (object, array, string, number or literal)
+    void skipValue(size_t depth = 0) {
+        std::string scratch;
+        char c = peek();
+        if ((c == '{' || c == '[') && depth >= MAX_NESTING) {
+            fail("nesting deeper than " + std::to_string(MAX_NESTING) + " levels");
+        }
+        if (c == '{') {
+            cursor++;
+            if (consume('}')) return;
+            do {
+                readString(scratch);
+                expect(':');
+                skipValue(depth + 1);
+            } while (nextElement('}'));
+        } else if (c == '[') {
+            cursor++;
+            if (consume(']')) return;
+            do {
+                skipValue(depth + 1);
+            } while (nextElement(']'));
+        } else if (c == '"') {
+            readString(scratch);
+        } else if (isNumberNext()) {
+            readNumber();
+        } else {
+            for (const char* literal : {"true", "false", "null"}) {
+                size_t length = std::strlen(literal);
+                if (size_t(end - cursor) >= length && std::memcmp(cursor, literal, length) == 0) {
+                    cursor += length;
+                    return;
+                }
+            }
+            fail("unexpected character");
+        }
+    }
+};
+
+// One customer object as read from JSON
+struct CustomerRecord {
+    std::string id;
+    std::string name;
+    double averagePurchaseValue = 0;
+    double purchaseFrequency = 0;
+    double customerLifespan = 0;
+};
+
+// A record that could not be loaded, with where it started in the file.
+// line and column are 0 until locateJSONErrors fills them in.
+struct CustomerJSONError {
+    size_t offset = 0;
+    size_t line = 0;
+    size_t column = 0;
+    std::string message;
+};
+
+// 1-based line and column of the first count errors (which are in file order),
+// in one forward pass over the document
+inline void locateJSONErrors(const char* data, size_t size, std::vector<CustomerJSONError>& errors, size_t count) {
+    size_t line = 1, lineStart = 0, scanned = 0;
+    for (size_t i = 0; i < errors.size() && i < count; i++) {
+        size_t at = errors[i].offset < size ? errors[i].offset : size;
+        while (scanned < at) {
+            const void* newline = std::memchr(data + scanned, '\n', at - scanned);
+            if (!newline) {
+                scanned = at;
+                break;
+            }
+            line++;
+            lineStart = static_cast<const char*>(newline) - data + 1;
+            scanned = lineStart;
+        }
+        errors[i].line = line;
+        errors[i].column = at - lineStart + 1;
+    }
+}
+
+// Read one customer object at the reader's position into record. Returns an
+// empty string, or why the object is not a valid customer (missing or mistyped
+// fields); the whole object is consumed either way. Throws JsonParseError on
+// malformed JSON.
+inline std::string readCustomerObject(JsonReader& reader, std::string& scratch, CustomerRecord& record) {
+    record = CustomerRecord();
+    bool hasId = false, hasName = false, hasAov = false, hasFreq = false, hasLifespan = false;
+    std::string problem;
+
+    reader.expect('{');
+    if (!reader.consume('}')) {
+        do {
+            std::string_view key = reader.readString(scratch);
+            reader.expect(':');
+            bool isString = reader.peek() == '"';
+            bool isNumber = reader.isNumberNext();
+
+            if (key == "id" && isString) {
+                record.id = reader.readString(scratch);
+                hasId = true;
+            } else if (key == "name" && isString) {
+                record.name = reader.readString(scratch);
+                hasName = true;
+            } else if (key == "averagePurchaseValue" && isNumber) {
+                record.averagePurchaseValue = reader.readNumber();
+                hasAov = true;
+            } else if (key == "purchaseFrequency" && isNumber) {
+                record.purchaseFrequency = reader.readNumber();
+                hasFreq = true;
+            } else if (key == "customerLifespan" && isNumber) {
+                record.customerLifespan = reader.readNumber();
+                hasLifespan = true;
+            } else {
+                if (key == "id" || key == "name" || key == "averagePurchaseValue" ||
+                    key == "purchaseFrequency" || key == "customerLifespan") {
+                    problem = "field '" + std::string(key) + "' has the wrong type";
+                }
+                reader.skipValue();
+            }
+        } while (reader.nextElement('}'));
+    }
+
+    if (problem.empty()) {
+        if (!hasId) problem = "missing 'id'";
+        else if (!hasName) problem = "missing 'name'";
+        else if (!hasAov || !hasFreq || !hasLifespan) problem = "missing a metric field";
+    }
+    return problem;
+}
+
+// Parse the customers from a customers.json document: either an object with a
+// "customers" array (other keys ignored) or a bare array. Keys may appear in any
+// order and unknown keys are skipped. onRecord(CustomerRecord&) may move the
+// strings out of the record and returns an
+// empty string to accept a record or a reason to reject it. Records with missing
+// or mistyped fields are reported in errors (by byte offset) and skipped; a syntax
+// error stops parsing and is reported as the last error. Returns false on a syntax error.
+template<typename OnRecord>
+bool parseCustomersJSON(const char* data, size_t size, OnRecord onRecord, std::vector<CustomerJSONError>& errors) {
+    JsonReader reader(data, size);
+    std::string scratch;
+    CustomerRecord record;
+
+    // Offsets only: turning them into lines is left to locateJSONErrors, for the errors shown
+    auto report = [&](size_t at, const std::string& message) {
+        CustomerJSONError error;
+        error.offset = at;
+        error.message = message;
+        errors.push_back(std::move(error));
+    };
+
+    try {
+        if (reader.atEnd()) return true;
+
+        // Find the customers array
+        if (reader.peek() == '{') {
+            reader.expect('{');
+            bool found = false;
+            if (!reader.consume('}')) {
+                do {
+                    std::string_view key = reader.readString(scratch);
+                    reader.expect(':');
+                    if (!found && key == "customers" && reader.peek() == '[') {
+                        found = true;
+                        break;
+                    }
+                    reader.skipValue();
+                } while (reader.nextElement('}'));
+            }
+            if (!found) return true;
+        }
+
+        reader.expect('[');
+        if (reader.consume(']')) return true;
+        do {
+            reader.skipWhitespace();
+            size_t recordStart = reader.offset();
+            if (reader.peek() != '{') {
+                report(recordStart, "expected a customer object");
+                reader.skipValue();
+                continue;
+            }
+
+            std::string problem = readCustomerObject(reader, scratch, record);
+            if (problem.empty()) problem = onRecord(record);
+            if (!problem.empty()) {
+                report(recordStart, problem);
+            }
+        } while (reader.nextElement(']'));
+    } catch (const JsonParseError& e) {
+        report(e.offset, e.what());
+        return false;
+    }
+    return true;
+}
+
+// ---- Serialization ----
+
+// Append a double in its shortest round-trip form (locale independent)
+inline void appendJSONNumber(std::string& out, double value) {
+    char digits[32];
+    auto result = std::to_chars(digits, digits + sizeof(digits), value);
+    out.append(digits, result.ptr - digits);
+}
+
+inline void appendJSONNumber(std::string& out, size_t value) {
+    char digits[24];
+    auto result = std::to_chars(digits, digits + sizeof(digits), value);
+    out.append(digits, result.ptr - digits);
+}
+
+// Append a quoted, escaped JSON string
+inline void appendJSONString(std::string& out, std::string_view value) {
+    static const char hex[] = "0123456789abcdef";
+    out += '"';
+    size_t runStart = 0;
+    for (size_t i = 0; i < value.size(); i++) {
+        unsigned char c = value[i];
+        if (c != '"' && c != '\\' && c >= 0x20) continue;
+        out.append(value.data() + runStart, i - runStart);
+        runStart = i + 1;
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                out += "\\u00";
+                out += hex[c >> 4];
+                out += hex[c & 0xF];
+        }
+    }
+    out.append(value.data() + runStart, value.size() - runStart);
+    out += '"';
+}
+
+// Write contents to path so readers only ever see the old or the new file:
+// write a temp file next to it in one pass, fsync it, then rename over path.
+inline bool writeFileAtomically(const std::string& path, const std::string& contents, std::string& error) {
+    std::string tempPath = path + ".tmp." + std::to_string(getpid());
+    int fd = ::open(tempPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        error = "could not create " + tempPath + ": " + std::strerror(errno);
+        return false;
+    }
+
+    size_t written = 0;
+    while (written < contents.size()) {
+        ssize_t n = ::write(fd, contents.data() + written, contents.size() - written);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) {
+            error = "write to " + tempPath + " failed: " + std::strerror(errno);
+            ::close(fd);
+            ::unlink(tempPath.c_str());
+            return false;
+        }
+        written += n;
+    }
+
+    if (::fsync(fd) != 0 || ::close(fd) != 0) {
+        error = "could not flush " + tempPath + ": " + std::strerror(errno);
+        ::unlink(tempPath.c_str());
+        return false;
+    }
+    if (::rename(tempPath.c_str(), path.c_str()) != 0) {
+        error = "could not replace " + path + ": " + std::strerror(errno);
+        ::unlink(tempPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+#endif // CUSTOMER_JSON_HPP
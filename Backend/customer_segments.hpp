@@ -0,0 +1,377 @@
+#ifndef CUSTOMER_SEGMENTS_HPP
+#define CUSTOMER_SEGMENTS_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "task_pool.hpp"
+
+// Customer segmentation with bitmap indexes.
+//
+// Two segmentations are kept over the table's rows:
+//   - CLV tiers: cut at configurable CLV quantiles (e.g. bronze below the
+//     median, silver to P80, gold to P95, platinum above)
+//   - RFM-style scores: AOV, frequency and lifespan each scored 1..levels by
+//     their own quantiles (5 = top fifth with the default 5 levels)
+//
+// Every tier and every score level owns a bitmap with one bit per row, so a
+// segment such as "gold tier, frequency score 4-5" is the AND/OR of a few
+// bitmaps and its members are found without looking at other rows.
+//
+// Cut points are computed from the data on rebuild (whole-table loads,
+// recomputes, large imports, or on request). Single adds, updates and removals
+// are assigned against the current cut points and only touch their own bits;
+// once they amount to more than an eighth of the table the cut points are
+// reported stale and the owner rebuilds, so the cost stays amortized O(1).
+
+// One bit per row
+class RowBitmap {
+    std::vector<uint64_t> words;
+
+public:
+    void set(size_t row) {
+        if ((row >> 6) >= words.size()) words.resize((row >> 6) + 1, 0);
+        words[row >> 6] |= uint64_t(1) << (row & 63);
+    }
+
+    void reset(size_t row) {
+        if ((row >> 6) < words.size()) words[row >> 6] &= ~(uint64_t(1) << (row & 63));
+    }
+
+    bool test(size_t row) const {
+        return (row >> 6) < words.size() && (words[row >> 6] >> (row & 63)) & 1;
+    }
+
+    void clear() { words.clear(); }
+    void resizeRows(size_t rows) { words.assign((rows + 63) / 64, 0); }
+    std::vector<uint64_t>& data() { return words; }
+    const std::vector<uint64_t>& data() const { return words; }
+
+    size_t count() const {
+        size_t total = 0;
+        for (uint64_t word : words) total += __builtin_popcountll(word);
+        return total;
+    }
+
+    // Rows in ascending order
+    template<typename Visitor>
+    void forEach(Visitor visit) const {
+        for (size_t w = 0; w < words.size(); w++) {
+            for (uint64_t word = words[w]; word != 0; word &= word - 1) {
+                visit(w * 64 + __builtin_ctzll(word));
+            }
+        }
+    }
+
+    // Up to limit rows, skipping the first offset; whole words are skipped by popcount
+    std::vector<size_t> page(size_t offset, size_t limit) const {
+        std::vector<size_t> rows;
+        for (size_t w = 0; w < words.size() && rows.size() < limit; w++) {
+            uint64_t word = words[w];
+            size_t bits = __builtin_popcountll(word);
+            if (offset >= bits) {
+                offset -= bits;
+                continue;
+            }
+            for (; word != 0 && rows.size() < limit; word &= word - 1) {
+                if (offset > 0) {
+                    offset--;
+                    continue;
+                }
+                rows.push_back(w * 64 + __builtin_ctzll(word));
+            }
+        }
+        return rows;
+    }
+
+    RowBitmap& operator&=(const RowBitmap& other) {
+        if (words.size() > other.words.size()) words.resize(other.words.size());
+        for (size_t w = 0; w < words.size(); w++) words[w] &= other.words[w];
+        return *this;
+    }
+
+    RowBitmap& operator|=(const RowBitmap& other) {
+        if (words.size() < other.words.size()) words.resize(other.words.size(), 0);
+        for (size_t w = 0; w < other.words.size(); w++) words[w] |= other.words[w];
+        return *this;
+    }
+};
+
+struct SegmentConfig {
+    std::vector<double> tierQuantiles{0.5, 0.8, 0.95};                        // Ascending, in (0, 1)
+    std::vector<std::string> tierNames{"bronze", "silver", "gold", "platinum"};  // One more than the cuts
+    size_t levels = 5;                                                          // RFM score levels
+
+    // Empty if usable, otherwise what is wrong
+    std::string validate() const {
+        for (size_t i = 0; i < tierQuantiles.size(); i++) {
+            if (!(tierQuantiles[i] > 0 && tierQuantiles[i] < 1)) return "tier quantiles must be between 0 and 1";
+            if (i > 0 && !(tierQuantiles[i] > tierQuantiles[i - 1])) return "tier quantiles must be ascending";
+        }
+        if (tierNames.size() != tierQuantiles.size() + 1) return "there must be one more tier name than quantiles";
+        for (size_t i = 0; i < tierNames.size(); i++) {
+            if (tierNames[i].empty()) return "tier names must not be empty";
+            for (size_t j = 0; j < i; j++) {
+                if (tierNames[i] == tierNames[j]) return "tier names must be unique";
+            }
+        }
+        if (tierNames.size() > 64) return "at most 64 tiers";
+        if (levels < 2 || levels > 10) return "levels must be between 2 and 10";
+        return "";
+    }
+};
+
+// Which rows a segment query selects: an optional tier and, per metric, a score range
+struct SegmentQuery {
+    std::string tier;                // Empty = any tier
+    size_t minScore[3] = {1, 1, 1};  // AOV, frequency, lifespan; 1-based inclusive
+    size_t maxScore[3] = {0, 0, 0};  // 0 = up to the highest level
+};
+
+class SegmentIndex {
+public:
+    enum Metric { AOV = 0, FREQUENCY = 1, LIFESPAN = 2 };
+
+private:
+    SegmentConfig config;
+    std::vector<double> tierCuts;        // CLV at each tier quantile
+    std::vector<double> scoreCuts[3];    // levels - 1 cut points per metric
+    std::vector<RowBitmap> tierRows;     // One bitmap per tier
+    std::vector<RowBitmap> scoreRows[3]; // One bitmap per score level, per metric
+    std::vector<uint8_t> rowTier;        // Tier of every row (to clear its bits later)
+    std::vector<uint8_t> rowScore[3];    // 0-based score of every row, per metric
+    std::vector<size_t> tierSizes;       // Members per tier
+    std::vector<double> tierTotals;      // CLV sum per tier
+    size_t rebuiltRows = 0;              // Rows at the last rebuild
+    size_t changes = 0;                  // Adds, updates and removals since then
+
+    // Bucket of value among ascending cuts; a value equal to a cut goes above it
+    static uint8_t bucket(const std::vector<double>& cuts, double value) {
+        return static_cast<uint8_t>(std::upper_bound(cuts.begin(), cuts.end(), value) - cuts.begin());
+    }
+
+    // Values at the given quantiles (ascending), partitioning a copy of the column
+    static std::vector<double> quantileCuts(const double* column, size_t count, const std::vector<double>& quantiles) {
+        std::vector<double> cuts;
+        if (count == 0) return cuts;
+        std::vector<double> values(column, column + count);
+        size_t from = 0;
+        for (double q : quantiles) {
+            size_t at = std::min(count - 1, static_cast<size_t>(q * count));
+            // Earlier cuts already partitioned everything below `from`
+            std::nth_element(values.begin() + from, values.begin() + at, values.end());
+            cuts.push_back(values[at]);
+            from = at;
+        }
+        return cuts;
+    }
+
+    void setBits(size_t row) {
+        tierRows[rowTier[row]].set(row);
+        for (int m = 0; m < 3; m++) scoreRows[m][rowScore[m][row]].set(row);
+    }
+
+    void clearBits(size_t row) {
+        tierRows[rowTier[row]].reset(row);
+        for (int m = 0; m < 3; m++) scoreRows[m][rowScore[m][row]].reset(row);
+    }
+
+    void assign(size_t row, double clv, double aov, double freq, double lifespan) {
+        rowTier[row] = bucket(tierCuts, clv);
+        rowScore[AOV][row] = bucket(scoreCuts[AOV], aov);
+        rowScore[FREQUENCY][row] = bucket(scoreCuts[FREQUENCY], freq);
+        rowScore[LIFESPAN][row] = bucket(scoreCuts[LIFESPAN], lifespan);
+    }
+
+public:
+    SegmentIndex() { clear(); }
+
+    const SegmentConfig& getConfig() const { return config; }
+    const std::vector<double>& getTierCuts() const { return tierCuts; }
+    const std::vector<double>& getScoreCuts(Metric metric) const { return scoreCuts[metric]; }
+    size_t tierCount() const { return tierRows.size(); }
+    size_t rowCount() const { return rowTier.size(); }
+    size_t tierOf(size_t row) const { return rowTier[row]; }
+    size_t scoreOf(Metric metric, size_t row) const { return rowScore[metric][row] + 1; }
+
+    // The cut points no longer describe the data well
+    bool stale() const { return changes > rebuiltRows / 8; }
+    const RowBitmap& tier(size_t index) const { return tierRows[index]; }
+    size_t tierSize(size_t index) const { return tierSizes[index]; }
+    double tierTotal(size_t index) const { return tierTotals[index]; }
+    const RowBitmap& score(Metric metric, size_t level) const { return scoreRows[metric][level]; }
+
+    int findTier(const std::string& name) const {
+        for (size_t i = 0; i < config.tierNames.size(); i++) {
+            if (config.tierNames[i] == name) return static_cast<int>(i);
+        }
+        return -1;
+    }
+
+    // Drop all rows; the configuration and cut points stay
+    void clear() {
+        rebuiltRows = 0;
+        changes = 0;
+        tierRows.assign(config.tierNames.size(), RowBitmap());
+        tierSizes.assign(config.tierNames.size(), 0);
+        tierTotals.assign(config.tierNames.size(), 0.0);
+        rowTier.clear();
+        for (int m = 0; m < 3; m++) {
+            scoreRows[m].assign(config.levels, RowBitmap());
+            rowScore[m].clear();
+        }
+    }
+
+    // New configuration; takes effect with the next rebuild
+    void configure(const SegmentConfig& next) {
+        config = next;
+        tierCuts.clear();
+        for (int m = 0; m < 3; m++) scoreCuts[m].clear();
+        clear();
+    }
+
+    // Recompute the cut points from the columns and reassign every row
+    void rebuild(TaskPool& pool, const double* clv, const double* aov, const double* freq, const double* lifespan,
+                 size_t count) {
+        std::vector<double> levelQuantiles;
+        for (size_t level = 1; level < config.levels; level++) {
+            levelQuantiles.push_back(static_cast<double>(level) / config.levels);
+        }
+        // The four cut computations are independent
+        const double* columns[4] = {clv, aov, freq, lifespan};
+        std::vector<double> cuts[4];
+        pool.parallelFor(4, 1, [&](size_t begin, size_t end) {
+            for (size_t c = begin; c < end; c++) {
+                cuts[c] = quantileCuts(columns[c], count, c == 0 ? config.tierQuantiles : levelQuantiles);
+            }
+        });
+        tierCuts = cuts[0];
+        for (int m = 0; m < 3; m++) scoreCuts[m] = cuts[m + 1];
+
+        clear();
+        rowTier.resize(count);
+        for (auto& bitmap : tierRows) bitmap.resizeRows(count);
+        for (int m = 0; m < 3; m++) {
+            rowScore[m].resize(count);
+            for (auto& bitmap : scoreRows[m]) bitmap.resizeRows(count);
+        }
+        // Chunks are multiples of 64 rows, so no two threads write the same bitmap
+        // word; per-tier sums are merged in chunk order
+        const size_t tiers = tierRows.size();
+        std::vector<double> totals = pool.parallelReduce(count, TaskPool::DEFAULT_GRAIN, std::vector<double>(tiers, 0.0),
+            [&](size_t begin, size_t end) {
+                std::vector<double> part(tiers, 0.0);
+                for (size_t row = begin; row < end; row++) {
+                    assign(row, clv[row], aov[row], freq[row], lifespan[row]);
+                    setBits(row);
+                    part[rowTier[row]] += clv[row];
+                }
+                return part;
+            },
+            [](std::vector<double> total, const std::vector<double>& part) {
+                for (size_t t = 0; t < total.size(); t++) total[t] += part[t];
+                return total;
+            });
+        tierTotals = totals;
+        for (size_t t = 0; t < tiers; t++) tierSizes[t] = tierRows[t].count();
+        rebuiltRows = count;
+    }
+
+    // A row was appended (row == rowCount())
+    void add(size_t row, double clv, double aov, double freq, double lifespan) {
+        rowTier.resize(row + 1);
+        for (int m = 0; m < 3; m++) rowScore[m].resize(row + 1);
+        assign(row, clv, aov, freq, lifespan);
+        setBits(row);
+        tierSizes[rowTier[row]]++;
+        tierTotals[rowTier[row]] += clv;
+        changes++;
+    }
+
+    // A row's values changed; previousCLV is what it was indexed with
+    void update(size_t row, double previousCLV, double clv, double aov, double freq, double lifespan) {
+        clearBits(row);
+        tierSizes[rowTier[row]]--;
+        tierTotals[rowTier[row]] -= previousCLV;
+        assign(row, clv, aov, freq, lifespan);
+        setBits(row);
+        tierSizes[rowTier[row]]++;
+        tierTotals[rowTier[row]] += clv;
+        changes++;
+    }
+
+    // Row (with the given CLV) was removed and the last row moved into its place
+    void remove(size_t row, double clv) {
+        size_t last = rowTier.size() - 1;
+        clearBits(row);
+        tierSizes[rowTier[row]]--;
+        tierTotals[rowTier[row]] -= clv;
+        if (row != last) {
+            clearBits(last);
+            rowTier[row] = rowTier[last];
+            for (int m = 0; m < 3; m++) rowScore[m][row] = rowScore[m][last];
+            setBits(row);
+        }
+        rowTier.pop_back();
+        for (int m = 0; m < 3; m++) rowScore[m].pop_back();
+        changes++;
+    }
+
+    // The query narrows at least one score below the full 1..levels range
+    bool restrictsScores(const SegmentQuery& query) const {
+        for (int m = 0; m < 3; m++) {
+            if (query.minScore[m] > 1 || (query.maxScore[m] != 0 && query.maxScore[m] < config.levels)) return true;
+        }
+        return false;
+    }
+
+    // Rows matching a query into result; false if the query names no known tier
+    bool select(const SegmentQuery& query, RowBitmap& result) const {
+        result.clear();
+        if (!query.tier.empty()) {
+            int tier = findTier(query.tier);
+            if (tier < 0) return false;
+            result = tierRows[tier];
+        } else {
+            for (const auto& bitmap : tierRows) result |= bitmap;
+        }
+        for (int m = 0; m < 3; m++) {
+            size_t low = std::max<size_t>(query.minScore[m], 1);
+            size_t high = query.maxScore[m] == 0 ? config.levels : std::min(query.maxScore[m], config.levels);
+            if (low == 1 && high == config.levels) continue;
+            if (low > high) {
+                result.clear();
+                return true;
+            }
+            RowBitmap levels;
+            for (size_t level = low; level <= high; level++) levels |= scoreRows[m][level - 1];
+            result &= levels;
+        }
+        return true;
+    }
+
+    // Member counts of every (AOV, frequency, lifespan) score combination, AOV-major
+    std::vector<size_t> scoreCellCounts() const {
+        size_t levels = config.levels;
+        std::vector<size_t> counts(levels * levels * levels, 0);
+        for (size_t a = 0; a < levels; a++) {
+            for (size_t f = 0; f < levels; f++) {
+                RowBitmap pair = scoreRows[AOV][a];
+                pair &= scoreRows[FREQUENCY][f];
+                const std::vector<uint64_t>& pairWords = pair.data();
+                for (size_t l = 0; l < levels; l++) {
+                    const std::vector<uint64_t>& lifespanWords = scoreRows[LIFESPAN][l].data();
+                    size_t words = std::min(pairWords.size(), lifespanWords.size());
+                    size_t count = 0;
+                    for (size_t w = 0; w < words; w++) count += __builtin_popcountll(pairWords[w] & lifespanWords[w]);
+                    counts[(a * levels + f) * levels + l] = count;
+                }
+            }
+        }
+        return counts;
+    }
+};
+
+#endif // CUSTOMER_SEGMENTS_HPP
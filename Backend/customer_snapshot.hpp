@@ -0,0 +1,233 @@
+#ifndef CUSTOMER_SNAPSHOT_HPP
+#define CUSTOMER_SNAPSHOT_HPP
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include "customer_json.hpp"
+#include "clv_models.hpp"
+
+// Binary snapshot of the customer table.
+//
+// Layout (host byte order, every section 8-byte aligned):
+//   SnapshotHeader
+//   double   averagePurchaseValue[rows]
+//   double   purchaseFrequency[rows]
+//   double   customerLifespan[rows]
+//   double   clv[rows]
+//   uint64_t idOffsets[rows + 1]     // id i = heap[idOffsets[i], idOffsets[i + 1])
+//   uint64_t nameOffsets[rows + 1]
+//   char     heap[heapSize]          // All ids and names back to back
+//
+// The metric columns are stored exactly as CLVCalculator keeps them in memory,
+// so loading is a bounds check, a checksum pass and straight copies - no parsing.
+// The header also records the CLV model the table was computed with; files
+// written before it was recorded have zeros there (modelKind 0).
+struct SnapshotHeader {
+    char magic[8];           // "CLVSNAP\0"
+    uint32_t formatVersion;
+    uint32_t headerSize;
+    uint64_t rowCount;
+    uint64_t heapSize;
+    uint64_t payloadChecksum;  // snapshotChecksum() of everything after the header
+    uint32_t modelKind;        // CLVModelKind + 1, 0 = not recorded
+    uint32_t reserved;
+    double modelMargin;
+    double modelDiscountRate;
+};
+
+static_assert(sizeof(SnapshotHeader) == 64, "snapshot header must stay 64 bytes");
+
+const char SNAPSHOT_MAGIC[8] = {'C', 'L', 'V', 'S', 'N', 'A', 'P', '\0'};
+const uint32_t SNAPSHOT_FORMAT_VERSION = 1;
+
+// Fast 64-bit checksum over 8-byte words (multiply-rotate mixing); detects
+// truncation and corruption, not tampering
+inline uint64_t snapshotChecksum(const char* data, size_t length) {
+    const uint64_t PRIME = 0x9E3779B97F4A7C15ull;
+    uint64_t hash = length * PRIME;
+    size_t i = 0;
+    for (; i + 8 <= length; i += 8) {
+        uint64_t word;
+        std::memcpy(&word, data + i, 8);
+        hash ^= word * 0xC2B2AE3D27D4EB4Full;
+        hash = ((hash << 31) | (hash >> 33)) * PRIME;
+    }
+    uint64_t tail = 0;
+    std::memcpy(&tail, data + i, length - i);
+    hash ^= tail * 0xC2B2AE3D27D4EB4Full;
+    hash ^= hash >> 29;
+    hash *= PRIME;
+    return hash ^ (hash >> 32);
+}
+
+inline void appendAligned(std::string& out, const void* data, size_t length) {
+    out.append(static_cast<const char*>(data), length);
+    out.append((8 - out.size() % 8) % 8, '\0');
+}
+
+// Serialize the columns into buffer and replace path atomically
+inline bool writeBinarySnapshot(std::string& buffer, const std::string& path,
+                                const std::vector<std::string>& ids, const std::vector<std::string>& names,
+                                const std::vector<double>& aov, const std::vector<double>& freq,
+                                const std::vector<double>& lifespan, const std::vector<double>& clv,
+                                const CLVModel& model, std::string& error) {
+    size_t rows = ids.size();
+    std::vector<uint64_t> idOffsets(rows + 1), nameOffsets(rows + 1);
+    uint64_t heapSize = 0;
+    for (size_t i = 0; i < rows; i++) {
+        idOffsets[i] = heapSize;
+        heapSize += ids[i].size();
+    }
+    idOffsets[rows] = heapSize;
+    for (size_t i = 0; i < rows; i++) {
+        nameOffsets[i] = heapSize;
+        heapSize += names[i].size();
+    }
+    nameOffsets[rows] = heapSize;
+
+    SnapshotHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.formatVersion = SNAPSHOT_FORMAT_VERSION;
+    header.headerSize = sizeof(SnapshotHeader);
+    header.rowCount = rows;
+    header.heapSize = heapSize;
+    header.modelKind = static_cast<uint32_t>(model.kind) + 1;
+    header.modelMargin = model.params.margin;
+    header.modelDiscountRate = model.params.discountRate;
+
+    buffer.clear();
+    buffer.reserve(sizeof(header) + rows * (4 * sizeof(double) + 2 * sizeof(uint64_t)) + heapSize + 64);
+    buffer.append(reinterpret_cast<const char*>(&header), sizeof(header));
+    appendAligned(buffer, aov.data(), rows * sizeof(double));
+    appendAligned(buffer, freq.data(), rows * sizeof(double));
+    appendAligned(buffer, lifespan.data(), rows * sizeof(double));
+    appendAligned(buffer, clv.data(), rows * sizeof(double));
+    appendAligned(buffer, idOffsets.data(), (rows + 1) * sizeof(uint64_t));
+    appendAligned(buffer, nameOffsets.data(), (rows + 1) * sizeof(uint64_t));
+    for (const auto& id : ids) buffer += id;
+    for (const auto& name : names) buffer += name;
+
+    header.payloadChecksum = snapshotChecksum(buffer.data() + sizeof(header), buffer.size() - sizeof(header));
+    std::memcpy(&buffer[0], &header, sizeof(header));
+    return writeFileAtomically(path, buffer, error);
+}
+
+// Read-only view of a binary snapshot, served straight from the mapped pages
+class MappedSnapshot {
+private:
+    MappedFile file;
+    size_t rows;
+    const double* columns[4];
+    const uint64_t* idOffsets;
+    const uint64_t* nameOffsets;
+    const char* heap;
+    SnapshotHeader header;
+
+    static size_t alignedSize(size_t length) {
+        return (length + 7) & ~size_t(7);
+    }
+
+public:
+    MappedSnapshot() : rows(0), columns{}, idOffsets(nullptr), nameOffsets(nullptr), heap(nullptr), header() {}
+
+    // Map and validate the file; on failure error says why
+    bool open(const std::string& path, std::string& error) {
+        rows = 0;
+        header = SnapshotHeader();
+        if (!file.open(path)) {
+            error = "could not open " + path;
+            return false;
+        }
+        const char* data = file.data();
+        size_t size = file.size();
+
+        if (size < sizeof(header)) {
+            error = "file too short for a snapshot header";
+            return false;
+        }
+        std::memcpy(&header, data, sizeof(header));
+        if (std::memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) != 0) {
+            error = "not a CLV snapshot";
+            return false;
+        }
+        if (header.formatVersion != SNAPSHOT_FORMAT_VERSION || header.headerSize != sizeof(header)) {
+            error = "unsupported snapshot format version " + std::to_string(header.formatVersion);
+            return false;
+        }
+
+        // Sizes from the header are checked against the file before any pointer is formed
+        uint64_t n = header.rowCount;
+        if (n > size / (4 * sizeof(double))) {
+            error = "row count larger than the file";
+            return false;
+        }
+        size_t columnBytes = alignedSize(n * sizeof(double));
+        size_t offsetBytes = alignedSize((n + 1) * sizeof(uint64_t));
+        size_t heapStart = sizeof(header) + 4 * columnBytes + 2 * offsetBytes;
+        if (heapStart > size || header.heapSize != size - heapStart) {
+            error = "snapshot size does not match its header (truncated?)";
+            return false;
+        }
+        if (snapshotChecksum(data + sizeof(header), size - sizeof(header)) != header.payloadChecksum) {
+            error = "checksum mismatch (corrupt snapshot)";
+            return false;
+        }
+
+        const char* cursor = data + sizeof(header);
+        for (int c = 0; c < 4; c++) {
+            columns[c] = reinterpret_cast<const double*>(cursor);
+            cursor += columnBytes;
+        }
+        idOffsets = reinterpret_cast<const uint64_t*>(cursor);
+        nameOffsets = reinterpret_cast<const uint64_t*>(cursor + offsetBytes);
+        heap = data + heapStart;
+
+        // Offsets must be monotonic and inside the heap
+        uint64_t previous = 0;
+        for (size_t i = 0; i <= n; i++) {
+            if (idOffsets[i] < previous) { error = "corrupt id offsets"; return false; }
+            previous = idOffsets[i];
+        }
+        if (nameOffsets[0] != previous) { error = "corrupt name offsets"; return false; }
+        for (size_t i = 0; i <= n; i++) {
+            if (nameOffsets[i] < previous) { error = "corrupt name offsets"; return false; }
+            previous = nameOffsets[i];
+        }
+        if (previous != header.heapSize) {
+            error = "string heap size mismatch";
+            return false;
+        }
+
+        rows = n;
+        return true;
+    }
+
+    size_t rowCount() const { return rows; }
+
+    // CLV model the table was saved with; false if the file does not record one
+    bool model(CLVModel& model) const {
+        if (header.modelKind == 0 || header.modelKind > static_cast<uint32_t>(CLVModelKind::RETENTION) + 1) return false;
+        model.kind = static_cast<CLVModelKind>(header.modelKind - 1);
+        model.params.margin = header.modelMargin;
+        model.params.discountRate = header.modelDiscountRate;
+        return model.validate().empty();
+    }
+    const double* averagePurchaseValues() const { return columns[0]; }
+    const double* purchaseFrequencies() const { return columns[1]; }
+    const double* customerLifespans() const { return columns[2]; }
+    const double* clvs() const { return columns[3]; }
+
+    std::string_view id(size_t row) const {
+        return std::string_view(heap + idOffsets[row], idOffsets[row + 1] - idOffsets[row]);
+    }
+
+    std::string_view name(size_t row) const {
+        return std::string_view(heap + nameOffsets[row], nameOffsets[row + 1] - nameOffsets[row]);
+    }
+};
+
+#endif // CUSTOMER_SNAPSHOT_HPP
@@ -0,0 +1,313 @@
+#ifndef HTTP_PARSER_HPP
+#define HTTP_PARSER_HPP
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstring>
+
+// Incremental HTTP/1.x request parser.
+//
+// The parser works directly on the connection's receive buffer and can be fed
+// again after more bytes arrive - it resumes where it stopped instead of
+// rescanning. Request line, headers and body are exposed as string_views into
+// that buffer, so no per-line strings are allocated. Bodies are read according
+// to Content-Length or Transfer-Encoding: chunked; chunked bodies are decoded
+// in place inside the buffer.
+//
+// Views stay valid until the buffer is modified or reset() is called.
+class HttpRequestParser {
+public:
+    enum Result { INCOMPLETE, COMPLETE, ERROR };
+
+    struct Header {
+        std::string_view name;
+        std::string_view value;
+    };
+
+private:
+    enum State { REQUEST_LINE, HEADERS, BODY, CHUNK_SIZE, CHUNK_DATA, CHUNK_TRAILER, DONE, FAILED };
+
+    // Offsets are relative to the start of the request inside the buffer
+    struct Span {
+        size_t offset;
+        size_t length;
+    };
+
+    struct HeaderSpan {
+        Span name;
+        Span value;
+    };
+
+    static const size_t MAX_HEADER_BYTES = 64 * 1024;
+    static const size_t MAX_HEADERS = 100;
+
+    size_t maxBodySize;
+    State state;
+    size_t scan;            // Next unparsed byte
+    Span methodSpan, targetSpan, versionSpan;
+    std::vector<HeaderSpan> headerSpans;  // Capacity is reused across requests
+    size_t contentLength;
+    size_t bodyStart;
+    size_t bodyLength;
+    size_t chunkRemaining;
+    int errorStatus;
+    const char* base;       // Start of the current request (refreshed on every parse call)
+
+    static bool equalsIgnoreCase(std::string_view a, std::string_view b) {
+        if (a.size() != b.size()) return false;
+        for (size_t i = 0; i < a.size(); i++) {
+            char x = a[i], y = b[i];
+            if (x >= 'A' && x <= 'Z') x += 'a' - 'A';
+            if (y >= 'A' && y <= 'Z') y += 'a' - 'A';
+            if (x != y) return false;
+        }
+        return true;
+    }
+
+    static bool containsToken(std::string_view value, std::string_view token) {
+        if (value.size() < token.size()) return false;
+        for (size_t i = 0; i + token.size() <= value.size(); i++) {
+            if (equalsIgnoreCase(value.substr(i, token.size()), token)) return true;
+        }
+        return false;
+    }
+
+    std::string_view view(const Span& span) const {
+        return std::string_view(base + span.offset, span.length);
+    }
+
+    Result fail(int status) {
+        state = FAILED;
+        errorStatus = status;
+        return ERROR;
+    }
+
+    // Find the end of the line starting at scan. Returns false if it has not fully arrived yet.
+    bool nextLine(const char* data, size_t size, size_t& lineEnd, size_t& next) const {
+        const void* newline = std::memchr(data + scan, '\n', size - scan);
+        if (!newline) return false;
+        next = static_cast<const char*>(newline) - data + 1;
+        lineEnd = next - 1;
+        if (lineEnd > scan && data[lineEnd - 1] == '\r') lineEnd--;
+        return true;
+    }
+
+    static Span trim(const char* data, size_t begin, size_t end) {
+        while (begin < end && (data[begin] == ' ' || data[begin] == '\t')) begin++;
+        while (end > begin && (data[end - 1] == ' ' || data[end - 1] == '\t')) end--;
+        return Span{begin, end - begin};
+    }
+
+    bool parseRequestLine(const char* data, size_t begin, size_t end) {
+        const char* firstSpace = static_cast<const char*>(std::memchr(data + begin, ' ', end - begin));
+        if (!firstSpace) return false;
+        size_t methodEnd = firstSpace - data;
+        const char* secondSpace = static_cast<const char*>(std::memchr(data + methodEnd + 1, ' ', end - methodEnd - 1));
+        if (!secondSpace) return false;
+        size_t targetEnd = secondSpace - data;
+
+        methodSpan = Span{begin, methodEnd - begin};
+        targetSpan = Span{methodEnd + 1, targetEnd - methodEnd - 1};
+        versionSpan = Span{targetEnd + 1, end - targetEnd - 1};
+        return methodSpan.length > 0 && targetSpan.length > 0 &&
+               std::string_view(data + versionSpan.offset, versionSpan.length).substr(0, 5) == "HTTP/";
+    }
+
+    // Decide how the body is framed once the blank line ending the headers is seen
+    Result startBody() {
+        std::string_view transferEncoding = header("Transfer-Encoding");
+        std::string_view length = header("Content-Length");
+
+        bodyStart = scan;
+        bodyLength = 0;
+        if (!transferEncoding.empty()) {
+            if (!containsToken(transferEncoding, "chunked")) return fail(501);
+            state = CHUNK_SIZE;
+            return INCOMPLETE;
+        }
+        if (!length.empty()) {
+            size_t value = 0;
+            for (char c : length) {
+                if (c < '0' || c > '9') return fail(400);
+                if (value > (maxBodySize + 9) / 10) return fail(413);
+                value = value * 10 + (c - '0');
+            }
+            if (value > maxBodySize) return fail(413);
+            contentLength = value;
+            state = BODY;
+            return INCOMPLETE;
+        }
+        state = DONE;
+        return COMPLETE;
+    }
+
+public:
+    explicit HttpRequestParser(size_t maxBody = 16 * 1024 * 1024)
+        : maxBodySize(maxBody), base(nullptr) {
+        reset();
+    }
+
+    // Prepare for the next request on the same connection
+    void reset() {
+        state = REQUEST_LINE;
+        scan = 0;
+        methodSpan = targetSpan = versionSpan = Span{0, 0};
+        headerSpans.clear();
+        contentLength = 0;
+        bodyStart = 0;
+        bodyLength = 0;
+        chunkRemaining = 0;
+        errorStatus = 0;
+    }
+
+    // Parse the request that starts at buffer[start]. Call again with the same start
+    // (or the same bytes moved to a new start) after more data has been appended.
+    Result parse(std::string& buffer, size_t start = 0) {
+        if (state == DONE) return COMPLETE;
+        if (state == FAILED) return ERROR;
+
+        char* data = &buffer[0] + start;
+        size_t size = buffer.size() - start;
+        base = data;
+
+        while (true) {
+            size_t lineEnd = 0, next = 0;
+            switch (state) {
+            case REQUEST_LINE:
+            case HEADERS:
+                if (!nextLine(data, size, lineEnd, next)) {
+                    return size > MAX_HEADER_BYTES ? fail(400) : INCOMPLETE;
+                }
+                if (next > MAX_HEADER_BYTES) return fail(400);
+
+                if (state == REQUEST_LINE) {
+                    if (lineEnd == scan) {  // Tolerate blank lines before the request line
+                        scan = next;
+                        continue;
+                    }
+                    if (!parseRequestLine(data, scan, lineEnd)) return fail(400);
+                    state = HEADERS;
+                    scan = next;
+                } else if (lineEnd == scan) {
+                    scan = next;
+                    Result result = startBody();
+                    if (result != INCOMPLETE) return result;
+                } else {
+                    const char* colon = static_cast<const char*>(std::memchr(data + scan, ':', lineEnd - scan));
+                    if (!colon || colon == data + scan) return fail(400);
+                    if (headerSpans.size() >= MAX_HEADERS) return fail(400);
+                    size_t colonPos = colon - data;
+                    headerSpans.push_back(HeaderSpan{trim(data, scan, colonPos), trim(data, colonPos + 1, lineEnd)});
+                    scan = next;
+                }
+                break;
+
+            case BODY:
+                if (size - bodyStart < contentLength) return INCOMPLETE;
+                bodyLength = contentLength;
+                scan = bodyStart + contentLength;
+                state = DONE;
+                return COMPLETE;
+
+            case CHUNK_SIZE: {
+                // Size lines (with any extensions) are capped like header lines
+                if (!nextLine(data, size, lineEnd, next)) {
+                    return size - scan > MAX_HEADER_BYTES ? fail(400) : INCOMPLETE;
+                }
+                if (lineEnd - scan > MAX_HEADER_BYTES) return fail(400);
+                size_t chunkSize = 0;
+                size_t digits = 0;
+                for (size_t i = scan; i < lineEnd && data[i] != ';'; i++) {
+                    char c = data[i];
+                    int digit;
+                    if (c >= '0' && c <= '9') digit = c - '0';
+                    else if (c >= 'a' && c <= 'f') digit = c - 'a' + 10;
+                    else if (c >= 'A' && c <= 'F') digit = c - 'A' + 10;
+                    else if (c == ' ' || c == '\t') continue;
+                    else return fail(400);
+                    if (chunkSize > (maxBodySize >> 4)) return fail(413);
+                    chunkSize = (chunkSize << 4) | digit;
+                    digits++;
+                }
+                if (digits == 0) return fail(400);
+                if (bodyLength + chunkSize > maxBodySize) return fail(413);
+                scan = next;
+                chunkRemaining = chunkSize;
+                state = chunkSize == 0 ? CHUNK_TRAILER : CHUNK_DATA;
+                break;
+            }
+
+            case CHUNK_DATA: {
+                // Wait for the whole chunk plus its CRLF, then slide the data down
+                // so the decoded body stays contiguous right after the headers
+                if (size - scan < chunkRemaining + 2) return INCOMPLETE;
+                if (data[scan + chunkRemaining] == '\r') {
+                    if (data[scan + chunkRemaining + 1] != '\n') return fail(400);
+                } else if (data[scan + chunkRemaining] != '\n') {
+                    return fail(400);
+                }
+                std::memmove(data + bodyStart + bodyLength, data + scan, chunkRemaining);
+                bodyLength += chunkRemaining;
+                scan += chunkRemaining + (data[scan + chunkRemaining] == '\r' ? 2 : 1);
+                chunkRemaining = 0;
+                state = CHUNK_SIZE;
+                break;
+            }
+
+            case CHUNK_TRAILER: {
+                if (!nextLine(data, size, lineEnd, next)) {
+                    return size - scan > MAX_HEADER_BYTES ? fail(400) : INCOMPLETE;
+                }
+                bool blank = lineEnd == scan;
+                scan = next;
+                if (blank) {
+                    state = DONE;
+                    return COMPLETE;
+                }
+                break;  // Trailer fields are ignored
+            }
+
+            case DONE:
+                return COMPLETE;
+
+            case FAILED:
+                return ERROR;
+            }
+        }
+    }
+
+    std::string_view method() const { return view(methodSpan); }
+    std::string_view target() const { return view(targetSpan); }
+    std::string_view version() const { return view(versionSpan); }
+    std::string_view body() const { return std::string_view(base + bodyStart, bodyLength); }
+
+    // Value of the first header with this name (case-insensitive), empty if absent
+    std::string_view header(std::string_view name) const {
+        for (const auto& span : headerSpans) {
+            if (equalsIgnoreCase(view(span.name), name)) return view(span.value);
+        }
+        return std::string_view();
+    }
+
+    size_t headerCount() const { return headerSpans.size(); }
+
+    Header headerAt(size_t index) const {
+        return Header{view(headerSpans[index].name), view(headerSpans[index].value)};
+    }
+
+    // Bytes the complete request occupied in the buffer, including chunk framing
+    size_t requestLength() const { return scan; }
+
+    // HTTP status to answer with after ERROR
+    int error() const { return errorStatus; }
+
+    // HTTP/1.1 keeps connections open unless told otherwise; HTTP/1.0 must opt in
+    bool keepAlive() const {
+        std::string_view connection = header("Connection");
+        if (version() == "HTTP/1.1") return !containsToken(connection, "close");
+        return containsToken(connection, "keep-alive");
+    }
+};
+
+#endif // HTTP_PARSER_HPP
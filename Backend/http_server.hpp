@@ -7,25 +7,85 @@
 #include <thread>
 #include <vector>
 #include <map>
+#include <optional>
+#include <mutex>
+#include <memory>
+#include <atomic>
+#include <chrono>
+#include <unordered_map>
+#include <algorithm>
+#include <limits>
+#include <cerrno>
 #include <sys/socket.h>
+#include <sys/epoll.h>
+#include <sys/inotify.h>
 #include <netinet/in.h>
 #include <unistd.h>
 #include <cstring>
 #include <fstream>
 #include <cstdlib>
 #include "clv_calculator.hpp"
+#include "bulk_import.hpp"
+#include "worker_pool.hpp"
+#include "http_parser.hpp"
 #include "mongodb_service.hpp"
 #include "mongodb_auth_logger.hpp"
 
 class HTTPServer {
 private:
+    static const size_t MAX_REQUEST_SIZE = 16 * 1024 * 1024;
+    static const size_t MAX_PAGE_SIZE = 10000;  // Rows per page of a paged listing
+    
+    // Per-connection state owned by whichever worker is currently servicing it
+    struct Connection {
+        int fd;
+        std::string input;
+        size_t inputStart;   // Where the next unanswered request begins in input
+        HttpRequestParser parser;
+        std::string output;
+        size_t outputOffset;
+        bool broken;
+        bool closeAfterWrite;
+        int requestsServed;
+        std::atomic<bool> busy;  // Queued for or being serviced by a worker
+        std::chrono::steady_clock::time_point lastActivity;
+        std::mutex lock;
+        
+        explicit Connection(int socketFd)
+            : fd(socketFd), inputStart(0), parser(MAX_REQUEST_SIZE), outputOffset(0), broken(false), closeAfterWrite(false),
+              requestsServed(0), busy(false), lastActivity(std::chrono::steady_clock::now()) {}
+    };
+    
     int server_fd;
+    int epoll_fd;
     int port;
+    int listenBacklog;
+    int keepAliveTimeout;          // Seconds an idle keep-alive connection is kept open
+    int maxRequestsPerConnection;
+    WorkerPool* workerPool;
+    std::unordered_map<int, std::shared_ptr<Connection>> connections;
+    std::mutex connectionsMutex;
     CLVCalculator* calculator;
     MongoDBService* mongoService;
     MongoDBAuthLogger* authLogger;
     std::string allowedOrigins;
     
+    // Pre-serialized GET /api/customers body, rebuilt only when the data version changes.
+    // Published RCU-style: readers atomically grab the current immutable snapshot and
+    // never wait; one thread at a time builds the replacement and swaps it in.
+    struct ListingSnapshot {
+        unsigned long long version;
+        std::string body;
+    };
+    std::shared_ptr<const ListingSnapshot> customersListing;  // Access only via std::atomic_load/store
+    std::mutex listingRebuildMutex;
+    
+    // Optional inotify watch on the data file's directory (WATCH_DATA_FILE=1).
+    // Changes are debounced and then reloaded on a worker thread.
+    int inotify_fd;
+    bool dataFileChanged;
+    std::chrono::steady_clock::time_point dataFileChangedAt;
+    
     std::string getContentType(const std::string& path) {
         if (path.find(".html") != std::string::npos) return "text/html";
         if (path.find(".css") != std::string::npos) return "text/css";
@@ -43,14 +103,19 @@ private:
         return buffer.str();
     }
     
-    std::string createResponse(int statusCode, const std::string& contentType, const std::string& body) {
+    std::string createResponse(int statusCode, const std::string& contentType, const std::string& body,
+                               bool keepAlive = false) {
         std::stringstream response;
         response << "HTTP/1.1 " << statusCode;
         
         switch(statusCode) {
             case 200: response << " OK"; break;
+            case 400: response << " Bad Request"; break;
             case 404: response << " Not Found"; break;
+            case 409: response << " Conflict"; break;
+            case 413: response << " Payload Too Large"; break;
             case 500: response << " Internal Server Error"; break;
+            case 501: response << " Not Implemented"; break;
             default: response << " Unknown"; break;
         }
         
@@ -60,7 +125,12 @@ private:
         response << "Access-Control-Allow-Origin: " << allowedOrigins << "\r\n";
         response << "Access-Control-Allow-Methods: GET, POST, PUT, DELETE, OPTIONS\r\n";
         response << "Access-Control-Allow-Headers: Content-Type, Authorization\r\n";
-        response << "Connection: close\r\n";
+        if (keepAlive) {
+            response << "Connection: keep-alive\r\n";
+            response << "Keep-Alive: timeout=" << keepAliveTimeout << ", max=" << maxRequestsPerConnection << "\r\n";
+        } else {
+            response << "Connection: close\r\n";
+        }
         response << "\r\n";
         response << body;
         
@@ -102,115 +172,509 @@ private:
         return result;
     }
     
-    std::string handleAPIRequest(const std::string& method, const std::string& path, const std::string& body) {
+    // Serialize one customer as a JSON object; indent is the nesting of the opening brace
+    std::string customerToJSON(const Customer& customer, const std::string& indent) {
+        std::stringstream json;
+        json << "{\n";
+        json << indent << "  \"id\": \"" << CLVCalculator::escapeString(customer.id) << "\",\n";
+        json << indent << "  \"name\": \"" << CLVCalculator::escapeString(customer.name) << "\",\n";
+        json << indent << "  \"averagePurchaseValue\": " << customer.averagePurchaseValue << ",\n";
+        json << indent << "  \"purchaseFrequency\": " << customer.purchaseFrequency << ",\n";
+        json << indent << "  \"customerLifespan\": " << customer.customerLifespan << ",\n";
+        json << indent << "  \"clv\": " << customer.clv << "\n";
+        json << indent << "}";
+        return json.str();
+    }
+    
+    // Simple JSON field extraction for flat request bodies
+    static bool extractJSONString(const std::string& body, const std::string& key, std::string& value) {
+        size_t pos = body.find("\"" + key + "\"");
+        if (pos == std::string::npos) return false;
+        pos = body.find(':', pos + key.length() + 2);
+        if (pos == std::string::npos) return false;
+        size_t start = body.find('"', pos + 1);
+        if (start == std::string::npos) return false;
+        size_t end = body.find('"', start + 1);
+        if (end == std::string::npos) return false;
+        value = body.substr(start + 1, end - start - 1);
+        return true;
+    }
+    
+    static bool extractJSONNumber(const std::string& body, const std::string& key, double& value) {
+        size_t pos = body.find("\"" + key + "\"");
+        if (pos == std::string::npos) return false;
+        pos = body.find(':', pos + key.length() + 2);
+        if (pos == std::string::npos) return false;
+        pos = body.find_first_not_of(" \t\r\n\"", pos + 1);
+        if (pos == std::string::npos) return false;
+        try {
+            value = std::stod(body.substr(pos));
+            return true;
+        } catch (...) {
+            return false;
+        }
+    }
+    
+    std::string customerResponse(const Customer& customer, const std::string& message) {
         std::stringstream response;
+        response << "{\n";
+        response << "  \"status\": \"success\",\n";
+        response << "  \"message\": \"" << message << "\",\n";
+        response << "  \"customer\": " << customerToJSON(customer, "  ") << "\n";
+        response << "}";
+        return response.str();
+    }
+    
+    std::string errorResponse(const std::string& message) {
+        return "{\n  \"status\": \"error\",\n  \"message\": \"" + CLVCalculator::escapeString(message) + "\"\n}";
+    }
+    
+    // Error body and status for an add or update the calculator refused
+    std::string mutationErrorResponse(const MutationFailure& failure, int& status) {
+        switch (failure.reason) {
+            case MutationFailure::DUPLICATE_ID: status = 409; break;
+            case MutationFailure::NOT_FOUND: status = 404; break;
+            case MutationFailure::JOURNAL: status = 500; break;
+            default: status = 400; break;
+        }
+        return errorResponse(failure.message);
+    }
+    
+    // CLV model from ?model=simple|margin|discounted|retention&margin=&discount=.
+    // Starts from the active model, so omitted parameters keep its settings.
+    bool parseModelQuery(std::map<std::string, std::string>& params, CLVModel& model, std::string& error) {
+        model = calculator->getModel();
+        if (params.count("model") && !CLVModel::parseKind(urlDecode(params["model"]), model.kind)) {
+            error = "Unknown model '" + urlDecode(params["model"]) + "' (use simple, margin, discounted or retention)";
+            return false;
+        }
+        try {
+            if (!params["margin"].empty()) model.params.margin = std::stod(params["margin"]);
+            if (!params["discount"].empty()) model.params.discountRate = std::stod(params["discount"]);
+        } catch (...) {
+            error = "margin and discount must be numbers";
+            return false;
+        }
+        error = model.validate();
+        return error.empty();
+    }
+    
+    // Monte Carlo settings from ?draws=&seed=&distribution=&cv= (all inputs) and
+    // cvAOV=, cvFrequency=, cvLifespan= (one input each)
+    bool parseMonteCarloQuery(std::map<std::string, std::string>& params, MonteCarloSettings& settings,
+                              std::string& error) {
+        try {
+            if (!params["draws"].empty()) settings.draws = std::stoul(params["draws"]);
+            if (!params["seed"].empty()) settings.seed = std::stoull(params["seed"]);
+            InputUncertainty* inputs[] = {&settings.aov, &settings.frequency, &settings.lifespan};
+            const char* keys[] = {"cvAOV", "cvFrequency", "cvLifespan"};
+            for (int i = 0; i < 3; i++) {
+                if (!params["distribution"].empty() &&
+                    !InputUncertainty::parseDistribution(params["distribution"], inputs[i]->distribution)) {
+                    error = "Unknown distribution '" + urlDecode(params["distribution"]) + "' (use lognormal, normal or uniform)";
+                    return false;
+                }
+                if (!params["cv"].empty()) inputs[i]->cv = std::stod(params["cv"]);
+                if (!params[keys[i]].empty()) inputs[i]->cv = std::stod(params[keys[i]]);
+            }
+        } catch (...) {
+            error = "draws, seed and cv must be numbers";
+            return false;
+        }
+        error = settings.validate();
+        return error.empty();
+    }
+    
+    static std::string intervalToJSON(const CLVInterval& interval) {
+        std::stringstream json;
+        json << "{\"mean\": " << interval.mean << ", \"p5\": " << interval.p5
+             << ", \"p50\": " << interval.p50 << ", \"p95\": " << interval.p95 << "}";
+        return json.str();
+    }
+    
+    // Paged listing parameters: ?offset=&limit=&cursor=&sort=clv|aov|frequency|lifespan|name
+    // &order=asc|desc&name=<prefix>&minCLV=&maxCLV=&minAOV=&maxAOV=&minFrequency=
+    // &maxFrequency=&minLifespan=&maxLifespan=. Returns false (with error) if one is
+    // malformed; paged is set if any of them is present.
+    bool parseListQuery(std::map<std::string, std::string>& params, CustomerListQuery& query, bool& paged,
+                        std::string& error) {
+        static const char* const KEYS[] = {"offset", "limit", "cursor", "sort", "order", "name",
+                                           "minCLV", "maxCLV", "minAOV", "maxAOV", "minFrequency",
+                                           "maxFrequency", "minLifespan", "maxLifespan"};
+        paged = false;
+        for (const char* key : KEYS) paged = paged || params.count(key) > 0;
+        if (!paged) return true;
         
-        if (path == "/api/customers" && method == "GET") {
-            // Get all customers
-            response << "{\n  \"customers\": [\n";
-            
-            // Since we can't directly access private members, we'll read from JSON file
-            std::ifstream file("customers.json");
-            if (file.is_open()) {
-                std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
-                file.close();
-                
-                // Extract customers array from JSON
-                size_t start = content.find("\"customers\": [");
-                if (start != std::string::npos) {
-                    start = content.find("[", start);
-                    size_t end = content.find("]", start);
-                    if (end != std::string::npos) {
-                        std::string customers = content.substr(start + 1, end - start - 1);
-                        response << customers;
-                    }
+        std::string sort = params.count("sort") ? urlDecode(params["sort"]) : "clv";
+        if (sort == "clv") query.sort = CustomerSortKey::CLV;
+        else if (sort == "aov") query.sort = CustomerSortKey::AOV;
+        else if (sort == "frequency") query.sort = CustomerSortKey::FREQUENCY;
+        else if (sort == "lifespan") query.sort = CustomerSortKey::LIFESPAN;
+        else if (sort == "name") query.sort = CustomerSortKey::NAME;
+        else {
+            error = "Unknown sort '" + sort + "' (use clv, aov, frequency, lifespan or name)";
+            return false;
+        }
+        // Names read A-Z by default, metrics highest first
+        std::string order = params.count("order") ? params["order"] : (query.sort == CustomerSortKey::NAME ? "asc" : "desc");
+        if (order != "asc" && order != "desc") {
+            error = "order must be asc or desc";
+            return false;
+        }
+        query.descending = order == "desc";
+        query.namePrefix = urlDecode(params["name"]);
+        query.cursor = params["cursor"];
+        try {
+            if (!params["offset"].empty()) query.offset = std::stoul(params["offset"]);
+            if (!params["limit"].empty()) query.limit = std::stoul(params["limit"]);
+            std::pair<const char*, double*> bounds[] = {
+                {"minCLV", &query.minCLV}, {"maxCLV", &query.maxCLV},
+                {"minAOV", &query.minAOV}, {"maxAOV", &query.maxAOV},
+                {"minFrequency", &query.minFrequency}, {"maxFrequency", &query.maxFrequency},
+                {"minLifespan", &query.minLifespan}, {"maxLifespan", &query.maxLifespan}};
+            for (auto& bound : bounds) {
+                if (!params[bound.first].empty()) *bound.second = std::stod(params[bound.first]);
+            }
+        } catch (...) {
+            error = "offset, limit and the min/max filters must be numbers";
+            return false;
+        }
+        if (query.limit > MAX_PAGE_SIZE) {
+            error = "limit must be at most " + std::to_string(MAX_PAGE_SIZE);
+            return false;
+        }
+        return true;
+    }
+    
+    // A score range "4-5" or a single score "5" (scores start at 1)
+    static bool parseScoreRange(const std::string& text, size_t& low, size_t& high) {
+        try {
+            size_t used = 0;
+            size_t dash = text.find('-');
+            low = std::stoul(text.substr(0, dash), &used);
+            if (used != (dash == std::string::npos ? text.size() : dash)) return false;
+            high = low;
+            if (dash != std::string::npos) {
+                std::string upper = text.substr(dash + 1);
+                high = std::stoul(upper, &used);
+                if (used != upper.size()) return false;
+            }
+        } catch (...) {
+            return false;
+        }
+        return low >= 1 && high >= low;
+    }
+    
+    std::string segmentOverviewJSON(const SegmentOverview& overview) {
+        auto bound = [](double value) {
+            std::stringstream text;
+            if (std::isinf(value)) text << "null"; else text << value;
+            return text.str();
+        };
+        std::stringstream json;
+        json << "{\n";
+        json << "  \"status\": \"success\",\n";
+        json << "  \"model\": \"" << calculator->getModel().name() << "\",\n";
+        json << "  \"totalCustomers\": " << overview.totalCustomers << ",\n";
+        json << "  \"tiers\": [";
+        for (size_t t = 0; t < overview.tiers.size(); t++) {
+            const SegmentTier& tier = overview.tiers[t];
+            json << (t > 0 ? ",\n" : "\n");
+            json << "    {\"name\": \"" << CLVCalculator::escapeString(tier.name) << "\""
+                 << ", \"fromQuantile\": " << tier.lowerQuantile
+                 << ", \"lowerCLV\": " << bound(tier.lowerCLV) << ", \"upperCLV\": " << bound(tier.upperCLV)
+                 << ", \"customers\": " << tier.customers << ", \"totalCLV\": " << tier.totalCLV
+                 << ", \"averageCLV\": " << tier.averageCLV << "}";
+        }
+        json << "\n  ],\n";
+        json << "  \"scores\": {\n";
+        json << "    \"levels\": " << overview.levels << ",\n";
+        const char* metrics[] = {"aov", "frequency", "lifespan"};
+        for (int m = 0; m < 3; m++) {
+            json << "    \"" << metrics[m] << "Cuts\": [";
+            for (size_t i = 0; i < overview.scoreCuts[m].size(); i++) {
+                json << (i > 0 ? ", " : "") << overview.scoreCuts[m][i];
+            }
+            json << "],\n";
+        }
+        // Only the non-empty cells of the levels³ grid
+        json << "    \"cells\": [";
+        bool first = true;
+        size_t levels = overview.levels;
+        for (size_t cell = 0; cell < overview.cells.size(); cell++) {
+            if (overview.cells[cell] == 0) continue;
+            json << (first ? "\n" : ",\n");
+            first = false;
+            json << "      {\"aov\": " << cell / (levels * levels) + 1
+                 << ", \"frequency\": " << cell / levels % levels + 1
+                 << ", \"lifespan\": " << cell % levels + 1
+                 << ", \"customers\": " << overview.cells[cell] << "}";
+        }
+        json << (first ? "]\n" : "\n    ]\n");
+        json << "  }\n";
+        json << "}";
+        return json.str();
+    }
+    
+    // Query string of a request path, or "" if it has none
+    static std::string queryOf(const std::string& path) {
+        size_t queryPos = path.find('?');
+        return queryPos == std::string::npos ? "" : path.substr(queryPos + 1);
+    }
+    
+    std::shared_ptr<const ListingSnapshot> getCustomersListing() {
+        std::shared_ptr<const ListingSnapshot> current = std::atomic_load(&customersListing);
+        if (current && current->version == calculator->getDataVersion()) {
+            return current;
+        }
+        
+        // While another thread rebuilds, keep serving the previous snapshot
+        std::unique_lock<std::mutex> rebuild(listingRebuildMutex, std::try_to_lock);
+        if (!rebuild.owns_lock()) {
+            if (current) return current;
+            rebuild.lock();
+        }
+        unsigned long long version = calculator->getDataVersion();
+        current = std::atomic_load(&customersListing);
+        if (current && current->version == version) {
+            return current;
+        }
+        
+        std::stringstream listing;
+        listing << "{\n  \"customers\": [\n";
+        bool first = true;
+        calculator->forEachCustomer([&](const Customer& customer) {
+            if (!first) listing << ",\n";
+            first = false;
+            listing << "    " << customerToJSON(customer, "    ");
+        });
+        listing << "\n  ],\n";
+        listing << "  \"model\": \"" << calculator->getModel().name() << "\",\n";
+        listing << "  \"version\": " << version << ",\n";
+        listing << "  \"status\": \"success\"\n";
+        listing << "}";
+        
+        auto next = std::make_shared<const ListingSnapshot>(ListingSnapshot{version, listing.str()});
+        std::atomic_store(&customersListing, next);
+        return next;
+    }
+    
+    // JSON body for an API request; status is the HTTP status to send (200 unless a route sets it)
+    std::string handleAPIRequest(const std::string& method, const std::string& path, const std::string& body,
+                                 int& status) {
+        std::stringstream response;
+        
+        if ((path == "/api/customers" || path.find("/api/customers?") == 0) && method == "GET") {
+            // Get all customers (served from the in-memory calculator); the cached
+            // listing covers the active model, any other ?model= is valued on the fly.
+            // Paging, filter or sort parameters switch to one page from the sorted indexes.
+            auto params = parseQuery(queryOf(path));
+            CLVModel model;
+            CustomerListQuery listQuery;
+            bool paged = false;
+            std::string error;
+            if (!parseModelQuery(params, model, error) || !parseListQuery(params, listQuery, paged, error)) {
+                response << errorResponse(error);
+            } else if (paged) {
+                if (model != calculator->getModel()) {
+                    return errorResponse("Paged listings use the active model; switch it with /api/admin/recompute");
+                }
+                std::optional<CustomerPage> page = calculator->listCustomers(listQuery);
+                if (!page) {
+                    return errorResponse("Invalid cursor for this sort and order");
                 }
+                response << "{\n  \"customers\": [";
+                for (size_t i = 0; i < page->customers.size(); i++) {
+                    response << (i > 0 ? ",\n" : "\n") << "    " << customerToJSON(page->customers[i], "    ");
+                }
+                response << (page->customers.empty() ? "],\n" : "\n  ],\n");
+                response << "  \"model\": \"" << model.name() << "\",\n";
+                if (page->total) response << "  \"total\": " << *page->total << ",\n";
+                response << "  \"nextCursor\": ";
+                if (page->nextCursor.empty()) response << "null"; else response << "\"" << page->nextCursor << "\"";
+                response << ",\n";
+                response << "  \"status\": \"success\"\n";
+                response << "}";
+            } else if (model == calculator->getModel()) {
+                response << getCustomersListing()->body;
+            } else {
+                response << "{\n  \"customers\": [\n";
+                bool first = true;
+                calculator->forEachCustomer(model, [&](const Customer& customer) {
+                    if (!first) response << ",\n";
+                    first = false;
+                    response << "    " << customerToJSON(customer, "    ");
+                });
+                response << "\n  ],\n";
+                response << "  \"model\": \"" << model.name() << "\",\n";
+                response << "  \"status\": \"success\"\n";
+                response << "}";
             }
             
-            response << "\n  ],\n";
-            response << "  \"status\": \"success\"\n";
-            response << "}";
-            
         } else if (path == "/api/customers" && method == "POST") {
-            // Add new customer
-            // Parse JSON body (simplified)
+            // Add new customer from a JSON body
             std::string id, name;
             double aov = 0, freq = 0, lifespan = 0;
+            extractJSONString(body, "id", id);
+            extractJSONString(body, "name", name);
+            extractJSONNumber(body, "averagePurchaseValue", aov);
+            extractJSONNumber(body, "purchaseFrequency", freq);
+            extractJSONNumber(body, "customerLifespan", lifespan);
             
-            // Simple JSON parsing for demo
-            size_t pos = body.find("\"id\":");
-            if (pos != std::string::npos) {
-                size_t start = body.find("\"", pos + 5);
-                size_t end = body.find("\"", start + 1);
-                if (start != std::string::npos && end != std::string::npos) {
-                    id = body.substr(start + 1, end - start - 1);
-                }
+            MutationFailure failure;
+            if (id.empty() || name.empty() || aov <= 0 || freq <= 0 || lifespan <= 0) {
+                response << errorResponse("Invalid customer data");
+            } else if (!calculator->addCustomer(id, name, aov, freq, lifespan, &failure)) {
+                return mutationErrorResponse(failure, status);
+            } else {
+                persistChanges();
+                response << customerResponse(calculator->findCustomer(id).value_or(Customer(id, name, aov, freq, lifespan)),
+                                             "Customer added successfully");
             }
             
-            pos = body.find("\"name\":");
-            if (pos != std::string::npos) {
-                size_t start = body.find("\"", pos + 7);
-                size_t end = body.find("\"", start + 1);
-                if (start != std::string::npos && end != std::string::npos) {
-                    name = body.substr(start + 1, end - start - 1);
-                }
-            }
+        } else if ((path == "/api/customers/bulk" || path.find("/api/customers/bulk?") == 0) && method == "POST") {
+            // Bulk import from a CSV or NDJSON body (?format=csv|ndjson, detected if omitted)
+            size_t queryPos = path.find('?');
+            auto params = parseQuery(queryPos == std::string::npos ? "" : path.substr(queryPos + 1));
+            ImportFormat format = detectImportFormat(body.data(), body.size());
             
-            pos = body.find("\"averagePurchaseValue\":");
-            if (pos != std::string::npos) {
-                size_t start = pos + 24;
-                size_t end = body.find(",", start);
-                if (end == std::string::npos) end = body.find("}", start);
-                if (end != std::string::npos) {
-                    std::string aovStr = body.substr(start, end - start);
-                    try { aov = std::stod(aovStr); } catch (...) {}
+            if (params.count("format") && !parseImportFormat(params["format"], format)) {
+                response << errorResponse("Unknown format '" + params["format"] + "' (use csv or ndjson)");
+            } else {
+                ImportBatch batch = parseCustomersBulk(body.data(), body.size(), format);
+                
+                std::vector<CustomerRecord> records;
+                records.reserve(batch.rows.size());
+                for (auto& row : batch.rows) {
+                    records.push_back(std::move(row.record));
                 }
-            }
-            
-            pos = body.find("\"purchaseFrequency\":");
-            if (pos != std::string::npos) {
-                size_t start = pos + 20;
-                size_t end = body.find(",", start);
-                if (end == std::string::npos) end = body.find("}", start);
-                if (end != std::string::npos) {
-                    std::string freqStr = body.substr(start, end - start);
-                    try { freq = std::stod(freqStr); } catch (...) {}
+                std::vector<std::pair<size_t, std::string>> rejected;
+                size_t imported = calculator->addCustomersBatch(records, rejected);
+                if (imported > 0) persistChanges();
+                
+                // Parse errors and rejected rows, in line order
+                std::vector<ImportError> errors = std::move(batch.errors);
+                for (auto& entry : rejected) {
+                    errors.push_back(ImportError{batch.rows[entry.first].line, std::move(entry.second)});
+                }
+                std::sort(errors.begin(), errors.end(),
+                          [](const ImportError& a, const ImportError& b) { return a.line < b.line; });
+                
+                const size_t MAX_REPORTED = 100;
+                response << "{\n";
+                response << "  \"status\": \"success\",\n";
+                response << "  \"imported\": " << imported << ",\n";
+                response << "  \"rejected\": " << errors.size() << ",\n";
+                response << "  \"errors\": [";
+                for (size_t i = 0; i < errors.size() && i < MAX_REPORTED; i++) {
+                    response << (i ? ",\n" : "\n") << "    {\"line\": " << errors[i].line
+                             << ", \"message\": \"" << CLVCalculator::escapeString(errors[i].message) << "\"}";
                 }
+                response << (errors.empty() ? "]" : "\n  ]") << ",\n";
+                response << "  \"totalCustomers\": " << calculator->getCustomerCount() << "\n";
+                response << "}";
             }
             
-            pos = body.find("\"customerLifespan\":");
-            if (pos != std::string::npos) {
-                size_t start = pos + 19;
-                size_t end = body.find(",", start);
-                if (end == std::string::npos) end = body.find("}", start);
-                if (end != std::string::npos) {
-                    std::string lifespanStr = body.substr(start, end - start);
-                    try { lifespan = std::stod(lifespanStr); } catch (...) {}
+        } else if (path.find("/api/customers/") == 0) {
+            // Single customer by ID: GET, PUT (partial update) or DELETE
+            std::string id = path.substr(15);
+            size_t queryPos = id.find('?');
+            if (queryPos != std::string::npos) id = id.substr(0, queryPos);
+            
+            // Read-only sub-resources: GET /api/customers/:id/uncertainty (Monte Carlo CLV
+            // band) and GET /api/customers/:id/rank (place in the CLV order)
+            std::string resource;
+            for (const std::string suffix : {"/uncertainty", "/rank"}) {
+                if (id.size() > suffix.size() && id.compare(id.size() - suffix.size(), suffix.size(), suffix) == 0) {
+                    resource = suffix;
+                    id = id.substr(0, id.size() - suffix.size());
+                    break;
                 }
             }
+            id = urlDecode(id);
             
-            if (!id.empty() && !name.empty() && aov > 0 && freq > 0 && lifespan > 0) {
-                calculator->addCustomer(id, name, aov, freq, lifespan);
-                calculator->saveToJSON();
-                
-                double clv = aov * freq * lifespan;
+            std::optional<Customer> existing = calculator->findCustomer(id);
+            if (!existing) {
+                response << errorResponse("Customer '" + id + "' not found");
+            } else if (!resource.empty() && method != "GET") {
+                response << errorResponse("Method not allowed");
+            } else if (resource == "/rank") {
+                std::optional<CustomerRank> rank = calculator->getCustomerRank(id);
+                if (!rank) return errorResponse("Customer '" + id + "' not found");
                 response << "{\n";
                 response << "  \"status\": \"success\",\n";
-                response << "  \"message\": \"Customer added successfully\",\n";
-                response << "  \"customer\": {\n";
-                response << "    \"id\": \"" << id << "\",\n";
-                response << "    \"name\": \"" << name << "\",\n";
-                response << "    \"averagePurchaseValue\": " << aov << ",\n";
-                response << "    \"purchaseFrequency\": " << freq << ",\n";
-                response << "    \"customerLifespan\": " << lifespan << ",\n";
-                response << "    \"clv\": " << clv << "\n";
-                response << "  }\n";
+                response << "  \"customer\": " << customerToJSON(rank->customer, "  ") << ",\n";
+                response << "  \"model\": \"" << calculator->getModel().name() << "\",\n";
+                response << "  \"rank\": " << rank->rank << ",\n";
+                response << "  \"totalCustomers\": " << rank->totalCustomers << ",\n";
+                response << "  \"tiedCustomers\": " << rank->tiedCustomers << ",\n";
+                response << "  \"percentile\": " << rank->percentile << "\n";
                 response << "}";
-            } else {
+            } else if (resource == "/uncertainty") {
+                auto params = parseQuery(queryOf(path));
+                CLVModel model;
+                MonteCarloSettings settings;
+                std::string error;
+                if (!parseModelQuery(params, model, error) || !parseMonteCarloQuery(params, settings, error)) {
+                    return errorResponse(error);
+                }
+                std::optional<CLVInterval> interval = calculator->simulateCustomer(id, settings, model);
+                if (!interval) return errorResponse("Customer '" + id + "' not found");
                 response << "{\n";
-                response << "  \"status\": \"error\",\n";
-                response << "  \"message\": \"Invalid customer data\"\n";
+                response << "  \"status\": \"success\",\n";
+                response << "  \"id\": \"" << CLVCalculator::escapeString(id) << "\",\n";
+                response << "  \"model\": \"" << model.name() << "\",\n";
+                response << "  \"draws\": " << settings.draws << ",\n";
+                response << "  \"clv\": " << intervalToJSON(*interval) << "\n";
                 response << "}";
+            } else if (method == "GET") {
+                // ?model= values the customer with another CLV model
+                auto params = parseQuery(queryOf(path));
+                CLVModel model;
+                std::string error;
+                if (!parseModelQuery(params, model, error)) {
+                    response << errorResponse(error);
+                } else {
+                    response << customerResponse(calculator->findCustomer(id, model).value_or(*existing), "Customer found");
+                }
+            } else if (method == "PUT") {
+                // Fields missing from the body keep their current values
+                std::string name = existing->name;
+                double aov = existing->averagePurchaseValue;
+                double freq = existing->purchaseFrequency;
+                double lifespan = existing->customerLifespan;
+                extractJSONString(body, "name", name);
+                extractJSONNumber(body, "averagePurchaseValue", aov);
+                extractJSONNumber(body, "purchaseFrequency", freq);
+                extractJSONNumber(body, "customerLifespan", lifespan);
+                
+                MutationFailure failure;
+                if (name.empty()) {
+                    response << errorResponse("Invalid customer data");
+                } else if (!calculator->updateCustomer(id, name, aov, freq, lifespan, &failure)) {
+                    return mutationErrorResponse(failure, status);
+                } else {
+                    persistChanges();
+                    response << customerResponse(calculator->findCustomer(id).value_or(Customer(id, name, aov, freq, lifespan)),
+                                                 "Customer updated successfully");
+                }
+            } else if (method == "DELETE") {
+                if (!calculator->removeCustomer(id)) {
+                    // It existed above, so either a concurrent delete won or the journal write failed
+                    if (!calculator->findCustomer(id)) {
+                        status = 404;
+                        return errorResponse("Customer '" + id + "' not found");
+                    }
+                    status = 500;
+                    return errorResponse("Customer '" + id + "' could not be deleted (journal write failed)");
+                }
+                persistChanges();
+                response << "{\n";
+                response << "  \"status\": \"success\",\n";
+                response << "  \"message\": \"Customer deleted successfully\"\n";
+                response << "}";
+            } else {
+                response << errorResponse("Method not allowed");
             }
             
         } else if (path.find("/api/add-customer") == 0 && method == "GET") {
@@ -233,42 +697,360 @@ private:
                 if (!params["customerLifespan"].empty()) lifespan = std::stod(params["customerLifespan"]);
             } catch (...) {}
             
-            if (!id.empty() && !name.empty() && aov > 0 && freq > 0 && lifespan > 0) {
-                calculator->addCustomer(id, name, aov, freq, lifespan);
-                calculator->saveToJSON();
-                
-                double clv = aov * freq * lifespan;
-                response << "{\n";
-                response << "  \"status\": \"success\",\n";
-                response << "  \"message\": \"Customer added successfully\",\n";
-                response << "  \"customer\": {\n";
-                response << "    \"id\": \"" << id << "\",\n";
-                response << "    \"name\": \"" << name << "\",\n";
-                response << "    \"averagePurchaseValue\": " << aov << ",\n";
-                response << "    \"purchaseFrequency\": " << freq << ",\n";
-                response << "    \"customerLifespan\": " << lifespan << ",\n";
-                response << "    \"clv\": " << clv << "\n";
-                response << "  }\n";
-                response << "}";
+            MutationFailure failure;
+            if (id.empty() || name.empty() || aov <= 0 || freq <= 0 || lifespan <= 0) {
+                response << errorResponse("Invalid customer data - missing required fields");
+            } else if (!calculator->addCustomer(id, name, aov, freq, lifespan, &failure)) {
+                return mutationErrorResponse(failure, status);
             } else {
-                response << "{\n";
-                response << "  \"status\": \"error\",\n";
-                response << "  \"message\": \"Invalid customer data - missing required fields\"\n";
-                response << "}";
+                persistChanges();
+                response << customerResponse(calculator->findCustomer(id).value_or(Customer(id, name, aov, freq, lifespan)),
+                                             "Customer added successfully");
+            }
+            
+        } else if (path.find("/api/top-customers") == 0 && method == "GET") {
+            // Highest-CLV customers, served from the live leaderboard
+            std::string queryString;
+            size_t queryPos = path.find('?');
+            if (queryPos != std::string::npos) {
+                queryString = path.substr(queryPos + 1);
+            }
+            auto params = parseQuery(queryString);
+            
+            int n = 10;
+            try {
+                if (!params["n"].empty()) n = std::stoi(params["n"]);
+            } catch (...) {}
+            if (n < 0) n = 0;
+            
+            CLVModel model;
+            std::string error;
+            if (!parseModelQuery(params, model, error)) {
+                return errorResponse(error);
+            }
+            std::vector<Customer> topCustomers = calculator->getTopCustomers(n, model);
+            response << "{\n";
+            response << "  \"status\": \"success\",\n";
+            response << "  \"model\": \"" << model.name() << "\",\n";
+            response << "  \"customers\": [\n";
+            for (size_t i = 0; i < topCustomers.size(); i++) {
+                response << "    " << customerToJSON(topCustomers[i], "    ");
+                if (i < topCustomers.size() - 1) response << ",";
+                response << "\n";
             }
+            response << "  ]\n";
+            response << "}";
             
-        } else if (path == "/api/analytics" && method == "GET") {
-            // Get analytics
-            calculator->loadFromJSON(); // Refresh data
+        } else if ((path == "/api/rank" || path.find("/api/rank?") == 0) && method == "GET") {
+            // CLV order statistics from the listing's CLV index, O(log N):
+            // ?k=3 is the customer with the 3rd highest CLV (ties by ascending ID, as on the leaderboard),
+            // ?min=100&max=500 counts customers with CLV in [min, max] (either bound may be left out)
+            auto params = parseQuery(queryOf(path));
+            bool byRank = !params["k"].empty();
+            bool byRange = !params["min"].empty() || !params["max"].empty();
+            if (!byRank && !byRange) {
+                return errorResponse("Give k, or min and/or max");
+            }
+            size_t k = 0;
+            double low = -std::numeric_limits<double>::infinity();
+            double high = std::numeric_limits<double>::infinity();
+            try {
+                if (byRank) k = std::stoul(params["k"]);
+                if (!params["min"].empty()) low = std::stod(params["min"]);
+                if (!params["max"].empty()) high = std::stod(params["max"]);
+            } catch (...) {
+                return errorResponse("k must be a whole number and min and max numbers");
+            }
+            if (std::isnan(low) || std::isnan(high) || low > high) {
+                return errorResponse("min must not be greater than max");
+            }
             
+            size_t totalCustomers = calculator->getCustomerCount();
+            std::optional<Customer> customer;
+            if (byRank) {
+                customer = calculator->getKthHighestCLV(k);
+                if (!customer) {
+                    return errorResponse("k must be between 1 and the number of customers (" +
+                                         std::to_string(totalCustomers) + ")");
+                }
+            }
             response << "{\n";
             response << "  \"status\": \"success\",\n";
+            response << "  \"model\": \"" << calculator->getModel().name() << "\",\n";
+            if (byRank) {
+                response << "  \"k\": " << k << ",\n";
+                response << "  \"customer\": " << customerToJSON(*customer, "  ") << ",\n";
+            }
+            if (byRange) {
+                response << "  \"min\": ";
+                if (std::isinf(low)) response << "null"; else response << low;
+                response << ",\n  \"max\": ";
+                if (std::isinf(high)) response << "null"; else response << high;
+                response << ",\n  \"count\": " << calculator->countCustomersInCLVRange(low, high) << ",\n";
+            }
+            response << "  \"totalCustomers\": " << totalCustomers << "\n";
+            response << "}";
+            
+        } else if ((path == "/api/scenarios" || path.find("/api/scenarios?") == 0) && method == "POST") {
+            // What-if scenarios over the whole table in one scan; nothing is modified
+            auto params = parseQuery(queryOf(path));
+            CLVModel model;
+            std::string error;
+            if (!parseModelQuery(params, model, error)) {
+                status = 400;
+                return errorResponse(error);
+            }
+            std::vector<Scenario> scenarios;
+            size_t top = 10;
+            error = parseScenarioRequest(body, scenarios, top);
+            if (!error.empty()) {
+                status = 400;
+                return errorResponse(error);
+            }
+            ScenarioReport report = calculator->runScenarios(scenarios, model, top);
+            
+            response << "{\n";
+            response << "  \"status\": \"success\",\n";
+            response << "  \"model\": \"" << model.name() << "\",\n";
+            response << "  \"totalCustomers\": " << report.totalCustomers << ",\n";
+            response << "  \"baselineTotalCLV\": " << report.baselineTotalCLV << ",\n";
+            response << "  \"scenarios\": [";
+            for (size_t s = 0; s < report.scenarios.size(); s++) {
+                const ScenarioResult& result = report.scenarios[s];
+                double delta = result.totalCLV - report.baselineTotalCLV;
+                response << (s > 0 ? ",\n" : "\n");
+                response << "    {\n";
+                response << "      \"name\": \"" << CLVCalculator::escapeString(result.name) << "\",\n";
+                response << "      \"affectedCustomers\": " << result.affectedCustomers << ",\n";
+                response << "      \"totalCLV\": " << result.totalCLV << ",\n";
+                response << "      \"averageCLV\": " << result.averageCLV << ",\n";
+                response << "      \"deltaCLV\": " << delta << ",\n";
+                response << "      \"deltaPercent\": "
+                         << (report.baselineTotalCLV != 0 ? 100 * delta / report.baselineTotalCLV : 0) << ",\n";
+                response << "      \"top\": [";
+                for (size_t i = 0; i < result.top.size(); i++) {
+                    response << (i > 0 ? ",\n" : "\n") << "        " << customerToJSON(result.top[i], "        ");
+                }
+                response << (result.top.empty() ? "]\n" : "\n      ]\n");
+                response << "    }";
+            }
+            response << (report.scenarios.empty() ? "]\n" : "\n  ]\n");
+            response << "}";
+            
+        } else if ((path == "/api/segments" || path.find("/api/segments?") == 0) && method == "GET") {
+            // CLV tiers with totals and the RFM score grid, from the maintained segment indexes
+            response << segmentOverviewJSON(calculator->getSegments());
+            
+        } else if (path.find("/api/segments/members") == 0 && method == "GET") {
+            // Members of a segment: ?tier=gold&aov=4-5&frequency=5&lifespan=1-2&offset=0&limit=100
+            auto params = parseQuery(queryOf(path));
+            SegmentQuery query;
+            query.tier = urlDecode(params["tier"]);
+            const char* metrics[] = {"aov", "frequency", "lifespan"};
+            for (int m = 0; m < 3; m++) {
+                std::string range = urlDecode(params[metrics[m]]);
+                if (!range.empty() && !parseScoreRange(range, query.minScore[m], query.maxScore[m])) {
+                    return errorResponse(std::string("'") + metrics[m] + "' must be a score or a range like 4-5");
+                }
+            }
+            size_t offset = 0, limit = 100;
+            try {
+                if (!params["offset"].empty()) offset = std::stoul(params["offset"]);
+                if (!params["limit"].empty()) limit = std::stoul(params["limit"]);
+            } catch (...) {
+                return errorResponse("offset and limit must be whole numbers");
+            }
+            if (limit > MAX_PAGE_SIZE) {
+                return errorResponse("limit must be at most " + std::to_string(MAX_PAGE_SIZE));
+            }
+            std::optional<SegmentPage> page = calculator->querySegment(query, offset, limit);
+            if (!page) {
+                return errorResponse("Unknown tier '" + query.tier + "'");
+            }
+            
+            response << "{\n";
+            response << "  \"status\": \"success\",\n";
+            response << "  \"customers\": " << page->customers << ",\n";
+            response << "  \"totalCLV\": " << page->totalCLV << ",\n";
+            response << "  \"averageCLV\": " << page->averageCLV << ",\n";
+            response << "  \"offset\": " << offset << ",\n";
+            response << "  \"members\": [";
+            for (size_t i = 0; i < page->members.size(); i++) {
+                response << (i > 0 ? ",\n" : "\n") << "    " << customerToJSON(page->members[i], "    ");
+            }
+            response << (page->members.empty() ? "]\n" : "\n  ]\n");
+            response << "}";
+            
+        } else if (path.find("/api/segments/config") == 0 && method == "POST") {
+            // Re-cut the segments: ?tiers=0.5,0.8,0.95&names=bronze,silver,gold,platinum&levels=5
+            auto params = parseQuery(queryOf(path));
+            SegmentConfig config = calculator->getSegmentConfig();
+            try {
+                if (params.count("tiers")) {
+                    config.tierQuantiles.clear();
+                    std::stringstream list(urlDecode(params["tiers"]));
+                    std::string item;
+                    while (std::getline(list, item, ',')) config.tierQuantiles.push_back(std::stod(item));
+                }
+                if (!params["levels"].empty()) config.levels = std::stoul(params["levels"]);
+            } catch (...) {
+                return errorResponse("tiers and levels must be numbers");
+            }
+            if (params.count("names")) {
+                config.tierNames.clear();
+                std::stringstream list(urlDecode(params["names"]));
+                std::string item;
+                while (std::getline(list, item, ',')) config.tierNames.push_back(item);
+            } else if (config.tierNames.size() != config.tierQuantiles.size() + 1) {
+                // New cut points without names: number the tiers
+                config.tierNames.clear();
+                for (size_t t = 0; t <= config.tierQuantiles.size(); t++) {
+                    config.tierNames.push_back("tier" + std::to_string(t + 1));
+                }
+            }
+            std::string error = calculator->configureSegments(config);
+            if (!error.empty()) {
+                return errorResponse(error);
+            }
+            response << segmentOverviewJSON(calculator->getSegments());
+            
+        } else if (path.find("/api/analytics/uncertainty") == 0 && method == "GET") {
+            // Monte Carlo band of the portfolio's total CLV (one pass of draws × customers)
+            auto params = parseQuery(queryOf(path));
+            CLVModel model;
+            MonteCarloSettings settings;
+            std::string error;
+            if (!parseModelQuery(params, model, error) || !parseMonteCarloQuery(params, settings, error)) {
+                return errorResponse(error);
+            }
+            CLVInterval total = calculator->simulateCLV(settings, model);
+            size_t customers = calculator->getCustomerCount();
+            
+            response << "{\n";
+            response << "  \"status\": \"success\",\n";
+            response << "  \"model\": \"" << model.name() << "\",\n";
+            response << "  \"draws\": " << settings.draws << ",\n";
+            response << "  \"seed\": " << settings.seed << ",\n";
+            response << "  \"totalCustomers\": " << customers << ",\n";
+            response << "  \"totalCLV\": " << intervalToJSON(total) << "\n";
+            response << "}";
+            
+        } else if (path.find("/api/analytics/distribution") == 0 && method == "GET") {
+            // CLV percentiles (?q=0.5,0.9,0.99) and histogram, from bounded-memory sketches
+            std::string queryString;
+            size_t queryPos = path.find('?');
+            if (queryPos != std::string::npos) {
+                queryString = path.substr(queryPos + 1);
+            }
+            auto params = parseQuery(queryString);
+            
+            std::vector<double> quantiles;
+            std::stringstream list(urlDecode(params["q"]));
+            std::string item;
+            while (std::getline(list, item, ',')) {
+                try {
+                    double q = std::stod(item);
+                    if (q >= 0 && q <= 1) quantiles.push_back(q);
+                } catch (...) {}
+            }
+            if (quantiles.empty()) quantiles = {0.25, 0.5, 0.75, 0.9, 0.99};
+            
+            CLVDistribution distribution = calculator->getDistribution(quantiles);
+            response << "{\n";
+            response << "  \"status\": \"success\",\n";
+            response << "  \"totalCustomers\": " << distribution.totalCustomers << ",\n";
+            response << "  \"percentiles\": [";
+            for (size_t i = 0; i < distribution.percentiles.size(); i++) {
+                response << (i > 0 ? ",\n" : "\n");
+                response << "    {\"quantile\": " << distribution.percentiles[i].first
+                         << ", \"clv\": " << distribution.percentiles[i].second << "}";
+            }
+            response << "\n  ],\n";
+            response << "  \"histogram\": [";
+            for (size_t i = 0; i < distribution.histogram.size(); i++) {
+                const LogHistogram::Bucket& bucket = distribution.histogram[i];
+                response << (i > 0 ? ",\n" : "\n");
+                response << "    {\"lower\": ";
+                if (std::isinf(bucket.lower)) response << "null"; else response << bucket.lower;
+                response << ", \"upper\": ";
+                if (std::isinf(bucket.upper)) response << "null"; else response << bucket.upper;
+                response << ", \"count\": " << bucket.count << "}";
+            }
+            response << "\n  ],\n";
+            response << "  \"sketchItems\": " << distribution.sketchItems << "\n";
+            response << "}";
+            
+        } else if ((path == "/api/analytics" || path.find("/api/analytics?") == 0) && method == "GET") {
+            // Incrementally maintained analytics, O(1) (the file is only re-read via /api/admin/reload).
+            // Another ?model= than the active one costs one parallel pass over the table.
+            auto params = parseQuery(queryOf(path));
+            CLVModel model;
+            std::string error;
+            if (!parseModelQuery(params, model, error)) {
+                return errorResponse(error);
+            }
+            CLVAnalytics analytics = calculator->getAnalytics(model);
+            
+            response << "{\n";
+            response << "  \"status\": \"success\",\n";
+            response << "  \"model\": \"" << model.name() << "\",\n";
             response << "  \"analytics\": {\n";
-            response << "    \"totalCustomers\": " << calculator->getCustomerCount() << ",\n";
+            response << "    \"totalCustomers\": " << analytics.totalCustomers << ",\n";
+            response << "    \"totalCLV\": " << analytics.totalCLV << ",\n";
+            response << "    \"averageCLV\": " << analytics.averageCLV << ",\n";
+            response << "    \"highestCLV\": " << analytics.highestCLV << ",\n";
+            response << "    \"lowestCLV\": " << analytics.lowestCLV << ",\n";
+            response << "    \"varianceCLV\": " << analytics.varianceCLV << ",\n";
+            response << "    \"standardDeviationCLV\": " << analytics.standardDeviationCLV << ",\n";
+            response << "    \"version\": " << calculator->getDataVersion() << ",\n";
             response << "    \"message\": \"Analytics data retrieved\"\n";
             response << "  }\n";
             response << "}";
             
+        } else if (path == "/api/admin/export" && method == "POST") {
+            // Write the current data to customers.json (the server itself persists to customers.bin)
+            if (calculator->saveToJSON("customers.json")) {
+                response << "{\n";
+                response << "  \"status\": \"success\",\n";
+                response << "  \"message\": \"Customers exported to customers.json\",\n";
+                response << "  \"totalCustomers\": " << calculator->getCustomerCount() << "\n";
+                response << "}";
+            } else {
+                response << errorResponse("Could not write customers.json");
+            }
+            
+        } else if (path.find("/api/admin/recompute") == 0 && method == "POST") {
+            // Switch the stored CLVs to another model (?model=&margin=&discount=) and recompute them all
+            auto params = parseQuery(queryOf(path));
+            CLVModel model;
+            std::string error;
+            if (!parseModelQuery(params, model, error)) {
+                return errorResponse(error);
+            }
+            if (!calculator->recomputeAll(model)) {
+                return errorResponse("Could not record the model switch in the journal");
+            }
+            persistChanges();
+            
+            response << "{\n";
+            response << "  \"status\": \"success\",\n";
+            response << "  \"message\": \"CLV recomputed with the " << model.name() << " model\",\n";
+            response << "  \"model\": \"" << model.name() << "\",\n";
+            response << "  \"margin\": " << model.params.margin << ",\n";
+            response << "  \"discount\": " << model.params.discountRate << ",\n";
+            response << "  \"totalCustomers\": " << calculator->getCustomerCount() << "\n";
+            response << "}";
+            
+        } else if (path == "/api/admin/reload" && method == "POST") {
+            // Re-read the data snapshot from disk, replacing the in-memory data
+            bool found = calculator->reloadSnapshot();
+            
+            response << "{\n";
+            response << "  \"status\": \"success\",\n";
+            response << "  \"message\": \"" << (found ? "Customers reloaded from disk" : "No data file found - starting fresh") << "\",\n";
+            response << "  \"totalCustomers\": " << calculator->getCustomerCount() << "\n";
+            response << "}";
+            
         } else if (path == "/api/log-auth" && method == "POST") {
             // Log authentication event
             bool success = authLogger->logAuthEventFromJson(body);
@@ -340,43 +1122,24 @@ private:
         return response.str();
     }
     
-    void handleClient(int client_socket) {
-        char buffer[4096] = {0};
-        read(client_socket, buffer, 4096);
-        
-        std::string request(buffer);
-        std::stringstream ss(request);
-        std::string line;
-        std::getline(ss, line);
-        
-        std::stringstream requestLine(line);
-        std::string method, path, version;
-        requestLine >> method >> path >> version;
+    // Build the full HTTP response for one parsed request
+    std::string handleRequest(const HttpRequestParser& request, bool keepAlive) {
+        std::string method(request.method());
+        std::string path(request.target());
         
         std::string response;
         
         // Handle OPTIONS request for CORS
         if (method == "OPTIONS") {
-            response = createResponse(200, "text/plain", "");
+            response = createResponse(200, "text/plain", "", keepAlive);
         }
         // Handle API requests
         else if (path.find("/api/") == 0) {
-            std::string body;
-            std::string headerLine;
-            bool inBody = false;
-            
-            while (std::getline(ss, headerLine)) {
-                if (headerLine == "\r" || headerLine.empty()) {
-                    inBody = true;
-                    continue;
-                }
-                if (inBody) {
-                    body += headerLine;
-                }
-            }
+            std::string body(request.body());
             
-            std::string apiResponse = handleAPIRequest(method, path, body);
-            response = createResponse(200, "application/json", apiResponse);
+            int status = 200;
+            std::string apiResponse = handleAPIRequest(method, path, body, status);
+            response = createResponse(status, "application/json", apiResponse, keepAlive);
         }
         // Serve static files
         else {
@@ -389,30 +1152,344 @@ private:
             
             std::string content = readFile(filePath);
             if (!content.empty()) {
-                response = createResponse(200, getContentType(filePath), content);
+                response = createResponse(200, getContentType(filePath), content, keepAlive);
             } else {
-                response = createResponse(404, "text/html", "<h1>404 Not Found</h1>");
+                response = createResponse(404, "text/html", "<h1>404 Not Found</h1>", keepAlive);
+            }
+        }
+        
+        return response;
+    }
+    
+    // Answer every complete request buffered on the connection, in order (pipelining)
+    void processBufferedRequests(const std::shared_ptr<Connection>& conn) {
+        while (!conn->closeAfterWrite) {
+            HttpRequestParser::Result result = conn->parser.parse(conn->input, conn->inputStart);
+            if (result == HttpRequestParser::INCOMPLETE) break;
+            
+            if (result == HttpRequestParser::ERROR) {
+                conn->output += createResponse(conn->parser.error(), "application/json",
+                    "{\n  \"status\": \"error\",\n  \"message\": \"Malformed or oversized request\"\n}");
+                conn->closeAfterWrite = true;
+                break;
+            }
+            
+            conn->requestsServed++;
+            bool keepAlive = conn->parser.keepAlive() && conn->requestsServed < maxRequestsPerConnection;
+            conn->output += handleRequest(conn->parser, keepAlive);
+            conn->inputStart += conn->parser.requestLength();
+            conn->parser.reset();
+            if (!keepAlive) conn->closeAfterWrite = true;
+        }
+        
+        // Reuse the receive buffer: drop consumed requests, keep any partial one
+        if (conn->inputStart == conn->input.size()) {
+            conn->input.clear();
+            conn->inputStart = 0;
+        } else if (conn->inputStart > 0) {
+            conn->input.erase(0, conn->inputStart);
+            conn->inputStart = 0;
+        }
+    }
+    
+    // Re-enable a one-shot connection in epoll for the next read or write
+    void rearmConnection(const std::shared_ptr<Connection>& conn, bool wantWrite) {
+        struct epoll_event ev;
+        ev.events = (wantWrite ? EPOLLOUT : EPOLLIN) | EPOLLET | EPOLLONESHOT | EPOLLRDHUP;
+        ev.data.fd = conn->fd;
+        if (epoll_ctl(epoll_fd, EPOLL_CTL_MOD, conn->fd, &ev) < 0) {
+            closeConnection(conn);
+        }
+    }
+    
+    void closeConnection(const std::shared_ptr<Connection>& conn) {
+        {
+            std::lock_guard<std::mutex> lock(connectionsMutex);
+            auto it = connections.find(conn->fd);
+            if (it == connections.end() || it->second != conn) return;
+            connections.erase(it);
+        }
+        epoll_ctl(epoll_fd, EPOLL_CTL_DEL, conn->fd, nullptr);
+        close(conn->fd);
+    }
+    
+    // Write as much pending output as the socket accepts. Returns true when everything was sent.
+    bool flushOutput(const std::shared_ptr<Connection>& conn) {
+        while (conn->outputOffset < conn->output.size()) {
+            ssize_t sent = send(conn->fd, conn->output.data() + conn->outputOffset,
+                                conn->output.size() - conn->outputOffset, MSG_NOSIGNAL);
+            if (sent > 0) {
+                conn->outputOffset += sent;
+            } else if (sent < 0 && errno == EINTR) {
+                continue;
+            } else if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                return false;
+            } else {
+                conn->broken = true;
+                return false;
+            }
+        }
+        conn->output.clear();
+        conn->outputOffset = 0;
+        return true;
+    }
+    
+    // Runs on a worker thread. EPOLLONESHOT guarantees only one worker owns a connection at a time.
+    void serviceConnection(const std::shared_ptr<Connection>& conn) {
+        std::lock_guard<std::mutex> guard(conn->lock);
+        conn->lastActivity = std::chrono::steady_clock::now();
+        
+        // Finish responses that previously hit a full socket buffer
+        if (!conn->output.empty()) {
+            if (!flushOutput(conn)) {
+                finishService(conn, conn->broken ? CLOSE : WAIT_WRITE);
+                return;
+            }
+            if (conn->closeAfterWrite) {
+                finishService(conn, CLOSE);
+                return;
+            }
+        }
+        
+        // Edge-triggered: drain the socket until it would block
+        char buffer[16384];
+        bool peerClosed = false;
+        while (true) {
+            ssize_t received = recv(conn->fd, buffer, sizeof(buffer), 0);
+            if (received > 0) {
+                conn->input.append(buffer, received);
+            } else if (received == 0) {
+                peerClosed = true;
+                break;
+            } else if (errno == EINTR) {
+                continue;
+            } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                break;
+            } else {
+                finishService(conn, CLOSE);
+                return;
+            }
+        }
+        
+        processBufferedRequests(conn);
+        if (peerClosed) {
+            conn->closeAfterWrite = true;
+        }
+        
+        if (!flushOutput(conn)) {
+            finishService(conn, conn->broken ? CLOSE : WAIT_WRITE);
+        } else if (conn->closeAfterWrite) {
+            finishService(conn, CLOSE);
+        } else {
+            finishService(conn, WAIT_READ);
+        }
+    }
+    
+    enum ServiceOutcome { WAIT_READ, WAIT_WRITE, CLOSE };
+    
+    // Hand the connection back to the event loop (caller holds conn->lock)
+    void finishService(const std::shared_ptr<Connection>& conn, ServiceOutcome outcome) {
+        conn->busy = false;
+        if (outcome == CLOSE) {
+            closeConnection(conn);
+        } else {
+            rearmConnection(conn, outcome == WAIT_WRITE);
+        }
+    }
+    
+    // Close keep-alive connections that have sat idle past the timeout (event loop thread)
+    void closeIdleConnections() {
+        auto now = std::chrono::steady_clock::now();
+        std::vector<std::shared_ptr<Connection>> candidates;
+        {
+            std::lock_guard<std::mutex> lock(connectionsMutex);
+            for (auto& entry : connections) {
+                candidates.push_back(entry.second);
             }
         }
         
-        send(client_socket, response.c_str(), response.length(), 0);
-        close(client_socket);
+        for (auto& conn : candidates) {
+            std::unique_lock<std::mutex> guard(conn->lock, std::try_to_lock);
+            if (!guard.owns_lock() || conn->busy) continue;
+            if (now - conn->lastActivity >= std::chrono::seconds(keepAliveTimeout)) {
+                closeConnection(conn);
+            }
+        }
+    }
+    
+    // Accept every pending connection (the listening socket is edge-triggered)
+    void acceptConnections() {
+        while (true) {
+            struct sockaddr_in client_addr;
+            socklen_t client_len = sizeof(client_addr);
+            
+            int client_socket = accept4(server_fd, (struct sockaddr*)&client_addr, &client_len,
+                                        SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (client_socket < 0) {
+                if (errno == EINTR) continue;
+                if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                    std::cerr << "Accept failed: " << std::strerror(errno) << std::endl;
+                }
+                return;
+            }
+            
+            auto conn = std::make_shared<Connection>(client_socket);
+            {
+                std::lock_guard<std::mutex> lock(connectionsMutex);
+                connections[client_socket] = conn;
+            }
+            
+            struct epoll_event ev;
+            ev.events = EPOLLIN | EPOLLET | EPOLLONESHOT | EPOLLRDHUP;
+            ev.data.fd = client_socket;
+            if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, client_socket, &ev) < 0) {
+                std::cerr << "epoll_ctl failed: " << std::strerror(errno) << std::endl;
+                closeConnection(conn);
+            }
+        }
+    }
+    
+    // Mutations are already in the journal; without one, rewrite the snapshot that
+    // startup loads (customers.bin) in the background
+    void persistChanges() {
+        if (!calculator->isJournaling()) {
+            calculator->saveSnapshotAsync();
+        }
+    }
+    
+    static CustomerJournal::SyncMode readJournalSyncMode() {
+        const char* value = std::getenv("JOURNAL_SYNC");
+        if (!value || std::strlen(value) == 0 || std::strcmp(value, "group") == 0) return CustomerJournal::SYNC_GROUP;
+        if (std::strcmp(value, "always") == 0) return CustomerJournal::SYNC_ALWAYS;
+        if (std::strcmp(value, "none") == 0) return CustomerJournal::SYNC_NONE;
+        std::cerr << "⚠️  Invalid JOURNAL_SYNC env var (none|group|always), using group" << std::endl;
+        return CustomerJournal::SYNC_GROUP;
+    }
+    
+    static bool modelSetInEnv() {
+        for (const char* name : {"CLV_MODEL", "CLV_MARGIN", "CLV_DISCOUNT"}) {
+            const char* value = std::getenv(name);
+            if (value && std::strlen(value) > 0) return true;
+        }
+        return false;
+    }
+    
+    // Startup CLV model from CLV_MODEL, CLV_MARGIN and CLV_DISCOUNT (default: simple)
+    static CLVModel readModelFromEnv() {
+        CLVModel model;
+        const char* kind = std::getenv("CLV_MODEL");
+        if (kind && std::strlen(kind) > 0 && !CLVModel::parseKind(kind, model.kind)) {
+            std::cerr << "⚠️  Invalid CLV_MODEL env var (simple|margin|discounted|retention), using simple" << std::endl;
+        }
+        try {
+            const char* margin = std::getenv("CLV_MARGIN");
+            const char* discount = std::getenv("CLV_DISCOUNT");
+            if (margin && std::strlen(margin) > 0) model.params.margin = std::stod(margin);
+            if (discount && std::strlen(discount) > 0) model.params.discountRate = std::stod(discount);
+        } catch (...) {
+            model.params = CLVModelParams();
+        }
+        std::string error = model.validate();
+        if (!error.empty()) {
+            std::cerr << "⚠️  Invalid CLV model settings (" << error << "), using defaults" << std::endl;
+            model.params = CLVModelParams();
+        }
+        return model;
+    }
+    
+    void startDataWatcher() {
+        std::string snapshot = calculator->getSnapshotPath();
+        size_t slash = snapshot.rfind('/');
+        std::string directory = slash == std::string::npos ? "." : snapshot.substr(0, slash + 1);
+        
+        inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (inotify_fd < 0 || inotify_add_watch(inotify_fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+            std::cerr << "⚠️  Could not watch " << snapshot << ": " << std::strerror(errno) << std::endl;
+            if (inotify_fd >= 0) close(inotify_fd);
+            inotify_fd = -1;
+            return;
+        }
+        
+        struct epoll_event ev;
+        ev.events = EPOLLIN;
+        ev.data.fd = inotify_fd;
+        epoll_ctl(epoll_fd, EPOLL_CTL_ADD, inotify_fd, &ev);
+        std::cout << "👀 Watching " << snapshot << " for changes" << std::endl;
+    }
+    
+    void readDataWatcherEvents() {
+        std::string snapshot = calculator->getSnapshotPath();
+        std::string fileName = snapshot.substr(snapshot.rfind('/') + 1);
+        alignas(struct inotify_event) char buffer[4096];
+        ssize_t got;
+        while ((got = read(inotify_fd, buffer, sizeof(buffer))) > 0) {
+            for (char* p = buffer; p < buffer + got; ) {
+                struct inotify_event* event = reinterpret_cast<struct inotify_event*>(p);
+                if (event->len > 0 && fileName == event->name) {
+                    dataFileChanged = true;
+                    dataFileChangedAt = std::chrono::steady_clock::now();
+                }
+                p += sizeof(struct inotify_event) + event->len;
+            }
+        }
+    }
+    
+    // Reload once the file has been quiet for a moment; our own saves are recognized and skipped
+    void reloadChangedDataFile() {
+        if (!dataFileChanged || std::chrono::steady_clock::now() - dataFileChangedAt < std::chrono::milliseconds(250)) {
+            return;
+        }
+        dataFileChanged = false;
+        workerPool->submit([this] {
+            if (calculator->reloadIfChanged()) {
+                std::cout << "🔄 " << calculator->getSnapshotPath() << " changed on disk - reloaded "
+                          << calculator->getCustomerCount() << " customers" << std::endl;
+            }
+        });
+    }
+    
+    static int readEnvInt(const char* name, int fallback) {
+        const char* value = std::getenv(name);
+        if (!value || std::strlen(value) == 0) return fallback;
+        try {
+            int parsed = std::stoi(value);
+            return parsed > 0 ? parsed : fallback;
+        } catch (...) {
+            std::cerr << "⚠️  Invalid " << name << " env var, using " << fallback << std::endl;
+            return fallback;
+        }
     }
     
 public:
     HTTPServer(int p = 8080) 
         : server_fd(0),
+          epoll_fd(-1),
           port(p), 
+          listenBacklog(SOMAXCONN),
+          keepAliveTimeout(5),
+          maxRequestsPerConnection(100),
+          workerPool(nullptr),
           calculator(new CLVCalculator()),
           mongoService(nullptr),
           authLogger(nullptr),
-          allowedOrigins("*") {
+          allowedOrigins("*"),
+          inotify_fd(-1),
+          dataFileChanged(false) {
         // Read environment variables (with safe fallbacks)
         const char* origins_env = std::getenv("ALLOWED_ORIGINS");
         if (origins_env && std::strlen(origins_env) > 0) {
             allowedOrigins = origins_env;
         }
 
+        // Listen backlog and worker pool sizing (defaults: SOMAXCONN, one worker per core)
+        listenBacklog = readEnvInt("LISTEN_BACKLOG", SOMAXCONN);
+        int cores = static_cast<int>(std::thread::hardware_concurrency());
+        int workers = readEnvInt("WORKER_THREADS", cores > 0 ? cores : 4);
+        int queueSize = readEnvInt("WORKER_QUEUE_SIZE", workers * 64);
+        workerPool = new WorkerPool(workers, queueSize);
+        keepAliveTimeout = readEnvInt("KEEPALIVE_TIMEOUT", 5);
+        maxRequestsPerConnection = readEnvInt("MAX_KEEPALIVE_REQUESTS", 100);
+
         const char* uri_env = std::getenv("MONGODB_URI");
         const char* db_env  = std::getenv("MONGODB_DB_NAME");
 
@@ -427,11 +1504,48 @@ public:
         mongoService = new MongoDBService(mongoUri, dbName);
         authLogger = new MongoDBAuthLogger(*mongoService, "auth_events");
 
-        calculator->loadFromJSON(); // Load existing data
+        calculator->enableLeaderboard(readEnvInt("LEADERBOARD_SIZE", 10));
+        // Data lives in a binary snapshot; convert an existing customers.json on first start
+        if (statFile("customers.bin").inode == 0 && statFile("customers.json").inode != 0) {
+            calculator->loadFromJSON("customers.json");
+            if (calculator->saveToBinary("customers.bin")) {
+                std::cout << "📦 Converted customers.json to customers.bin" << std::endl;
+            }
+        }
+        
+        // Load the snapshot and replay the mutation journal written since
+        // (JOURNAL_COMPACT_MB sets how large it may grow before compaction)
+        uint64_t compactBytes = static_cast<uint64_t>(readEnvInt("JOURNAL_COMPACT_MB", 64)) << 20;
+        if (!calculator->openWithJournal("customers.bin", "customers.journal", readJournalSyncMode(), compactBytes)) {
+            std::cerr << "⚠️  Journal unavailable - falling back to full snapshot saves" << std::endl;
+        }
+        // Recovery restored the model last switched to (snapshot header + journal);
+        // CLV_MODEL, CLV_MARGIN and CLV_DISCOUNT override it when set
+        if (modelSetInEnv()) {
+            CLVModel model = readModelFromEnv();
+            if (model != calculator->getModel()) {
+                calculator->recomputeAll(model);
+                persistChanges();
+            }
+        }
         std::cout << "✅ Server initialized with MongoDB storage (DB: " << dbName << ")" << std::endl;
     }
     
     ~HTTPServer() {
+        delete workerPool;
+        {
+            std::lock_guard<std::mutex> lock(connectionsMutex);
+            for (auto& entry : connections) {
+                close(entry.first);
+            }
+            connections.clear();
+        }
+        if (inotify_fd >= 0) {
+            close(inotify_fd);
+        }
+        if (epoll_fd >= 0) {
+            close(epoll_fd);
+        }
         delete calculator;
         delete authLogger;
         delete mongoService;
@@ -442,8 +1556,8 @@ public:
     
     bool start() {
         // Create socket
-        server_fd = socket(AF_INET, SOCK_STREAM, 0);
-        if (server_fd == 0) {
+        server_fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (server_fd < 0) {
             std::cerr << "Socket creation failed" << std::endl;
             return false;
         }
@@ -467,14 +1581,34 @@ public:
         }
         
         // Listen
-        if (listen(server_fd, 10) < 0) {
+        if (listen(server_fd, listenBacklog) < 0) {
             std::cerr << "Listen failed" << std::endl;
             return false;
         }
         
+        // Event loop
+        epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+        if (epoll_fd < 0) {
+            std::cerr << "epoll_create1 failed" << std::endl;
+            return false;
+        }
+        
+        struct epoll_event ev;
+        ev.events = EPOLLIN | EPOLLET;
+        ev.data.fd = server_fd;
+        if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, server_fd, &ev) < 0) {
+            std::cerr << "epoll_ctl failed for listening socket" << std::endl;
+            return false;
+        }
+        
+        if (readEnvInt("WATCH_DATA_FILE", 0)) {
+            startDataWatcher();
+        }
+        
         std::cout << "🚀 CLV Server running on http://localhost:" << port << std::endl;
         std::cout << "📊 Backend API available at http://localhost:" << port << "/api/" << std::endl;
         std::cout << "🌐 Frontend available at http://localhost:" << port << "/" << std::endl;
+        std::cout << "⚙️  " << workerPool->threadCount() << " worker threads, listen backlog " << listenBacklog << std::endl;
         std::cout << "Press Ctrl+C to stop the server" << std::endl;
         
         return true;
@@ -483,19 +1617,50 @@ public:
     void run() {
         if (!start()) return;
         
+        const int MAX_EVENTS = 256;
+        struct epoll_event events[MAX_EVENTS];
+        auto lastSweep = std::chrono::steady_clock::now();
+        
         while (true) {
-            struct sockaddr_in client_addr;
-            socklen_t client_len = sizeof(client_addr);
+            int ready = epoll_wait(epoll_fd, events, MAX_EVENTS, dataFileChanged ? 100 : 1000);
+            if (ready < 0) {
+                if (errno == EINTR) continue;
+                std::cerr << "epoll_wait failed: " << std::strerror(errno) << std::endl;
+                return;
+            }
             
-            int client_socket = accept(server_fd, (struct sockaddr*)&client_addr, &client_len);
-            if (client_socket < 0) {
-                std::cerr << "Accept failed" << std::endl;
-                continue;
+            for (int i = 0; i < ready; i++) {
+                int fd = events[i].data.fd;
+                if (fd == server_fd) {
+                    acceptConnections();
+                    continue;
+                }
+                if (fd == inotify_fd) {
+                    readDataWatcherEvents();
+                    continue;
+                }
+                
+                std::shared_ptr<Connection> conn;
+                {
+                    std::lock_guard<std::mutex> lock(connectionsMutex);
+                    auto it = connections.find(fd);
+                    if (it == connections.end()) continue;
+                    conn = it->second;
+                }
+                
+                // Blocks while the worker queue is full, which stops us accepting
+                // and lets the kernel listen backlog absorb the burst
+                conn->busy = true;
+                workerPool->submit([this, conn] { serviceConnection(conn); });
             }
             
-            // Handle client in a separate thread
-            std::thread clientThread(&HTTPServer::handleClient, this, client_socket);
-            clientThread.detach();
+            reloadChangedDataFile();
+            
+            auto now = std::chrono::steady_clock::now();
+            if (now - lastSweep >= std::chrono::seconds(1)) {
+                closeIdleConnections();
+                lastSweep = now;
+            }
         }
     }
 };
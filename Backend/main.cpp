@@ -1,12 +1,22 @@
 #include "clv_calculator.hpp"
+#include "clv_cli.hpp"
 #include <iostream>
 
 using namespace std;
 
-int main() {
+int main(int argc, char* argv[]) {
+    // Batch subcommands (import, top, stats, export) run without prompts
+    if (argc >= 2 && isCLICommand(argv[1])) {
+        return runCLI(argc, argv);
+    }
+    if (argc >= 2) {
+        cerr << CLI_USAGE;
+        return string(argv[1]) == "--help" || string(argv[1]) == "help" ? 0 : 2;
+    }
+
     cout << "🎯 Customer Lifetime Value (CLV) Calculator" << endl;
     cout << "📊 Simple Algorithm: CLV = AOV × Frequency × Lifespan" << endl;
-    cout << "🚀 DSA Features: Vectors, Structs, Quicksort, File I/O" << endl;
+    cout << "🚀 DSA Features: Vectors, Structs, Top-K Heap, File I/O" << endl;
     cout << endl;
 
     CLVCalculator calculator;
@@ -0,0 +1,216 @@
+#ifndef TASK_POOL_HPP
+#define TASK_POOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdlib>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Work-stealing pool for data-parallel loops over the customer table.
+//
+// Every worker owns a deque: it pushes and pops its own tasks at the back
+// (newest first, cache-warm) and, when that runs dry, steals the oldest task
+// from the front of another worker's deque. A pool of parallelism P starts P-1
+// threads; the thread calling parallelFor works too, and runs queued tasks
+// while it waits, so loops can nest without deadlocking.
+//
+// parallelFor and parallelReduce split [0, count) into chunks of a fixed grain,
+// so the chunk boundaries - and parallelReduce's combine order, which is by
+// chunk - depend only on count and grain. Results are therefore identical for
+// any thread count, including floating-point sums.
+class TaskPool {
+public:
+    static const size_t DEFAULT_GRAIN = 1 << 16;
+
+private:
+    struct WorkerQueue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    // Shared by one loop's helper tasks; outlives the loop if a helper starts late
+    struct LoopState {
+        size_t count;
+        size_t grain;
+        size_t chunks;
+        const std::function<void(size_t, size_t)>* body;
+        std::atomic<size_t> nextChunk{0};
+        std::atomic<size_t> doneChunks{0};
+        std::mutex errorMutex;
+        std::exception_ptr error;
+    };
+
+    std::vector<std::unique_ptr<WorkerQueue>> queues;
+    std::vector<std::thread> threads;
+    std::atomic<size_t> queuedTasks{0};
+    std::atomic<size_t> nextQueue{0};
+    std::mutex sleepMutex;
+    std::condition_variable wake;
+    bool stopping = false;
+
+    // Queue index of the calling thread if it is one of this pool's workers
+    size_t currentQueue() const {
+        return workerPool == this ? workerIndex : queues.size();
+    }
+
+    static inline thread_local const TaskPool* workerPool = nullptr;
+    static inline thread_local size_t workerIndex = 0;
+
+    void push(std::function<void()> task) {
+        size_t index = currentQueue();
+        if (index == queues.size()) index = nextQueue++ % queues.size();
+        {
+            std::lock_guard<std::mutex> lock(queues[index]->mutex);
+            queues[index]->tasks.push_back(std::move(task));
+        }
+        queuedTasks++;
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex);
+        }
+        wake.notify_one();
+    }
+
+    // Run one queued task: own deque from the back, else steal from the front of another
+    bool runOne() {
+        size_t self = currentQueue();
+        std::function<void()> task;
+        if (self < queues.size()) {
+            std::lock_guard<std::mutex> lock(queues[self]->mutex);
+            if (!queues[self]->tasks.empty()) {
+                task = std::move(queues[self]->tasks.back());
+                queues[self]->tasks.pop_back();
+            }
+        }
+        for (size_t i = 1; !task && i <= queues.size(); i++) {
+            WorkerQueue& victim = *queues[(self + i) % queues.size()];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (!victim.tasks.empty()) {
+                task = std::move(victim.tasks.front());
+                victim.tasks.pop_front();
+            }
+        }
+        if (!task) return false;
+        queuedTasks--;
+        task();
+        return true;
+    }
+
+    void workerLoop(size_t index) {
+        workerPool = this;
+        workerIndex = index;
+        while (true) {
+            if (runOne()) continue;
+            std::unique_lock<std::mutex> lock(sleepMutex);
+            wake.wait(lock, [this] { return stopping || queuedTasks > 0; });
+            if (stopping && queuedTasks == 0) return;
+        }
+    }
+
+    static void runChunks(LoopState& state) {
+        size_t chunk;
+        while ((chunk = state.nextChunk++) < state.chunks) {
+            size_t begin = chunk * state.grain;
+            size_t end = begin + state.grain < state.count ? begin + state.grain : state.count;
+            try {
+                (*state.body)(begin, end);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(state.errorMutex);
+                if (!state.error) state.error = std::current_exception();
+            }
+            state.doneChunks++;
+        }
+    }
+
+public:
+    // parallelism = threads working on a loop, counting the caller (1 = run inline)
+    explicit TaskPool(size_t parallelism) {
+        if (parallelism == 0) parallelism = 1;
+        for (size_t i = 0; i + 1 < parallelism; i++) {
+            queues.emplace_back(new WorkerQueue());
+        }
+        for (size_t i = 0; i + 1 < parallelism; i++) {
+            threads.emplace_back(&TaskPool::workerLoop, this, i);
+        }
+    }
+
+    ~TaskPool() {
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto& thread : threads) {
+            thread.join();
+        }
+    }
+
+    TaskPool(const TaskPool&) = delete;
+    TaskPool& operator=(const TaskPool&) = delete;
+
+    size_t parallelism() const { return threads.size() + 1; }
+
+    // Hardware threads, or CLV_THREADS if set
+    static size_t defaultParallelism() {
+        const char* configured = std::getenv("CLV_THREADS");
+        if (configured && std::atoi(configured) > 0) return std::atoi(configured);
+        unsigned int cores = std::thread::hardware_concurrency();
+        return cores > 0 ? cores : 1;
+    }
+
+    // Process-wide pool used by CLVCalculator unless it is given another one
+    static TaskPool& shared() {
+        static TaskPool pool(defaultParallelism());
+        return pool;
+    }
+
+    // Call body(begin, end) for consecutive grain-sized chunks of [0, count).
+    // Returns when every chunk is done; rethrows the first exception a chunk threw.
+    void parallelFor(size_t count, size_t grain, const std::function<void(size_t, size_t)>& body) {
+        if (count == 0) return;
+        if (grain == 0) grain = 1;
+        auto state = std::make_shared<LoopState>();
+        state->count = count;
+        state->grain = grain;
+        state->chunks = (count + grain - 1) / grain;
+        state->body = &body;
+
+        size_t helpers = state->chunks - 1 < threads.size() ? state->chunks - 1 : threads.size();
+        for (size_t i = 0; i < helpers; i++) {
+            push([state] { runChunks(*state); });
+        }
+        runChunks(*state);
+        // Chunks claimed by other threads may still be running; help with queued work meanwhile
+        while (state->doneChunks < state->chunks) {
+            if (!runOne()) std::this_thread::yield();
+        }
+        if (state->error) std::rethrow_exception(state->error);
+    }
+
+    void parallelFor(size_t count, const std::function<void(size_t, size_t)>& body) {
+        parallelFor(count, DEFAULT_GRAIN, body);
+    }
+
+    // map(begin, end) -> T over grain-sized chunks, folded in chunk order with
+    // combine(T accumulated, T chunkResult) -> T starting from identity
+    template<typename T, typename Map, typename Combine>
+    T parallelReduce(size_t count, size_t grain, T identity, Map map, Combine combine) {
+        if (grain == 0) grain = 1;
+        std::vector<T> partials((count + grain - 1) / grain, identity);
+        parallelFor(count, grain, [&](size_t begin, size_t end) {
+            partials[begin / grain] = map(begin, end);
+        });
+        T result = identity;
+        for (auto& partial : partials) {
+            result = combine(std::move(result), std::move(partial));
+        }
+        return result;
+    }
+};
+
+#endif // TASK_POOL_HPP
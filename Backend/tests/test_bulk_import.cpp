@@ -0,0 +1,163 @@
+// Bulk CSV/NDJSON import: quoting, rejected rows and chunk boundaries
+#include "clv_calculator.hpp"
+#include "bulk_import.hpp"
+#include "test_support.hpp"
+
+static ImportBatch parse(const std::string& text, ImportFormat format, TaskPool& pool = TaskPool::shared()) {
+    return parseCustomersBulk(text.data(), text.size(), format, pool);
+}
+
+static void csvQuotedFieldsAreUnescaped() {
+    std::string csv =
+        "\xEF\xBB\xBF" "Lifespan,AOV,name,id,frequency,extra\r\n"
+        "3,100,\"Smith, Jane\",C1,2,x\r\n"
+        "  1.5 , 20 , \"Say \"\"hi\"\"\" , \"C2\" , 4 ,\r\n"
+        "\n"
+        "2,+5,\"\",C3,1,\n";
+    ImportBatch batch = parse(csv, ImportFormat::CSV);
+    CHECK(batch.errors.empty());
+    CHECK(batch.rows.size() == 3);
+    if (batch.rows.size() != 3) return;
+    CHECK(batch.rows[0].record.id == "C1" && batch.rows[0].record.name == "Smith, Jane");
+    CHECK(batch.rows[0].record.averagePurchaseValue == 100 && batch.rows[0].record.customerLifespan == 3);
+    CHECK(batch.rows[1].record.id == "C2" && batch.rows[1].record.name == "Say \"hi\"");
+    CHECK(batch.rows[1].record.purchaseFrequency == 4 && batch.rows[1].record.customerLifespan == 1.5);
+    CHECK(batch.rows[2].record.name.empty() && batch.rows[2].record.averagePurchaseValue == 5);
+    CHECK(batch.rows[0].line == 2 && batch.rows[1].line == 3 && batch.rows[2].line == 5);
+}
+
+static void malformedRowsAreRejectedWithTheirLine() {
+    std::string csv =
+        "id,name,aov,frequency,lifespan\n"
+        "A,Ok,10,1,1\n"
+        "B,\"unterminated,10,1,1\n"
+        "C,Short,10\n"
+        "D,NaN-ish,ten,1,1\n"
+        "E,\"Quoted\"tail,10,1,1\n"
+        "F,Ok,20,2,2\n";
+    ImportBatch batch = parse(csv, ImportFormat::CSV);
+    CHECK(batch.rows.size() == 2);
+    CHECK(batch.errors.size() == 4);
+    if (batch.errors.size() != 4) return;
+    CHECK(batch.errors[0].line == 3 && batch.errors[0].message == "unterminated quoted field");
+    CHECK(batch.errors[1].line == 4 && batch.errors[1].message == "expected 5 fields, found 3");
+    CHECK(batch.errors[2].line == 5 && batch.errors[2].message == "metric fields must be numbers");
+    CHECK(batch.errors[3].line == 6);
+
+    ImportBatch headerless = parse("id,name\nA,B\n", ImportFormat::CSV);
+    CHECK(headerless.rows.empty() && headerless.errors.size() == 1 && headerless.errors[0].line == 1);
+}
+
+static void recordsStraddlingChunkBoundaries() {
+    // Well over 1 MB, with line lengths chosen so chunk cuts land mid-record
+    std::string csv = "id,name,aov,frequency,lifespan\n";
+    size_t count = 0;
+    while (csv.size() < (3u << 20)) {
+        csv += "C" + std::to_string(count) + ",\"Name, " + std::string(count % 61, 'x') + "\"," +
+               std::to_string(count % 500 + 1) + ",2,3\n";
+        count++;
+    }
+    csv += "last,Last,1,1,1";  // No trailing newline
+
+    TaskPool single(1), several(4);
+    ImportBatch one = parse(csv, ImportFormat::CSV, single);
+    ImportBatch many = parse(csv, ImportFormat::CSV, several);
+    CHECK(one.errors.empty() && many.errors.empty());
+    CHECK(one.rows.size() == count + 1 && many.rows.size() == count + 1);
+    bool same = one.rows.size() == many.rows.size();
+    for (size_t i = 0; same && i < one.rows.size(); i++) {
+        same = one.rows[i].record.id == many.rows[i].record.id && one.rows[i].line == many.rows[i].line &&
+               one.rows[i].line == i + 2;
+    }
+    CHECK(same);
+    CHECK(!many.rows.empty() && many.rows.back().record.id == "last");
+
+    // Batches of the streaming parser cut at the same places and keep file line numbers
+    size_t rows = 0, batches = 0;
+    bool ordered = true;
+    parseCustomersBulkBatches(csv.data(), csv.size(), ImportFormat::CSV, several, 1 << 20, [&](ImportBatch& batch) {
+        for (const ImportRow& row : batch.rows) ordered = ordered && row.line == rows++ + 2;
+        batches++;
+    });
+    CHECK(ordered && rows == count + 1 && batches >= 3);
+}
+
+static void ndjsonRows() {
+    std::string ndjson =
+        "{\"id\":\"N1\",\"name\":\"Caf\\u00e9\",\"averagePurchaseValue\":12.5,\"purchaseFrequency\":2,\"customerLifespan\":1}\n"
+        "\n"
+        "{\"customerLifespan\":3,\"tags\":[1,{\"a\":null}],\"purchaseFrequency\":1,\"averagePurchaseValue\":7,\"name\":\"B\",\"id\":\"N2\"}\r\n"
+        "{\"id\":\"N3\",\"name\":\"C\"}\n"
+        "[1,2]\n"
+        "{\"id\":\"N4\",\"name\":\"D\",\"averagePurchaseValue\":1,\"purchaseFrequency\":1,\"customerLifespan\":1} trailing\n"
+        "{\"id\":\"N5\",\"name\":\"E\",\"averagePurchaseValue\":\"1\",\"purchaseFrequency\":1,\"customerLifespan\":1}\n";
+    CHECK(detectImportFormat(ndjson.data(), ndjson.size()) == ImportFormat::NDJSON);
+    ImportBatch batch = parse(ndjson, ImportFormat::NDJSON);
+    CHECK(batch.rows.size() == 2);
+    CHECK(batch.errors.size() == 4);
+    if (batch.rows.size() != 2 || batch.errors.size() != 4) return;
+    CHECK(batch.rows[0].record.name == "Caf\xC3\xA9" && batch.rows[0].record.averagePurchaseValue == 12.5);
+    CHECK(batch.rows[1].record.id == "N2" && batch.rows[1].line == 3);
+    CHECK(batch.errors[0].line == 4 && batch.errors[0].message == "missing a metric field");
+    CHECK(batch.errors[1].line == 5 && batch.errors[1].message == "expected a customer object");
+    CHECK(batch.errors[2].line == 6 && batch.errors[2].message == "unexpected text after the object");
+    CHECK(batch.errors[3].line == 7 && batch.errors[3].message == "field 'averagePurchaseValue' has the wrong type");
+}
+
+static void deeplyNestedLineIsRejected() {
+    // Used to overflow the stack in JsonReader::skipValue
+    std::string ndjson = "{\"x\":" + std::string(2 << 20, '[') + "\n" +
+                         "{\"id\":\"ok\",\"name\":\"Ok\",\"averagePurchaseValue\":1,\"purchaseFrequency\":1,\"customerLifespan\":1}\n";
+    ImportBatch batch = parse(ndjson, ImportFormat::NDJSON);
+    CHECK(batch.errors.size() == 1);
+    CHECK(!batch.errors.empty() && batch.errors[0].line == 1 &&
+          batch.errors[0].message.find("nesting") != std::string::npos);
+    CHECK(batch.rows.size() == 1 && batch.rows[0].record.id == "ok");
+}
+
+static void invalidAndDuplicateRowsAreRejectedOnAdd() {
+    CLVCalculator calculator;
+    calculator.setVerbose(false);
+    calculator.addCustomer("existing", "Existing", 1, 1, 1);
+    std::vector<CustomerRecord> records(5);
+    records[0] = CustomerRecord{"new", "New", 10, 2, 3};
+    records[1] = CustomerRecord{"existing", "Again", 10, 2, 3};
+    records[2] = CustomerRecord{"new", "Twice", 10, 2, 3};
+    records[3] = CustomerRecord{"bad", "Bad", -1, 2, 3};
+    records[4] = CustomerRecord{"", "No id", 1, 1, 1};
+    std::vector<std::pair<size_t, std::string>> rejected;
+    CHECK(calculator.addCustomersBatch(records, rejected) == 1);
+    CHECK(rejected.size() == 4);
+    for (size_t i = 0; i < rejected.size(); i++) CHECK(rejected[i].first == i + 1 && !rejected[i].second.empty());
+    CHECK(calculator.getCustomerCount() == 2);
+    std::optional<Customer> added = calculator.findCustomer("new");
+    CHECK(added && added->name == "New" && added->clv == 60);
+}
+
+static void singleAddsSayWhyTheyFailed() {
+    CLVCalculator calculator;
+    calculator.setVerbose(false);
+    MutationFailure failure;
+    CHECK(calculator.addCustomer("A", "A", 1, 1, 1, &failure) && failure.reason == MutationFailure::NONE);
+    CHECK(!calculator.addCustomer("A", "Again", 1, 1, 1, &failure));
+    CHECK(failure.reason == MutationFailure::DUPLICATE_ID && failure.message == "Customer ID 'A' already exists");
+    CHECK(!calculator.addCustomer("B", "B", std::numeric_limits<double>::infinity(), 1, 1, &failure));
+    CHECK(failure.reason == MutationFailure::INVALID && failure.message == "values must be positive numbers");
+    CHECK(!calculator.updateCustomer("missing", "M", 1, 1, 1, &failure));
+    CHECK(failure.reason == MutationFailure::NOT_FOUND);
+    CHECK(!calculator.updateCustomer("A", "", 1, 1, 1, &failure));
+    CHECK(failure.reason == MutationFailure::INVALID && failure.message == "empty id or name");
+    CHECK(calculator.getCustomerCount() == 1);
+}
+
+int main() {
+    std::printf("bulk_import\n");
+    RUN_TEST(csvQuotedFieldsAreUnescaped);
+    RUN_TEST(malformedRowsAreRejectedWithTheirLine);
+    RUN_TEST(recordsStraddlingChunkBoundaries);
+    RUN_TEST(ndjsonRows);
+    RUN_TEST(deeplyNestedLineIsRejected);
+    RUN_TEST(invalidAndDuplicateRowsAreRejectedOnAdd);
+    RUN_TEST(singleAddsSayWhyTheyFailed);
+    return testResult();
+}
@@ -0,0 +1,109 @@
+// Incremental request parsing: chunked bodies, pipelining and size limits
+#include "http_parser.hpp"
+#include "test_support.hpp"
+
+// Feed the request one byte at a time, as a slow client would
+static HttpRequestParser::Result parseByteByByte(HttpRequestParser& parser, const std::string& request,
+                                                 std::string& buffer) {
+    HttpRequestParser::Result result = HttpRequestParser::INCOMPLETE;
+    for (char c : request) {
+        buffer += c;
+        result = parser.parse(buffer);
+        if (result != HttpRequestParser::INCOMPLETE) break;
+    }
+    return result;
+}
+
+static void chunkedBodyIsDecodedInPlace() {
+    std::string request =
+        "POST /api/customers/bulk HTTP/1.1\r\n"
+        "Transfer-Encoding: chunked\r\n\r\n"
+        "5\r\nhello\r\n"
+        "7;ext=1\r\n, world\r\n"
+        "0\r\n"
+        "Trailer: ignored\r\n\r\n";
+    HttpRequestParser parser;
+    std::string buffer = request;
+    CHECK(parser.parse(buffer) == HttpRequestParser::COMPLETE);
+    CHECK(parser.body() == "hello, world");
+    CHECK(parser.requestLength() == request.size());
+}
+
+static void chunkedBodyArrivingByteByByte() {
+    std::string request =
+        "POST /x HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n"
+        "3\r\nabc\r\n10\r\n0123456789abcdef\r\n0\r\n\r\n";
+    HttpRequestParser parser;
+    std::string buffer;
+    CHECK(parseByteByByte(parser, request, buffer) == HttpRequestParser::COMPLETE);
+    CHECK(parser.body() == "abc0123456789abcdef");
+    CHECK(parser.requestLength() == request.size());
+}
+
+static void pipelinedRequestsParseOneAfterAnother() {
+    std::string first = "POST /a HTTP/1.1\r\nContent-Length: 3\r\n\r\nabc";
+    std::string second = "POST /b HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n2\r\nxy\r\n0\r\n\r\n";
+    std::string third = "GET /c HTTP/1.1\r\n\r\n";
+    std::string buffer = first + second + third;
+
+    HttpRequestParser parser;
+    size_t start = 0;
+    CHECK(parser.parse(buffer, start) == HttpRequestParser::COMPLETE);
+    CHECK(parser.target() == "/a");
+    CHECK(parser.body() == "abc");
+    start += parser.requestLength();
+
+    parser.reset();
+    CHECK(parser.parse(buffer, start) == HttpRequestParser::COMPLETE);
+    CHECK(parser.target() == "/b");
+    CHECK(parser.body() == "xy");
+    CHECK(parser.requestLength() == second.size());
+    start += parser.requestLength();
+
+    parser.reset();
+    CHECK(parser.parse(buffer, start) == HttpRequestParser::COMPLETE);
+    CHECK(parser.method() == "GET");
+    CHECK(parser.target() == "/c");
+    CHECK(parser.keepAlive());
+}
+
+static void oversizedChunkSizeLineIsRejected() {
+    // A size line padded with extensions must not buffer without bound
+    std::string request = "POST /x HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n5;" + std::string(70000, 'x');
+    HttpRequestParser parser;
+    std::string buffer = request;
+    CHECK(parser.parse(buffer) == HttpRequestParser::ERROR);
+    CHECK(parser.error() == 400);
+
+    // Same line, complete but too long
+    HttpRequestParser complete;
+    buffer = request + "\r\nhello\r\n0\r\n\r\n";
+    CHECK(complete.parse(buffer) == HttpRequestParser::ERROR);
+}
+
+static void bodyLimitsAreEnforced() {
+    HttpRequestParser parser(16);
+    std::string buffer = "POST /x HTTP/1.1\r\nContent-Length: 17\r\n\r\n";
+    CHECK(parser.parse(buffer) == HttpRequestParser::ERROR);
+    CHECK(parser.error() == 413);
+
+    HttpRequestParser chunked(16);
+    buffer = "POST /x HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n10\r\n0123456789abcdef\r\n1\r\n";
+    CHECK(chunked.parse(buffer) == HttpRequestParser::ERROR);
+    CHECK(chunked.error() == 413);
+
+    HttpRequestParser malformed;
+    buffer = "POST /x HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\nzz\r\n";
+    CHECK(malformed.parse(buffer) == HttpRequestParser::ERROR);
+    CHECK(malformed.error() == 400);
+}
+
+int main() {
+    std::printf("http_parser\n");
+    RUN_TEST(chunkedBodyIsDecodedInPlace);
+    RUN_TEST(chunkedBodyArrivingByteByByte);
+    RUN_TEST(pipelinedRequestsParseOneAfterAnother);
+    RUN_TEST(oversizedChunkSizeLineIsRejected);
+    RUN_TEST(bodyLimitsAreEnforced);
+    return testResult();
+}
@@ -0,0 +1,160 @@
+// Write-ahead journal: replay, torn tails and rotation
+#include <csignal>
+#include <sys/resource.h>
+#include "customer_journal.hpp"
+#include "test_support.hpp"
+
+static JournalRecord upsert(const std::string& id, double aov) {
+    JournalRecord record;
+    record.id = id;
+    record.name = "Customer " + id;
+    record.averagePurchaseValue = aov;
+    record.purchaseFrequency = 2;
+    record.customerLifespan = 3;
+    return record;
+}
+
+static std::vector<JournalRecord> replayAll(const std::string& path) {
+    std::vector<JournalRecord> records;
+    CustomerJournal::replay(path, [&](const JournalRecord& record) { records.push_back(record); });
+    return records;
+}
+
+static off_t fileSize(const std::string& path) {
+    struct stat info;
+    return ::stat(path.c_str(), &info) == 0 ? info.st_size : -1;
+}
+
+static void recordsReplayInOrder() {
+    TempDir dir;
+    std::string path = dir.path("customers.journal");
+    {
+        CustomerJournal journal;
+        CHECK(journal.open(path, CustomerJournal::SYNC_ALWAYS));
+        CHECK(journal.append(upsert("a", 10)));
+        JournalRecord remove;
+        remove.op = JournalRecord::REMOVE;
+        remove.id = "a";
+        CHECK(journal.append(std::vector<JournalRecord>{upsert("b", 20), remove}));
+        JournalRecord model;
+        model.op = JournalRecord::SET_MODEL;
+        model.name = "margin";
+        model.modelMargin = 0.4;
+        model.modelDiscountRate = 0.1;
+        CHECK(journal.append(model));
+    }
+    std::vector<JournalRecord> records = replayAll(path);
+    CHECK(records.size() == 4);
+    if (records.size() != 4) return;
+    CHECK(records[0].op == JournalRecord::UPSERT && records[0].id == "a" && records[0].averagePurchaseValue == 10);
+    CHECK(records[1].id == "b" && records[1].name == "Customer b" && records[1].customerLifespan == 3);
+    CHECK(records[2].op == JournalRecord::REMOVE && records[2].id == "a");
+    CHECK(records[3].op == JournalRecord::SET_MODEL && records[3].name == "margin" && records[3].modelMargin == 0.4);
+}
+
+static void truncatedTailIsCutOff() {
+    TempDir dir;
+    std::string path = dir.path("customers.journal");
+    off_t intact = 0;
+    {
+        CustomerJournal journal;
+        CHECK(journal.open(path, CustomerJournal::SYNC_NONE));
+        for (int i = 0; i < 5; i++) CHECK(journal.append(upsert("c" + std::to_string(i), i + 1)));
+        intact = journal.size();
+        CHECK(journal.append(upsert("torn", 99)));
+    }
+    // A crash in the middle of the last write leaves part of its frame behind
+    CHECK(::truncate(path.c_str(), fileSize(path) - 7) == 0);
+
+    std::vector<JournalRecord> records = replayAll(path);
+    CHECK(records.size() == 5);
+    CHECK(!records.empty() && records.back().id == "c4");
+    CHECK(fileSize(path) == intact);  // Cut back to the last record boundary
+
+    // Appends continue cleanly after the cut
+    {
+        CustomerJournal journal;
+        CHECK(journal.open(path, CustomerJournal::SYNC_NONE));
+        CHECK(journal.append(upsert("after", 7)));
+    }
+    records = replayAll(path);
+    CHECK(records.size() == 6);
+    CHECK(!records.empty() && records.back().id == "after");
+}
+
+static void corruptRecordStopsReplay() {
+    TempDir dir;
+    std::string path = dir.path("customers.journal");
+    {
+        CustomerJournal journal;
+        CHECK(journal.open(path, CustomerJournal::SYNC_NONE));
+        for (int i = 0; i < 3; i++) CHECK(journal.append(upsert("c" + std::to_string(i), i + 1)));
+    }
+    // Flip a payload byte of the last record: its checksum no longer matches
+    int fd = ::open(path.c_str(), O_RDWR);
+    char byte = 0;
+    CHECK(::pread(fd, &byte, 1, fileSize(path) - 3) == 1);
+    byte ^= 0x55;
+    CHECK(::pwrite(fd, &byte, 1, fileSize(path) - 3) == 1);
+    ::close(fd);
+
+    CHECK(replayAll(path).size() == 2);
+}
+
+static void failedWriteLeavesNoFragment() {
+    TempDir dir;
+    std::string path = dir.path("customers.journal");
+    CustomerJournal journal;
+    CHECK(journal.open(path, CustomerJournal::SYNC_NONE));
+    CHECK(journal.append(upsert("first", 1)));
+    off_t intact = fileSize(path);
+
+    // A file size limit just past the end makes the next write stop partway, like a full disk
+    std::signal(SIGXFSZ, SIG_IGN);
+    struct rlimit saved;
+    CHECK(::getrlimit(RLIMIT_FSIZE, &saved) == 0);
+    struct rlimit limit = saved;
+    limit.rlim_cur = intact + 10;
+    CHECK(::setrlimit(RLIMIT_FSIZE, &limit) == 0);
+    bool written = journal.append(std::vector<JournalRecord>{upsert("lost", 2), upsert("lost too", 3)});
+    CHECK(::setrlimit(RLIMIT_FSIZE, &saved) == 0);
+    std::signal(SIGXFSZ, SIG_DFL);
+
+    CHECK(!written);
+    CHECK(fileSize(path) == intact);
+    CHECK(journal.size() == static_cast<uint64_t>(intact));
+
+    // Records acknowledged after the failure survive replay
+    CHECK(journal.append(upsert("second", 4)));
+    journal.close();
+    std::vector<JournalRecord> records = replayAll(path);
+    CHECK(records.size() == 2);
+    CHECK(records.size() == 2 && records[0].id == "first" && records[1].id == "second");
+}
+
+static void rotationSplitsTheLog() {
+    TempDir dir;
+    std::string path = dir.path("customers.journal");
+    CustomerJournal journal;
+    CHECK(journal.open(path, CustomerJournal::SYNC_GROUP));
+    CHECK(journal.append(upsert("before", 1)));
+    CHECK(journal.rotate(dir.path("customers.journal.1")));
+    CHECK(journal.size() == 0);
+    CHECK(journal.append(upsert("after", 2)));
+    journal.close();
+
+    std::vector<JournalRecord> rotated = replayAll(dir.path("customers.journal.1"));
+    std::vector<JournalRecord> live = replayAll(path);
+    CHECK(rotated.size() == 1 && rotated[0].id == "before");
+    CHECK(live.size() == 1 && live[0].id == "after");
+}
+
+int main() {
+    std::printf("journal\n");
+    RUN_TEST(recordsReplayInOrder);
+    RUN_TEST(truncatedTailIsCutOff);
+    RUN_TEST(corruptRecordStopsReplay);
+    RUN_TEST(failedWriteLeavesNoFragment);
+    RUN_TEST(rotationSplitsTheLog);
+    return testResult();
+}
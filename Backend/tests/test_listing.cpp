@@ -0,0 +1,100 @@
+// Paged listings: cursor paging over runs of equal CLVs
+#include <algorithm>
+#include "clv_calculator.hpp"
+#include "test_support.hpp"
+
+// Many customers share each CLV, so every page boundary falls inside a tie
+static void fillWithTies(CLVCalculator& calculator) {
+    calculator.setVerbose(false);
+    for (int i = 0; i < 400; i++) {
+        char id[16];
+        std::snprintf(id, sizeof(id), "C%03d", (i * 37) % 400);  // Insertion order differs from ID order
+        calculator.addCustomer(id, "Name", 10 * (1 + i % 5), 1, 1);
+    }
+}
+
+// Expected descending listing: CLV descending, equal CLVs by ascending ID (the leaderboard order)
+static std::vector<Customer> expectedOrder(CLVCalculator& calculator) {
+    std::vector<Customer> all;
+    calculator.forEachCustomer([&](const Customer& customer) { all.push_back(customer); });
+    std::sort(all.begin(), all.end(), [](const Customer& a, const Customer& b) {
+        return a.clv != b.clv ? a.clv > b.clv : a.id < b.id;
+    });
+    return all;
+}
+
+static void cursorPagingVisitsEveryCustomerOnce() {
+    CLVCalculator calculator;
+    fillWithTies(calculator);
+    std::vector<Customer> expected = expectedOrder(calculator);
+
+    for (size_t limit : {1, 7, 80, 1000}) {
+        CustomerListQuery query;
+        query.limit = limit;
+        std::vector<Customer> seen;
+        while (true) {
+            std::optional<CustomerPage> page = calculator.listCustomers(query);
+            CHECK(page.has_value());
+            if (!page) break;
+            seen.insert(seen.end(), page->customers.begin(), page->customers.end());
+            if (page->nextCursor.empty()) break;
+            query.cursor = page->nextCursor;
+        }
+        CHECK(seen.size() == expected.size());
+        bool same = seen.size() == expected.size();
+        for (size_t i = 0; same && i < seen.size(); i++) same = seen[i].id == expected[i].id;
+        CHECK(same);
+    }
+}
+
+static void ascendingPagingMirrorsDescending() {
+    CLVCalculator calculator;
+    fillWithTies(calculator);
+    CustomerListQuery query;
+    query.descending = false;
+    query.limit = 33;
+    std::vector<Customer> seen;
+    while (true) {
+        std::optional<CustomerPage> page = calculator.listCustomers(query);
+        if (!page) break;
+        seen.insert(seen.end(), page->customers.begin(), page->customers.end());
+        if (page->nextCursor.empty()) break;
+        query.cursor = page->nextCursor;
+    }
+    CHECK(seen.size() == 400);
+    bool ordered = true;
+    for (size_t i = 1; i < seen.size(); i++) {
+        const Customer& a = seen[i - 1];
+        const Customer& b = seen[i];
+        ordered = ordered && (a.clv < b.clv || (a.clv == b.clv && a.id > b.id));  // Exact reverse of descending
+    }
+    CHECK(ordered);
+}
+
+static void cursorSurvivesChangesBetweenPages() {
+    CLVCalculator calculator;
+    fillWithTies(calculator);
+    CustomerListQuery query;
+    query.limit = 50;
+    std::optional<CustomerPage> first = calculator.listCustomers(query);
+    CHECK(first && !first->nextCursor.empty());
+    if (!first) return;
+
+    // The customer the cursor points at is deleted; paging continues after its place
+    calculator.removeCustomer(first->customers.back().id);
+    query.cursor = first->nextCursor;
+    std::optional<CustomerPage> second = calculator.listCustomers(query);
+    CHECK(second && !second->customers.empty());
+    if (!second || second->customers.empty()) return;
+    const Customer& last = first->customers.back();
+    const Customer& next = second->customers.front();
+    CHECK(next.clv < last.clv || (next.clv == last.clv && next.id > last.id));
+}
+
+int main() {
+    std::printf("listing\n");
+    RUN_TEST(cursorPagingVisitsEveryCustomerOnce);
+    RUN_TEST(ascendingPagingMirrorsDescending);
+    RUN_TEST(cursorSurvivesChangesBetweenPages);
+    return testResult();
+}
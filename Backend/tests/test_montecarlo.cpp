@@ -0,0 +1,79 @@
+// Seeded Monte Carlo bands: reproducible and independent of the thread count
+#include "clv_calculator.hpp"
+#include "test_support.hpp"
+
+static bool sameInterval(const CLVInterval& a, const CLVInterval& b) {
+    return a.mean == b.mean && a.p5 == b.p5 && a.p50 == b.p50 && a.p95 == b.p95;
+}
+
+static void fill(CLVCalculator& calculator) {
+    calculator.setVerbose(false);
+    // More customers than one task-pool chunk, so several chunks run in parallel
+    for (int i = 0; i < 5000; i++) {
+        calculator.addCustomer("C" + std::to_string(i), "Name", 20 + i % 97, 1 + i % 11, 1 + i % 4);
+    }
+}
+
+static void identicalAtEveryThreadCount() {
+    CLVCalculator calculator;
+    fill(calculator);
+    MonteCarloSettings settings;
+    settings.draws = 101;
+    settings.seed = 2024;
+    settings.frequency.distribution = InputDistribution::NORMAL;
+    settings.lifespan.distribution = InputDistribution::UNIFORM;
+    CLVModel model;
+    model.kind = CLVModelKind::DISCOUNTED;
+
+    TaskPool single(1);
+    calculator.setTaskPool(single);
+    std::vector<CLVInterval> reference;
+    CLVInterval referenceTotal = calculator.simulateCLV(settings, model, &reference);
+
+    for (size_t threads : {2, 4, 7}) {
+        TaskPool pool(threads);
+        calculator.setTaskPool(pool);
+        std::vector<CLVInterval> perCustomer;
+        CLVInterval total = calculator.simulateCLV(settings, model, &perCustomer);
+        CHECK(sameInterval(total, referenceTotal));
+        bool same = perCustomer.size() == reference.size();
+        for (size_t i = 0; same && i < perCustomer.size(); i++) same = sameInterval(perCustomer[i], reference[i]);
+        CHECK(same);
+    }
+    calculator.setTaskPool(TaskPool::shared());
+}
+
+static void customerBandFollowsItsId() {
+    CLVCalculator calculator;
+    fill(calculator);
+    MonteCarloSettings settings;
+    settings.draws = 64;
+    CLVModel model;
+
+    std::optional<CLVInterval> before = calculator.simulateCustomer("C4999", settings, model);
+    calculator.removeCustomer("C0");  // Moves C4999 into row 0
+    std::optional<CLVInterval> after = calculator.simulateCustomer("C4999", settings, model);
+    CHECK(before && after && sameInterval(*before, *after));
+
+    settings.seed = 2;
+    std::optional<CLVInterval> reseeded = calculator.simulateCustomer("C4999", settings, model);
+    CHECK(reseeded && before && !sameInterval(*reseeded, *before));
+}
+
+static void zeroVariationGivesThePointEstimate() {
+    CLVCalculator calculator;
+    calculator.setVerbose(false);
+    calculator.addCustomer("A", "A", 10, 2, 3);
+    MonteCarloSettings settings;
+    settings.aov.cv = settings.frequency.cv = settings.lifespan.cv = 0;
+    std::optional<CLVInterval> band = calculator.simulateCustomer("A", settings, CLVModel());
+    CHECK(band && band->mean == 60 && band->p5 == 60 && band->p95 == 60);
+}
+
+int main() {
+    std::printf("montecarlo\n");
+    RUN_TEST(identicalAtEveryThreadCount);
+    RUN_TEST(customerBandFollowsItsId);
+    RUN_TEST(zeroVariationGivesThePointEstimate);
+    return testResult();
+}
@@ -0,0 +1,121 @@
+// CLV order statistics: ranks, k-th highest and range counts over ties
+#include <algorithm>
+#include "clv_calculator.hpp"
+#include "test_support.hpp"
+
+// 400 customers in five runs of 80 equal CLVs, inserted out of ID order
+static void fillWithTies(CLVCalculator& calculator) {
+    calculator.setVerbose(false);
+    for (int i = 0; i < 400; i++) {
+        char id[16];
+        std::snprintf(id, sizeof(id), "C%03d", (i * 37) % 400);  // Insertion order differs from ID order
+        calculator.addCustomer(id, "Name", 10 * (1 + i % 5), 1, 1);
+    }
+}
+
+static void equalCLVsShareARank() {
+    CLVCalculator calculator;
+    fillWithTies(calculator);
+    // 80 customers at each CLV 50, 40, 30, 20, 10
+    std::optional<CustomerRank> top = calculator.getCustomerRank("C000");
+    CHECK(top.has_value());
+    if (!top) return;
+    size_t group = static_cast<size_t>(top->customer.clv / 10);
+    CHECK(top->rank == 1 + (5 - group) * 80);
+    CHECK(top->tiedCustomers == 79);
+    CHECK(top->totalCustomers == 400);
+    CHECK(top->percentile == 100.0 * (group - 1) * 80 / 400);
+    CHECK(!calculator.getCustomerRank("missing"));
+}
+
+static void kthHighestFollowsTheLeaderboard() {
+    CLVCalculator calculator;
+    fillWithTies(calculator);
+    // Leaderboard order: CLV descending, equal CLVs by ascending ID
+    std::vector<Customer> leaderboard;
+    calculator.forEachCustomer([&](const Customer& customer) { leaderboard.push_back(customer); });
+    std::sort(leaderboard.begin(), leaderboard.end(), [](const Customer& a, const Customer& b) {
+        return a.clv != b.clv ? a.clv > b.clv : a.id < b.id;
+    });
+    bool same = true;
+    for (size_t k = 1; same && k <= leaderboard.size(); k++) {
+        std::optional<Customer> kth = calculator.getKthHighestCLV(k);
+        same = kth && kth->id == leaderboard[k - 1].id;
+    }
+    CHECK(same);
+
+    calculator.enableLeaderboard(100);
+    std::vector<Customer> top = calculator.getTopCustomers(100);
+    CHECK(top.size() == 100);
+    for (size_t i = 0; i < top.size(); i++) CHECK(top[i].id == leaderboard[i].id);
+
+    CHECK(!calculator.getKthHighestCLV(0));
+    CHECK(!calculator.getKthHighestCLV(401));
+    CHECK(!CLVCalculator().getKthHighestCLV(1));
+}
+
+static void everyTopListBreaksTiesByID() {
+    CLVCalculator calculator;
+    fillWithTies(calculator);
+    std::vector<Customer> selected = calculator.getTopCustomers(100);
+    calculator.enableLeaderboard(100);
+    std::vector<Customer> board = calculator.getTopCustomers(100);
+
+    CustomerListQuery query;
+    query.limit = 100;
+    std::optional<CustomerPage> page = calculator.listCustomers(query);
+
+    Scenario unchanged;
+    ScenarioReport report = calculator.runScenarios({unchanged}, calculator.getModel(), 100);
+
+    CHECK(selected.size() == 100 && board.size() == 100 && page && page->customers.size() == 100);
+    CHECK(report.scenarios.size() == 1 && report.scenarios[0].top.size() == 100);
+    if (selected.size() != 100 || board.size() != 100 || !page || page->customers.size() != 100 ||
+        report.scenarios.size() != 1 || report.scenarios[0].top.size() != 100) {
+        return;
+    }
+    bool same = true;
+    for (size_t i = 0; i < 100; i++) {
+        const std::string& id = board[i].id;
+        same = same && selected[i].id == id && page->customers[i].id == id && report.scenarios[0].top[i].id == id;
+        same = same && calculator.getKthHighestCLV(i + 1)->id == id;
+    }
+    CHECK(same);
+    // The cut at 100 falls inside the second run of 80: it keeps that run's lowest IDs
+    CHECK(board[80].clv == 40 && board[80].id < board[99].id);
+
+    // Small n over a large table takes the per-chunk heap path; all CLVs equal, IDs inserted descending
+    CLVCalculator equal;
+    equal.setVerbose(false);
+    for (int i = 9999; i >= 0; i--) {
+        char id[16];
+        std::snprintf(id, sizeof(id), "E%04d", i);
+        equal.addCustomer(id, "Name", 5, 2, 1);
+    }
+    std::vector<Customer> lowest = equal.getTopCustomers(10);
+    bool ascending = lowest.size() == 10;
+    for (size_t i = 0; ascending && i < lowest.size(); i++) ascending = lowest[i].id == "E000" + std::to_string(i);
+    CHECK(ascending);
+}
+
+static void rangeCountsIncludeBothBounds() {
+    CLVCalculator calculator;
+    fillWithTies(calculator);
+    // 80 customers at each CLV 10, 20, 30, 40, 50
+    CHECK(calculator.countCustomersInCLVRange(20, 40) == 240);
+    CHECK(calculator.countCustomersInCLVRange(20, 20) == 80);
+    CHECK(calculator.countCustomersInCLVRange(20.5, 39.5) == 80);
+    CHECK(calculator.countCustomersInCLVRange(21, 29) == 0);
+    CHECK(calculator.countCustomersInCLVRange(-1e300, 1e300) == 400);
+    CHECK(calculator.countCustomersInCLVRange(50, 10) == 0);
+    CHECK(calculator.countCustomersInCLVRange(60, 100) == 0);
+}
+
+int main() {
+    std::printf("ranking\n");
+    RUN_TEST(equalCLVsShareARank);
+    RUN_TEST(kthHighestFollowsTheLeaderboard);
+    RUN_TEST(everyTopListBreaksTiesByID);
+    RUN_TEST(rangeCountsIncludeBothBounds);
+    return testResult();
+}
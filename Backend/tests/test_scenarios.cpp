@@ -0,0 +1,46 @@
+// What-if scenario requests: parsing and rejection of bad bodies
+#include "clv_calculator.hpp"
+#include "test_support.hpp"
+
+static void requestIsParsed() {
+    std::vector<Scenario> scenarios;
+    size_t top = 0;
+    std::string body = "{\"top\": 3, \"note\": {\"any\": [1, \"two\", null]},"
+                       " \"scenarios\": [{\"name\": \"loyal\", \"minFrequency\": 4, \"lifespanChange\": 0.5}, {}]}";
+    CHECK(parseScenarioRequest(body, scenarios, top).empty());
+    CHECK(top == 3);
+    CHECK(scenarios.size() == 2);
+    if (scenarios.size() != 2) return;
+    CHECK(scenarios[0].name == "loyal" && scenarios[0].filter.minFrequency == 4 && scenarios[0].lifespanFactor == 1.5);
+    CHECK(scenarios[1].name == "scenario 2");
+}
+
+static void badRequestsAreRejected() {
+    std::vector<Scenario> scenarios;
+    size_t top = 0;
+    CHECK(!parseScenarioRequest("", scenarios, top).empty());
+    CHECK(!parseScenarioRequest("{\"scenarios\": []}", scenarios, top).empty());
+    CHECK(!parseScenarioRequest("{\"scenarios\": [{\"aovChange\": -1}]}", scenarios, top).empty());
+    CHECK(!parseScenarioRequest("{\"scenarios\": [{\"bogus\": 1}]}", scenarios, top).empty());
+    CHECK(!parseScenarioRequest("{\"top\": 1.5, \"scenarios\": [{}]}", scenarios, top).empty());
+}
+
+static void deeplyNestedBodyIsRejected() {
+    // Unknown top-level keys are skipped; this used to overflow the stack
+    std::string body = "{\"x\": " + std::string(2 << 20, '[');
+    std::vector<Scenario> scenarios;
+    size_t top = 0;
+    std::string error = parseScenarioRequest(body, scenarios, top);
+    CHECK(error.find("nesting") != std::string::npos);
+
+    std::string nested = "{\"x\": " + std::string(64, '[') + std::string(64, ']') + ", \"scenarios\": [{}]}";
+    CHECK(parseScenarioRequest(nested, scenarios, top).empty());
+}
+
+int main() {
+    std::printf("scenarios\n");
+    RUN_TEST(requestIsParsed);
+    RUN_TEST(badRequestsAreRejected);
+    RUN_TEST(deeplyNestedBodyIsRejected);
+    return testResult();
+}
@@ -0,0 +1,65 @@
+#ifndef TEST_SUPPORT_HPP
+#define TEST_SUPPORT_HPP
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <unistd.h>
+
+// Minimal checks for the header-only tests: each tests/test_*.cpp is its own
+// program, runs its cases from main() and returns testResult(). A failed CHECK
+// reports file:line and the expression, and the run carries on.
+
+inline int& testFailures() {
+    static int failures = 0;
+    return failures;
+}
+
+#define CHECK(condition)                                                                   \
+    do {                                                                                   \
+        if (!(condition)) {                                                                \
+            std::fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #condition); \
+            testFailures()++;                                                              \
+        }                                                                                  \
+    } while (0)
+
+#define RUN_TEST(test)                         \
+    do {                                       \
+        std::printf("  %s\n", #test);          \
+        test();                                \
+    } while (0)
+
+inline int testResult() {
+    if (testFailures() > 0) {
+        std::fprintf(stderr, "%d check(s) failed\n", testFailures());
+        return 1;
+    }
+    return 0;
+}
+
+// Scratch directory, removed with everything in it when the test is done
+class TempDir {
+private:
+    std::string root;
+
+public:
+    TempDir() {
+        char pattern[] = "/tmp/clv-test-XXXXXX";
+        const char* created = mkdtemp(pattern);
+        root = created ? created : "/tmp";
+    }
+
+    ~TempDir() {
+        if (root != "/tmp") {
+            std::string command = "rm -rf '" + root + "'";
+            if (std::system(command.c_str()) != 0) std::fprintf(stderr, "could not remove %s\n", root.c_str());
+        }
+    }
+
+    TempDir(const TempDir&) = delete;
+    TempDir& operator=(const TempDir&) = delete;
+
+    std::string path(const std::string& name) const { return root + "/" + name; }
+};
+
+#endif // TEST_SUPPORT_HPP
@@ -0,0 +1,99 @@
+#ifndef WORKER_POOL_HPP
+#define WORKER_POOL_HPP
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads fed from a bounded job queue.
+// submit() blocks while the queue is full, so a producer that outruns the
+// workers is slowed down instead of growing the queue without limit.
+class WorkerPool {
+private:
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> jobs;
+    size_t capacity;
+    bool stopping;
+    std::mutex mutex;
+    std::condition_variable jobAvailable;
+    std::condition_variable spaceAvailable;
+
+    void workerLoop() {
+        while (true) {
+            std::function<void()> job;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                jobAvailable.wait(lock, [this] { return stopping || !jobs.empty(); });
+                if (jobs.empty()) return;  // stopping and fully drained
+                job = std::move(jobs.front());
+                jobs.pop_front();
+            }
+            spaceAvailable.notify_one();
+            job();
+        }
+    }
+
+public:
+    WorkerPool(size_t threadCount, size_t queueCapacity)
+        : capacity(queueCapacity > 0 ? queueCapacity : 1),
+          stopping(false) {
+        if (threadCount == 0) threadCount = 1;
+        workers.reserve(threadCount);
+        for (size_t i = 0; i < threadCount; i++) {
+            workers.emplace_back(&WorkerPool::workerLoop, this);
+        }
+    }
+
+    ~WorkerPool() {
+        stop();
+    }
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    // Queue a job, waiting for space if the queue is full. Returns false once stopped.
+    bool submit(std::function<void()> job) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            spaceAvailable.wait(lock, [this] { return stopping || jobs.size() < capacity; });
+            if (stopping) return false;
+            jobs.push_back(std::move(job));
+        }
+        jobAvailable.notify_one();
+        return true;
+    }
+
+    // Queue a job only if there is room right now
+    bool trySubmit(std::function<void()> job) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (stopping || jobs.size() >= capacity) return false;
+            jobs.push_back(std::move(job));
+        }
+        jobAvailable.notify_one();
+        return true;
+    }
+
+    size_t threadCount() const {
+        return workers.size();
+    }
+
+    // Finish queued jobs and join all workers
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (stopping) return;
+            stopping = true;
+        }
+        jobAvailable.notify_all();
+        spaceAvailable.notify_all();
+        for (auto& worker : workers) {
+            if (worker.joinable()) worker.join();
+        }
+    }
+};
+
+#endif // WORKER_POOL_HPP